@@ -36,7 +36,7 @@ static void prv_handleResponse(lwm2m_server_t * bootstrapServer,
     {
         LOG("Received ACK/2.04, Bootstrap pending, waiting for DEL/PUT from BS server...");
         bootstrapServer->status = STATE_BS_PENDING;
-        bootstrapServer->registration = lwm2m_gettime() + COAP_EXCHANGE_LIFETIME;
+        bootstrapServer->registration = utils_gettime() + COAP_EXCHANGE_LIFETIME;
     }
     else
     {
@@ -103,7 +103,7 @@ static void prv_requestBootstrap(lwm2m_context_t * context,
 
         LOG("Bootstrap server connection opened");
 
-        transaction = transaction_new(bootstrapServer->sessionH, COAP_POST, NULL, NULL, context->nextMID++, 4, NULL);
+        transaction = transaction_new(context, bootstrapServer->sessionH, COAP_POST, NULL, NULL, context->nextMID++, 4, NULL);
         if (transaction == NULL)
         {
             bootstrapServer->status = STATE_BS_FAILING;
@@ -114,7 +114,7 @@ static void prv_requestBootstrap(lwm2m_context_t * context,
         coap_set_header_uri_query(transaction->message, query);
         transaction->callback = prv_handleBootstrapReply;
         transaction->userData = (void *)bootstrapServer;
-        context->transactionList = (lwm2m_transaction_t *)LWM2M_LIST_ADD(context->transactionList, transaction);
+        transaction_add(context, transaction);
         if (transaction_send(context, transaction) == 0)
         {
             LOG("CI bootstrap requested to BS server");
@@ -317,7 +317,7 @@ static uint8_t prv_checkServerStatus(lwm2m_server_t * serverP)
     case STATE_DEREGISTERED:
         // server initiated bootstrap
     case STATE_BS_PENDING:
-        serverP->registration = lwm2m_gettime() + COAP_EXCHANGE_LIFETIME;
+        serverP->registration = utils_gettime() + COAP_EXCHANGE_LIFETIME;
         break;
 
     case STATE_BS_FINISHED:
@@ -667,13 +667,13 @@ int lwm2m_bootstrap_delete(lwm2m_context_t * contextP,
     bs_data_t * dataP;
 
     LOG_URI(uriP);
-    transaction = transaction_new(sessionH, COAP_DELETE, NULL, uriP, contextP->nextMID++, 4, NULL);
+    transaction = transaction_new(contextP, sessionH, COAP_DELETE, NULL, uriP, contextP->nextMID++, 4, NULL);
     if (transaction == NULL) return COAP_500_INTERNAL_SERVER_ERROR;
 
     dataP = (bs_data_t *)lwm2m_malloc(sizeof(bs_data_t));
     if (dataP == NULL)
     {
-        transaction_free(transaction);
+        transaction_free(contextP, transaction);
         return COAP_500_INTERNAL_SERVER_ERROR;
     }
     if (uriP == NULL)
@@ -690,7 +690,7 @@ int lwm2m_bootstrap_delete(lwm2m_context_t * contextP,
     transaction->callback = prv_resultCallback;
     transaction->userData = (void *)dataP;
 
-    contextP->transactionList = (lwm2m_transaction_t *)LWM2M_LIST_ADD(contextP->transactionList, transaction);
+    transaction_add(contextP, transaction);
 
     return transaction_send(contextP, transaction);
 }
@@ -713,7 +713,7 @@ int lwm2m_bootstrap_write(lwm2m_context_t * contextP,
         return COAP_400_BAD_REQUEST;
     }
 
-    transaction = transaction_new(sessionH, COAP_PUT, NULL, uriP, contextP->nextMID++, 4, NULL);
+    transaction = transaction_new(contextP, sessionH, COAP_PUT, NULL, uriP, contextP->nextMID++, 4, NULL);
     if (transaction == NULL) return COAP_500_INTERNAL_SERVER_ERROR;
 
     coap_set_header_content_type(transaction->message, format);
@@ -722,7 +722,7 @@ int lwm2m_bootstrap_write(lwm2m_context_t * contextP,
     dataP = (bs_data_t *)lwm2m_malloc(sizeof(bs_data_t));
     if (dataP == NULL)
     {
-        transaction_free(transaction);
+        transaction_free(contextP, transaction);
         return COAP_500_INTERNAL_SERVER_ERROR;
     }
     memcpy(&dataP->uri, uriP, sizeof(lwm2m_uri_t));
@@ -732,7 +732,7 @@ int lwm2m_bootstrap_write(lwm2m_context_t * contextP,
     transaction->callback = prv_resultCallback;
     transaction->userData = (void *)dataP;
 
-    contextP->transactionList = (lwm2m_transaction_t *)LWM2M_LIST_ADD(contextP->transactionList, transaction);
+    transaction_add(contextP, transaction);
 
     return transaction_send(contextP, transaction);
 }
@@ -744,7 +744,7 @@ int lwm2m_bootstrap_finish(lwm2m_context_t * contextP,
     bs_data_t * dataP;
 
     LOG("Entering");
-    transaction = transaction_new(sessionH, COAP_POST, NULL, NULL, contextP->nextMID++, 4, NULL);
+    transaction = transaction_new(contextP, sessionH, COAP_POST, NULL, NULL, contextP->nextMID++, 4, NULL);
     if (transaction == NULL) return COAP_500_INTERNAL_SERVER_ERROR;
 
     coap_set_header_uri_path(transaction->message, "/"URI_BOOTSTRAP_SEGMENT);
@@ -752,7 +752,7 @@ int lwm2m_bootstrap_finish(lwm2m_context_t * contextP,
     dataP = (bs_data_t *)lwm2m_malloc(sizeof(bs_data_t));
     if (dataP == NULL)
     {
-        transaction_free(transaction);
+        transaction_free(contextP, transaction);
         return COAP_500_INTERNAL_SERVER_ERROR;
     }
     LWM2M_URI_RESET(&dataP->uri);
@@ -762,7 +762,7 @@ int lwm2m_bootstrap_finish(lwm2m_context_t * contextP,
     transaction->callback = prv_resultCallback;
     transaction->userData = (void *)dataP;
 
-    contextP->transactionList = (lwm2m_transaction_t *)LWM2M_LIST_ADD(contextP->transactionList, transaction);
+    transaction_add(contextP, transaction);
 
     return transaction_send(contextP, transaction);
 }
@@ -60,13 +60,6 @@
 #define PRINTLLADDR(addr)
 #endif
 
-/*-----------------------------------------------------------------------------------*/
-/*- Variables -----------------------------------------------------------------------*/
-/*-----------------------------------------------------------------------------------*/
-static uint16_t current_mid = 0;
-
-coap_status_t coap_error_code = NO_ERROR;
-const char *coap_error_message = "";
 /*-----------------------------------------------------------------------------------*/
 /*- LOCAL HELP FUNCTIONS ------------------------------------------------------------*/
 /*-----------------------------------------------------------------------------------*/
@@ -117,6 +110,20 @@ coap_option_nibble(unsigned int value)
 /*-----------------------------------------------------------------------------------*/
 static
 size_t
+coap_get_option_header_len(unsigned int delta, size_t length)
+{
+  size_t len = 1;
+
+  if (delta>268) len += 2;
+  else if (delta>12) len += 1;
+  if (length>268) len += 2;
+  else if (length>12) len += 1;
+
+  return len;
+}
+/*-----------------------------------------------------------------------------------*/
+static
+size_t
 coap_set_option_header(unsigned int delta, size_t length, uint8_t *buffer)
 {
   size_t written = 0;
@@ -144,9 +151,10 @@ coap_set_option_header(unsigned int delta, size_t length, uint8_t *buffer)
   return ++written;
 }
 /*-----------------------------------------------------------------------------------*/
+/* The serialization functions return 0 if the option does not fit in the available bytes */
 static
 size_t
-coap_serialize_int_option(unsigned int number, unsigned int current_number, uint8_t *buffer, uint32_t value)
+coap_serialize_int_option(unsigned int number, unsigned int current_number, uint8_t *buffer, size_t available, uint32_t value)
 {
   size_t i = 0;
 
@@ -155,6 +163,8 @@ coap_serialize_int_option(unsigned int number, unsigned int current_number, uint
   if (0xFFFFFF00 & value) ++i;
   if (0xFFFFFFFF & value) ++i;
 
+  if (coap_get_option_header_len(number - current_number, i) + i > available) return 0;
+
   PRINTF("OPTION %u (delta %u, len %u)\n", number, number - current_number, i);
 
   i = coap_set_option_header(number - current_number, i, buffer);
@@ -169,7 +179,7 @@ coap_serialize_int_option(unsigned int number, unsigned int current_number, uint
 /*-----------------------------------------------------------------------------------*/
 static
 size_t
-coap_serialize_array_option(unsigned int number, unsigned int current_number, uint8_t *buffer, uint8_t *array, size_t length, char split_char)
+coap_serialize_array_option(unsigned int number, unsigned int current_number, uint8_t *buffer, size_t available, uint8_t *array, size_t length, char split_char)
 {
   size_t i = 0;
 
@@ -187,6 +197,8 @@ coap_serialize_array_option(unsigned int number, unsigned int current_number, ui
         part_end = array + j;
         temp_length = part_end-part_start;
 
+        if (i + coap_get_option_header_len(number - current_number, temp_length) + temp_length > available) return 0;
+
         i += coap_set_option_header(number - current_number, temp_length, &buffer[i]);
         memcpy(&buffer[i], part_start, temp_length);
         i += temp_length;
@@ -201,6 +213,8 @@ coap_serialize_array_option(unsigned int number, unsigned int current_number, ui
   }
   else
   {
+    if (coap_get_option_header_len(number - current_number, length) + length > available) return 0;
+
     i += coap_set_option_header(number - current_number, length, &buffer[i]);
     memcpy(&buffer[i], array, length);
     i += length;
@@ -213,13 +227,15 @@ coap_serialize_array_option(unsigned int number, unsigned int current_number, ui
 /*-----------------------------------------------------------------------------------*/
 static
 size_t
-coap_serialize_multi_option(unsigned int number, unsigned int current_number, uint8_t *buffer, multi_option_t *array)
+coap_serialize_multi_option(unsigned int number, unsigned int current_number, uint8_t *buffer, size_t available, multi_option_t *array)
 {
   size_t i = 0;
   multi_option_t * j;
 
   for (j = array; j != NULL; j= j->next)
   {
+     if (i + coap_get_option_header_len(number - current_number, j->len) + j->len > available) return 0;
+
      i += coap_set_option_header(number - current_number, j->len, &buffer[i]);
      current_number = number;
      memcpy(&buffer[i], j->data, j->len);
@@ -253,6 +269,50 @@ coap_merge_multi_option(uint8_t **dst, size_t *dst_len, uint8_t *option, size_t
   }
 }
 
+static
+void
+coap_append_multi_option(multi_option_t **dst, multi_option_t *opt)
+{
+  if (*dst)
+  {
+    multi_option_t * i = *dst;
+    while (i->next)
+    {
+      i = i->next;
+    }
+    i->next = opt;
+  }
+  else
+  {
+    *dst = opt;
+  }
+}
+
+/* Adds an option pointing into the parsed buffer without allocation when possible */
+static
+void
+coap_add_parsed_option(coap_packet_t *coap_pkt, multi_option_t **dst, uint8_t *option, size_t option_len)
+{
+  multi_option_t *opt;
+
+  if (coap_pkt->parsed_options_count >= COAP_PARSED_OPTIONS_MAX)
+  {
+    coap_add_multi_option(dst, option, option_len, 1);
+    return;
+  }
+
+  opt = coap_pkt->parsed_options + coap_pkt->parsed_options_count;
+  coap_pkt->parsed_options_count++;
+
+  opt->next = NULL;
+  opt->is_static = 1;
+  opt->is_inline = 1;
+  opt->len = (uint8_t)option_len;
+  opt->data = option;
+
+  coap_append_multi_option(dst, opt);
+}
+
 void
 coap_add_multi_option(multi_option_t **dst, uint8_t *option, size_t option_len, uint8_t is_static)
 {
@@ -261,6 +321,7 @@ coap_add_multi_option(multi_option_t **dst, uint8_t *option, size_t option_len,
   if (opt)
   {
     opt->next = NULL;
+    opt->is_inline = 0;
     opt->len = (uint8_t)option_len;
     if (is_static)
     {
@@ -279,19 +340,7 @@ coap_add_multi_option(multi_option_t **dst, uint8_t *option, size_t option_len,
         memcpy(opt->data, option, option_len);
     }
 
-    if (*dst)
-    {
-      multi_option_t * i = *dst;
-      while (i->next)
-      {
-        i = i->next;
-      }
-      i->next = opt;
-    }
-    else
-    {
-      *dst = opt;
-    }
+    coap_append_multi_option(dst, opt);
   }
 }
 
@@ -306,7 +355,10 @@ free_multi_option(multi_option_t *dst)
     {
         lwm2m_free(dst->data);
     }
-    lwm2m_free(dst);
+    if (dst->is_inline == 0)
+    {
+        lwm2m_free(dst);
+    }
     free_multi_option(n);
   }
 }
@@ -379,12 +431,6 @@ coap_get_variable(const uint8_t *buffer, size_t length, const char *name, const
   return 0;
 }
 
-/*-----------------------------------------------------------------------------------*/
-uint16_t
-coap_get_mid()
-{
-  return ++current_mid;
-}
 /*-----------------------------------------------------------------------------------*/
 /*- MEASSAGE PROCESSING -------------------------------------------------------------*/
 /*-----------------------------------------------------------------------------------*/
@@ -525,12 +571,14 @@ size_t coap_serialize_get_size(void *packet)
 
 /*-----------------------------------------------------------------------------------*/
 size_t
-coap_serialize_message(void *packet, uint8_t *buffer)
+coap_serialize_message(void *packet, uint8_t *buffer, size_t buffer_len)
 {
   coap_packet_t *const coap_pkt = (coap_packet_t *) packet;
   uint8_t *option;
   unsigned int current_number = 0;
 
+  if ((size_t)COAP_HEADER_LEN + coap_pkt->token_len > buffer_len) return 0;
+
   /* Initialize */
   coap_pkt->buffer = buffer;
   coap_pkt->version = 1;
@@ -583,6 +631,12 @@ coap_serialize_message(void *packet, uint8_t *buffer)
 
   PRINTF("-Done serializing at %p----\n", option);
 
+  if (coap_pkt->payload_len
+   && (size_t)(option - buffer) + 1 + coap_pkt->payload_len > buffer_len)
+  {
+    return 0;
+  }
+
   /* Free allocated header fields */
   coap_free_header(packet);
 
@@ -637,7 +691,7 @@ coap_parse_message(void *packet, uint8_t *data, uint16_t data_len)
 
   if (coap_pkt->version != 1)
   {
-    coap_error_message = "CoAP version must be 1";
+    coap_pkt->error_message = "CoAP version must be 1";
     return BAD_REQUEST_4_00;
   }
 
@@ -777,18 +831,18 @@ coap_parse_message(void *packet, uint8_t *data, uint16_t data_len)
       case COAP_OPTION_URI_PATH:
         /* coap_merge_multi_option() operates in-place on the IPBUF, but final packet field should be const string -> cast to string */
         // coap_merge_multi_option( (char **) &(coap_pkt->uri_path), &(coap_pkt->uri_path_len), current_option, option_length, 0);
-        coap_add_multi_option( &(coap_pkt->uri_path), current_option, option_length, 1);
+        coap_add_parsed_option(coap_pkt, &(coap_pkt->uri_path), current_option, option_length);
         PRINTF("Uri-Path [%.*s]\n", option_length, current_option);
         break;
       case COAP_OPTION_URI_QUERY:
         /* coap_merge_multi_option() operates in-place on the IPBUF, but final packet field should be const string -> cast to string */
         // coap_merge_multi_option( (char **) &(coap_pkt->uri_query), &(coap_pkt->uri_query_len), current_option, option_length, '&');
-        coap_add_multi_option( &(coap_pkt->uri_query), current_option, option_length, 1);
+        coap_add_parsed_option(coap_pkt, &(coap_pkt->uri_query), current_option, option_length);
         PRINTF("Uri-Query [%.*s]\n", option_length, current_option);
         break;
 
       case COAP_OPTION_LOCATION_PATH:
-        coap_add_multi_option( &(coap_pkt->location_path), current_option, option_length, 1);
+        coap_add_parsed_option(coap_pkt, &(coap_pkt->location_path), current_option, option_length);
         break;
       case COAP_OPTION_LOCATION_QUERY:
         /* coap_merge_multi_option() operates in-place on the IPBUF, but final packet field should be const string -> cast to string */
@@ -802,7 +856,7 @@ coap_parse_message(void *packet, uint8_t *data, uint16_t data_len)
         coap_pkt->proxy_uri_len = option_length;
         /*TODO length > 270 not implemented (actually not required) */
         PRINTF("Proxy-Uri NOT IMPLEMENTED [%.*s]\n", coap_pkt->proxy_uri_len, coap_pkt->proxy_uri);
-        coap_error_message = "This is a constrained server (Contiki)";
+        coap_pkt->error_message = "This is a constrained server (Contiki)";
         return PROXYING_NOT_SUPPORTED_5_05;
         break;
 
@@ -835,7 +889,7 @@ coap_parse_message(void *packet, uint8_t *data, uint16_t data_len)
         /* Check if critical (odd) */
         if (option_number & 1)
         {
-          coap_error_message = "Unsupported critical option";
+          coap_pkt->error_message = "Unsupported critical option";
           coap_free_header(coap_pkt);
           return BAD_OPTION_4_02;
         }
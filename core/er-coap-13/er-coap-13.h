@@ -53,11 +53,22 @@
 #define REST_MAX_CHUNK_SIZE     128
 #endif
 
+/*
+ * The number of path and query segments stored inline by coap_parse_message().
+ * Additional segments are allocated.
+ */
+#ifndef COAP_PARSED_OPTIONS_MAX
+#define COAP_PARSED_OPTIONS_MAX 8
+#endif
+
 #define COAP_DEFAULT_MAX_AGE                 60
 #define COAP_RESPONSE_TIMEOUT                2
 #define COAP_MAX_RETRANSMIT                  4
 #define COAP_ACK_RANDOM_FACTOR               1.5
 #define COAP_MAX_LATENCY                     100
+#ifndef COAP_NSTART
+#define COAP_NSTART                          1 /* Maximum number of outstanding interactions per peer */
+#endif
 #define COAP_PROCESSING_DELAY                COAP_RESPONSE_TIMEOUT
 
 #define COAP_MAX_TRANSMIT_WAIT               ((COAP_RESPONSE_TIMEOUT * ( (1 << (COAP_MAX_RETRANSMIT + 1) ) - 1) * COAP_ACK_RANDOM_FACTOR))
@@ -211,6 +222,7 @@ typedef enum {
 typedef struct _multi_option_t {
   struct _multi_option_t *next;
   uint8_t is_static;
+  uint8_t is_inline; /* stored in coap_packet_t::parsed_options, not allocated */
   uint8_t len;
   uint8_t *data;
 } multi_option_t;
@@ -261,13 +273,26 @@ typedef struct {
   uint16_t payload_len;
   uint8_t *payload;
 
+  const char *error_message; /* human-readable payload of the parsing error */
+
+  /* Uri-Path, Uri-Query and Location-Path options pointing into the parsed buffer */
+  uint8_t parsed_options_count;
+  multi_option_t parsed_options[COAP_PARSED_OPTIONS_MAX];
+
 } coap_packet_t;
 
 /* Option format serialization*/
+#define COAP_SERIALIZE_AVAILABLE (buffer_len - (size_t)(option - buffer))
+#define COAP_SERIALIZE_CHECK(written)  \
+    { \
+      size_t option_len = (written); \
+      if (option_len == 0) return 0; \
+      option += option_len; \
+    }
 #define COAP_SERIALIZE_INT_OPTION(number, field, text)  \
     if (IS_OPTION(coap_pkt, number)) { \
       PRINTF(text" [%u]\n", coap_pkt->field); \
-      option += coap_serialize_int_option(number, current_number, option, coap_pkt->field); \
+      COAP_SERIALIZE_CHECK(coap_serialize_int_option(number, current_number, option, COAP_SERIALIZE_AVAILABLE, coap_pkt->field)); \
       current_number = number; \
     }
 #define COAP_SERIALIZE_BYTE_OPTION(number, field, text)      \
@@ -282,19 +307,19 @@ typedef struct {
         coap_pkt->field[6], \
         coap_pkt->field[7] \
       ); /*FIXME always prints 8 bytes */ \
-      option += coap_serialize_array_option(number, current_number, option, coap_pkt->field, coap_pkt->field##_len, '\0'); \
+      COAP_SERIALIZE_CHECK(coap_serialize_array_option(number, current_number, option, COAP_SERIALIZE_AVAILABLE, coap_pkt->field, coap_pkt->field##_len, '\0')); \
       current_number = number; \
     }
 #define COAP_SERIALIZE_STRING_OPTION(number, field, splitter, text)      \
     if (IS_OPTION(coap_pkt, number)) { \
       PRINTF(text" [%.*s]\n", coap_pkt->field##_len, coap_pkt->field); \
-      option += coap_serialize_array_option(number, current_number, option, (uint8_t *) coap_pkt->field, coap_pkt->field##_len, splitter); \
+      COAP_SERIALIZE_CHECK(coap_serialize_array_option(number, current_number, option, COAP_SERIALIZE_AVAILABLE, (uint8_t *) coap_pkt->field, coap_pkt->field##_len, splitter)); \
       current_number = number; \
     }
 #define COAP_SERIALIZE_MULTI_OPTION(number, field, text)      \
         if (IS_OPTION(coap_pkt, number)) { \
           PRINTF(text); \
-          option += coap_serialize_multi_option(number, current_number, option, coap_pkt->field); \
+          COAP_SERIALIZE_CHECK(coap_serialize_multi_option(number, current_number, option, COAP_SERIALIZE_AVAILABLE, coap_pkt->field)); \
           current_number = number; \
         }
 #define COAP_SERIALIZE_ACCEPT_OPTION(number, field, text)  \
@@ -303,7 +328,7 @@ typedef struct {
       for (i=0; i<coap_pkt->field##_num; ++i) \
       { \
         PRINTF(text" [%u]\n", coap_pkt->field[i]); \
-        option += coap_serialize_int_option(number, current_number, option, coap_pkt->field[i]); \
+        COAP_SERIALIZE_CHECK(coap_serialize_int_option(number, current_number, option, COAP_SERIALIZE_AVAILABLE, coap_pkt->field[i])); \
         current_number = number; \
       } \
     }
@@ -315,18 +340,14 @@ typedef struct {
       if (coap_pkt->field##_more) block |= 0x8; \
       block |= 0xF & coap_log_2(coap_pkt->field##_size/16); \
       PRINTF(text" encoded: 0x%lX\n", block); \
-      option += coap_serialize_int_option(number, current_number, option, block); \
+      COAP_SERIALIZE_CHECK(coap_serialize_int_option(number, current_number, option, COAP_SERIALIZE_AVAILABLE, block)); \
       current_number = number; \
     }
 
-/* To store error code and human-readable payload */
-extern const char *coap_error_message;
-
-uint16_t coap_get_mid(void);
-
 void coap_init_message(void *packet, coap_message_type_t type, uint8_t code, uint16_t mid);
 size_t coap_serialize_get_size(void *packet);
-size_t coap_serialize_message(void *packet, uint8_t *buffer);
+/* Returns the length of the serialized message or 0 if buffer_len is too small */
+size_t coap_serialize_message(void *packet, uint8_t *buffer, size_t buffer_len);
 coap_status_t coap_parse_message(void *request, uint8_t *data, uint16_t data_len);
 void coap_free_header(void *packet);
 
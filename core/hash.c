@@ -0,0 +1,203 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2026 Eclipse Wakaama contributors and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * The Eclipse Distribution License is available at
+ *    http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Please refer to git log
+ *
+ *******************************************************************************/
+
+/*
+ * Intrusive hash tables used to index the core internal lists.
+ *
+ * Items embed one lwm2m_hash_link_t per table they belong to. The table
+ * starts with an inline array of buckets so that adding an item never fails:
+ * the bucket array is grown when the load factor exceeds LWM2M_HASH_MAX_LOAD
+ * and if the allocation fails, the current buckets are kept.
+ * Lookups return the links matching the hash value. The caller must check the
+ * actual key as several items can share the same hash.
+ */
+
+#include "internals.h"
+
+#define LWM2M_HASH_MAX_LOAD 2
+
+#define FNV_OFFSET_BASIS    2166136261u
+#define FNV_PRIME           16777619u
+
+static lwm2m_hash_link_t ** prv_getBuckets(lwm2m_hash_table_t * tableP)
+{
+    if (tableP->buckets != NULL) return tableP->buckets;
+
+    return tableP->minBuckets;
+}
+
+static uint32_t prv_getSize(lwm2m_hash_table_t * tableP)
+{
+    if (tableP->buckets != NULL) return tableP->size;
+
+    return LWM2M_HASH_MIN_SIZE;
+}
+
+static void prv_grow(lwm2m_hash_table_t * tableP)
+{
+    lwm2m_hash_link_t ** oldBuckets;
+    lwm2m_hash_link_t ** newBuckets;
+    uint32_t oldSize;
+    uint32_t newSize;
+    uint32_t i;
+
+    oldBuckets = prv_getBuckets(tableP);
+    oldSize = prv_getSize(tableP);
+    newSize = oldSize << 1;
+    if (newSize < oldSize) return;
+
+    newBuckets = (lwm2m_hash_link_t **)lwm2m_malloc(newSize * sizeof(lwm2m_hash_link_t *));
+    // keep on using the current buckets, lookups will only be slower
+    if (newBuckets == NULL) return;
+    memset(newBuckets, 0, newSize * sizeof(lwm2m_hash_link_t *));
+
+    for (i = 0 ; i < oldSize ; i++)
+    {
+        while (oldBuckets[i] != NULL)
+        {
+            lwm2m_hash_link_t * linkP;
+
+            linkP = oldBuckets[i];
+            oldBuckets[i] = linkP->next;
+
+            linkP->next = newBuckets[linkP->hash & (newSize - 1)];
+            newBuckets[linkP->hash & (newSize - 1)] = linkP;
+        }
+    }
+
+    if (tableP->buckets != NULL) lwm2m_free(tableP->buckets);
+    tableP->buckets = newBuckets;
+    tableP->size = newSize;
+}
+
+uint32_t hash_bytes(const uint8_t * data,
+                    size_t length)
+{
+    uint32_t hash;
+    size_t i;
+
+    // FNV-1a
+    hash = FNV_OFFSET_BASIS;
+    for (i = 0 ; i < length ; i++)
+    {
+        hash ^= data[i];
+        hash *= FNV_PRIME;
+    }
+
+    return hash;
+}
+
+uint32_t hash_string(const char * str)
+{
+    uint32_t hash;
+
+    hash = FNV_OFFSET_BASIS;
+    while (*str != 0)
+    {
+        hash ^= (uint8_t)*str;
+        hash *= FNV_PRIME;
+        str++;
+    }
+
+    return hash;
+}
+
+uint32_t hash_integer(uint32_t value)
+{
+    // finalizer of MurmurHash3 to spread consecutive values over all buckets
+    value ^= value >> 16;
+    value *= 0x85EBCA6Bu;
+    value ^= value >> 13;
+    value *= 0xC2B2AE35u;
+    value ^= value >> 16;
+
+    return value;
+}
+
+void hash_add(lwm2m_hash_table_t * tableP,
+              lwm2m_hash_link_t * linkP,
+              uint32_t hash,
+              void * itemP)
+{
+    lwm2m_hash_link_t ** bucketsP;
+
+    if (tableP->count >= prv_getSize(tableP) * LWM2M_HASH_MAX_LOAD)
+    {
+        prv_grow(tableP);
+    }
+
+    bucketsP = prv_getBuckets(tableP);
+
+    linkP->hash = hash;
+    linkP->itemP = itemP;
+    linkP->next = bucketsP[hash & (prv_getSize(tableP) - 1)];
+    bucketsP[hash & (prv_getSize(tableP) - 1)] = linkP;
+    tableP->count++;
+}
+
+void hash_remove(lwm2m_hash_table_t * tableP,
+                 lwm2m_hash_link_t * linkP)
+{
+    lwm2m_hash_link_t ** parentP;
+
+    parentP = &(prv_getBuckets(tableP)[linkP->hash & (prv_getSize(tableP) - 1)]);
+    while (*parentP != NULL && *parentP != linkP)
+    {
+        parentP = &((*parentP)->next);
+    }
+
+    if (*parentP != NULL)
+    {
+        *parentP = linkP->next;
+        linkP->next = NULL;
+        tableP->count--;
+    }
+}
+
+lwm2m_hash_link_t * hash_find(lwm2m_hash_table_t * tableP,
+                              uint32_t hash)
+{
+    lwm2m_hash_link_t * linkP;
+
+    linkP = prv_getBuckets(tableP)[hash & (prv_getSize(tableP) - 1)];
+    while (linkP != NULL && linkP->hash != hash)
+    {
+        linkP = linkP->next;
+    }
+
+    return linkP;
+}
+
+lwm2m_hash_link_t * hash_findNext(lwm2m_hash_link_t * linkP)
+{
+    uint32_t hash;
+
+    hash = linkP->hash;
+    linkP = linkP->next;
+    while (linkP != NULL && linkP->hash != hash)
+    {
+        linkP = linkP->next;
+    }
+
+    return linkP;
+}
+
+void hash_free(lwm2m_hash_table_t * tableP)
+{
+    if (tableP->buckets != NULL) lwm2m_free(tableP->buckets);
+    memset(tableP, 0, sizeof(lwm2m_hash_table_t));
+}
@@ -130,6 +130,33 @@
 
 #define LWM2M_DEFAULT_LIFETIME  86400
 
+// Size of the stack buffer used to serialize the messages sent without transaction.
+// Larger messages are serialized in an allocated buffer.
+#ifndef LWM2M_SEND_BUFFER_SIZE
+#define LWM2M_SEND_BUFFER_SIZE  256
+#endif
+
+// Time an idle peer keeps its round-trip time estimation with LWM2M_RTO_COCOA
+#ifndef LWM2M_PEER_IDLE_TIMEOUT_MS
+#define LWM2M_PEER_IDLE_TIMEOUT_MS  120000
+#endif
+
+// Number of responses to CON requests kept per peer to answer the duplicates of the requests
+#ifndef LWM2M_RESPONSE_CACHE_SIZE
+#define LWM2M_RESPONSE_CACHE_SIZE   8
+#endif
+
+#ifdef LWM2M_WITH_BATCH_SEND
+// Maximum number of responses and total size of the responses
+// sent in one call to lwm2m_buffer_send_batch()
+#ifndef LWM2M_SEND_BATCH_SIZE
+#define LWM2M_SEND_BATCH_SIZE           32
+#endif
+#ifndef LWM2M_SEND_BATCH_BUFFER_SIZE
+#define LWM2M_SEND_BATCH_BUFFER_SIZE    (LWM2M_SEND_BATCH_SIZE * LWM2M_SEND_BUFFER_SIZE)
+#endif
+#endif
+
 #ifdef LWM2M_SUPPORT_SENML_JSON
 #define REG_LWM2M_RESOURCE_TYPE     ">;rt=\"oma.lwm2m\";ct=110,"
 #define REG_LWM2M_RESOURCE_TYPE_LEN 23
@@ -237,6 +264,24 @@
 
 #define ATTR_FLAG_NUMERIC (uint8_t)(LWM2M_ATTR_FLAG_LESS_THAN | LWM2M_ATTR_FLAG_GREATER_THAN | LWM2M_ATTR_FLAG_STEP)
 
+// transactions are allocated together with their message
+typedef struct
+{
+    lwm2m_transaction_t transaction;
+    coap_packet_t message;
+} transaction_item_t;
+
+#ifdef LWM2M_WITH_BATCH_SEND
+// responses collected by lwm2m_handle_packets()
+typedef struct _lwm2m_send_batch_
+{
+    lwm2m_packet_t packets[LWM2M_SEND_BATCH_SIZE];
+    size_t         count;
+    size_t         used;
+    uint8_t        buffer[LWM2M_SEND_BATCH_BUFFER_SIZE];
+} send_batch_t;
+#endif
+
 typedef struct
 {
     uint16_t clientID;
@@ -263,6 +308,15 @@ typedef struct
 } bs_data_t;
 #endif
 
+// one link of a link-format payload, pointing into the payload
+typedef struct
+{
+    uint8_t * path;             // between '<' and '>', without the leading '/'
+    size_t    pathLength;
+    uint8_t * attributes;       // after the first ';', NULL when the link has none
+    size_t    attributesLength;
+} link_entry_t;
+
 typedef enum
 {
     LWM2M_REQUEST_TYPE_UNKNOWN,
@@ -294,12 +348,16 @@ uint8_t object_createInstance(lwm2m_context_t * contextP, lwm2m_uri_t * uriP, lw
 uint8_t object_writeInstance(lwm2m_context_t * contextP, lwm2m_uri_t * uriP, lwm2m_data_t * dataP);
 
 // defined in transaction.c
-lwm2m_transaction_t * transaction_new(void * sessionH, coap_method_t method, char * altPath, lwm2m_uri_t * uriP, uint16_t mID, uint8_t token_len, uint8_t* token);
+lwm2m_transaction_t * transaction_new(lwm2m_context_t * contextP, void * sessionH, coap_method_t method, char * altPath, lwm2m_uri_t * uriP, uint16_t mID, uint8_t token_len, uint8_t* token);
+void transaction_add(lwm2m_context_t * contextP, lwm2m_transaction_t * transacP);
 int transaction_send(lwm2m_context_t * contextP, lwm2m_transaction_t * transacP);
-void transaction_free(lwm2m_transaction_t * transacP);
+void transaction_free(lwm2m_context_t * contextP, lwm2m_transaction_t * transacP);
 void transaction_remove(lwm2m_context_t * contextP, lwm2m_transaction_t * transacP);
 bool transaction_handleResponse(lwm2m_context_t * contextP, void * fromSessionH, coap_packet_t * message, coap_packet_t * response);
-void transaction_step(lwm2m_context_t * contextP, time_t currentTime, time_t * timeoutP);
+void transaction_step(lwm2m_context_t * contextP, int64_t currentTime, int64_t * timeoutP);
+bool transaction_findResponse(lwm2m_context_t * contextP, void * sessionH, uint16_t mID, uint8_t ** bufferP, size_t * lengthP);
+void transaction_cacheResponse(lwm2m_context_t * contextP, void * sessionH, uint16_t mID, uint8_t * buffer, size_t length);
+void transaction_freePeer(lwm2m_peer_t * peerP);
 
 // defined in management.c
 uint8_t dm_handleRequest(lwm2m_context_t * contextP, lwm2m_uri_t * uriP, lwm2m_server_t * serverP, coap_packet_t * message, coap_packet_t * response);
@@ -310,20 +368,25 @@ void observe_cancel(lwm2m_context_t * contextP, uint16_t mid, void * fromSession
 uint8_t observe_setParameters(lwm2m_context_t * contextP, lwm2m_uri_t * uriP, lwm2m_server_t * serverP, lwm2m_attributes_t * attrP);
 void observe_step(lwm2m_context_t * contextP, time_t currentTime, time_t * timeoutP);
 void observe_clear(lwm2m_context_t * contextP, lwm2m_uri_t * uriP);
+void observe_clearAll(lwm2m_context_t * contextP);
 bool observe_handleNotify(lwm2m_context_t * contextP, void * fromSessionH, coap_packet_t * message, coap_packet_t * response);
-void observe_remove(lwm2m_observation_t * observationP);
+void observe_remove(lwm2m_context_t * contextP, lwm2m_observation_t * observationP);
 lwm2m_observed_t * observe_findByUri(lwm2m_context_t * contextP, lwm2m_uri_t * uriP);
 
 // defined in registration.c
 uint8_t registration_handleRequest(lwm2m_context_t * contextP, lwm2m_uri_t * uriP, void * fromSessionH, coap_packet_t * message, coap_packet_t * response);
 void registration_deregister(lwm2m_context_t * contextP, lwm2m_server_t * serverP);
-void registration_freeClient(lwm2m_client_t * clientP);
+void registration_freeClient(lwm2m_context_t * contextP, lwm2m_client_t * clientP);
 uint8_t registration_start(lwm2m_context_t * contextP, bool restartFailed);
 void registration_step(lwm2m_context_t * contextP, time_t currentTime, time_t * timeoutP);
 lwm2m_status_t registration_getStatus(lwm2m_context_t * contextP);
 
 // defined in packet.c
 uint8_t message_send(lwm2m_context_t * contextP, coap_packet_t * message, void * sessionH);
+#ifdef LWM2M_WITH_BATCH_SEND
+// Sends the batched messages now if one of them goes to this session, so that they are not sent after a new request.
+void message_flush(lwm2m_context_t * contextP, void * sessionH);
+#endif
 
 // defined in bootstrap.c
 void bootstrap_step(lwm2m_context_t * contextP, time_t currentTime, time_t* timeoutP);
@@ -348,6 +411,11 @@ int json_serialize(lwm2m_uri_t * uriP, int size, lwm2m_data_t * tlvP, uint8_t **
 #ifdef LWM2M_SUPPORT_SENML_JSON
 int senml_json_parse(const lwm2m_uri_t * uriP, const uint8_t * buffer, size_t bufferLen, lwm2m_data_t ** dataP);
 int senml_json_serialize(const lwm2m_uri_t * uriP, int size, const lwm2m_data_t * tlvP, uint8_t ** bufferP);
+// Finds the next pack of a payload made of packs each starting with a record holding a base name, like the
+// notifications packed by lwm2m_set_composite_notifications(). *indexP is 0 for the first pack and is moved to
+// the next one. The pack holds the lengthP bytes of records at startP, without the brackets, of the base name uriP.
+// Returns 1 if a pack is found, 0 after the last one and -1 if the payload is not made of such packs.
+int senml_json_nextPack(const uint8_t * buffer, size_t bufferLen, size_t * indexP, lwm2m_uri_t * uriP, size_t * startP, size_t * lengthP);
 #endif
 
 // defined in json_common.c
@@ -370,10 +438,42 @@ int json_findAndCheckData(const lwm2m_uri_t * uriP, uri_depth_t level, size_t si
 // defined in discover.c
 int discover_serialize(lwm2m_context_t * contextP, lwm2m_uri_t * uriP, lwm2m_server_t * serverP, int size, lwm2m_data_t * dataP, uint8_t ** bufferP);
 
+// defined in linkformat.c
+int linkformat_nextLink(uint8_t * buffer, size_t length, size_t * indexP, link_entry_t * linkP);
+int linkformat_nextAttribute(uint8_t * buffer, size_t length, size_t * indexP, uint8_t ** keyP, size_t * keyLengthP, uint8_t ** valueP, size_t * valueLengthP);
+
 // defined in block1.c
 uint8_t coap_block1_handler(lwm2m_block1_data_t ** block1Data, uint16_t mid, uint8_t * buffer, size_t length, uint16_t blockSize, uint32_t blockNum, bool blockMore, uint8_t ** outputBuffer, size_t * outputLength);
 void free_block1_buffer(lwm2m_block1_data_t * block1Data);
 
+// defined in hash.c
+uint32_t hash_bytes(const uint8_t * data, size_t length);
+uint32_t hash_string(const char * str);
+uint32_t hash_integer(uint32_t value);
+void hash_add(lwm2m_hash_table_t * tableP, lwm2m_hash_link_t * linkP, uint32_t hash, void * itemP);
+void hash_remove(lwm2m_hash_table_t * tableP, lwm2m_hash_link_t * linkP);
+lwm2m_hash_link_t * hash_find(lwm2m_hash_table_t * tableP, uint32_t hash);
+lwm2m_hash_link_t * hash_findNext(lwm2m_hash_link_t * linkP);
+void hash_free(lwm2m_hash_table_t * tableP);
+
+// defined in timer.c
+bool timer_schedule(lwm2m_timer_heap_t * heapP, lwm2m_timer_t * timerP, int64_t time, void * itemP);
+void timer_cancel(lwm2m_timer_heap_t * heapP, lwm2m_timer_t * timerP);
+lwm2m_timer_t * timer_peek(lwm2m_timer_heap_t * heapP);
+void timer_free(lwm2m_timer_heap_t * heapP);
+
+// defined in pool.c
+void pool_init(lwm2m_pool_t * poolP, size_t itemSize, uint16_t capacity);
+void * pool_alloc(lwm2m_pool_t * poolP);
+void pool_release(lwm2m_pool_t * poolP, void * itemP);
+void pool_free(lwm2m_pool_t * poolP);
+
+// defined in slot.c
+bool slot_add(lwm2m_slot_table_t * tableP, void * itemP, uint16_t * idP);
+void * slot_find(lwm2m_slot_table_t * tableP, uint16_t id);
+void slot_remove(lwm2m_slot_table_t * tableP, uint16_t id);
+void slot_free(lwm2m_slot_table_t * tableP);
+
 // defined in utils.c
 lwm2m_data_type_t utils_depthToDatatype(uri_depth_t depth);
 lwm2m_version_t utils_stringToVersion(uint8_t *buffer, size_t length);
@@ -400,6 +500,9 @@ size_t utils_base64GetSize(size_t dataLen);
 size_t utils_base64Encode(const uint8_t * dataP, size_t dataLen, uint8_t * bufferP, size_t bufferLen);
 size_t utils_base64GetDecodedSize(const char * dataP, size_t dataLen);
 size_t utils_base64Decode(const char * dataP, size_t dataLen, uint8_t * bufferP, size_t bufferLen);
+int64_t utils_gettimeMs(void);
+time_t utils_gettime(void);
+uint32_t utils_sessionHash(lwm2m_context_t * contextP, void * sessionH);
 #ifdef LWM2M_CLIENT_MODE
 lwm2m_server_t * utils_findServer(lwm2m_context_t * contextP, void * fromSessionH);
 lwm2m_server_t * utils_findBootstrapServer(lwm2m_context_t * contextP, void * fromSessionH);
@@ -67,8 +67,12 @@ lwm2m_context_t * lwm2m_init(void * userData)
     {
         memset(contextP, 0, sizeof(lwm2m_context_t));
         contextP->userData = userData;
-        srand((int)lwm2m_gettime());
+        srand((int)utils_gettimeMs());
         contextP->nextMID = rand();
+        pool_init(&contextP->transactionPool, sizeof(transaction_item_t), LWM2M_TRANSACTION_POOL_SIZE);
+#ifdef LWM2M_SERVER_MODE
+        pool_init(&contextP->dmDataPool, sizeof(dm_data_t), LWM2M_DM_DATA_POOL_SIZE);
+#endif
     }
 
     return contextP;
@@ -136,37 +140,42 @@ static void prv_deleteBootstrapServerList(lwm2m_context_t * context)
     }
 }
 
-static void prv_deleteObservedList(lwm2m_context_t * contextP)
+#endif
+
+void prv_deleteTransactionList(lwm2m_context_t * context)
 {
-    while (NULL != contextP->observedList)
+    // the timers are reset in the scheduled items
+    timer_free(&context->transactionTimers);
+    timer_free(&context->peerTimers);
+
+    while (NULL != context->peerList)
     {
-        lwm2m_observed_t * targetP;
-        lwm2m_watcher_t * watcherP;
+        lwm2m_peer_t * peerP;
 
-        targetP = contextP->observedList;
-        contextP->observedList = contextP->observedList->next;
+        peerP = context->peerList;
+        context->peerList = peerP->next;
 
-        for (watcherP = targetP->watcherList ; watcherP != NULL ; watcherP = watcherP->next)
+        while (NULL != peerP->transactionList)
         {
-            if (watcherP->parameters != NULL) lwm2m_free(watcherP->parameters);
-        }
-        LWM2M_LIST_FREE(targetP->watcherList);
-
-        lwm2m_free(targetP);
-    }
-}
-#endif
+            lwm2m_transaction_t * transaction;
 
-void prv_deleteTransactionList(lwm2m_context_t * context)
-{
-    while (NULL != context->transactionList)
-    {
-        lwm2m_transaction_t * transaction;
+            transaction = peerP->transactionList;
+            peerP->transactionList = transaction->next;
+            transaction_free(context, transaction);
+        }
+        while (NULL != peerP->waitingList)
+        {
+            lwm2m_transaction_t * transaction;
 
-        transaction = context->transactionList;
-        context->transactionList = context->transactionList->next;
-        transaction_free(transaction);
+            transaction = peerP->waitingList;
+            peerP->waitingList = transaction->next;
+            transaction_free(context, transaction);
+        }
+        transaction_freePeer(peerP);
     }
+    hash_free(&context->transactionMidTable);
+    hash_free(&context->transactionTokenTable);
+    hash_free(&context->peerSessionTable);
 }
 
 void lwm2m_close(lwm2m_context_t * contextP)
@@ -177,7 +186,7 @@ void lwm2m_close(lwm2m_context_t * contextP)
     lwm2m_deregister(contextP);
     prv_deleteServerList(contextP);
     prv_deleteBootstrapServerList(contextP);
-    prv_deleteObservedList(contextP);
+    observe_clearAll(contextP);
     lwm2m_free(contextP->endpointName);
     if (contextP->msisdn != NULL)
     {
@@ -191,6 +200,8 @@ void lwm2m_close(lwm2m_context_t * contextP)
 #endif
 
 #ifdef LWM2M_SERVER_MODE
+    // the timers are reset in the scheduled clients
+    timer_free(&contextP->clientTimers);
     while (NULL != contextP->clientList)
     {
         lwm2m_client_t * clientP;
@@ -198,11 +209,20 @@ void lwm2m_close(lwm2m_context_t * contextP)
         clientP = contextP->clientList;
         contextP->clientList = contextP->clientList->next;
 
-        registration_freeClient(clientP);
+        registration_freeClient(contextP, clientP);
     }
+    hash_free(&contextP->clientNameTable);
+    hash_free(&contextP->clientSessionTable);
+    hash_free(&contextP->observationTokenTable);
+    hash_free(&contextP->objectListTable);
+    slot_free(&contextP->clientSlots);
 #endif
 
     prv_deleteTransactionList(contextP);
+    pool_free(&contextP->transactionPool);
+#ifdef LWM2M_SERVER_MODE
+    pool_free(&contextP->dmDataPool);
+#endif
     lwm2m_free(contextP);
 }
 
@@ -364,11 +384,36 @@ int lwm2m_remove_object(lwm2m_context_t * contextP,
 int lwm2m_step(lwm2m_context_t * contextP,
                time_t * timeoutP)
 {
+    int64_t timeout;
+    int result;
+
+    timeout = (int64_t)*timeoutP * 1000;
+    result = lwm2m_step_ms(contextP, &timeout);
+    if (result == 0)
+    {
+        // round up to not wake up before the next event
+        *timeoutP = (time_t)((timeout + 999) / 1000);
+    }
+
+    return result;
+}
+
+int lwm2m_step_ms(lwm2m_context_t * contextP,
+                  int64_t * timeoutP)
+{
+    int64_t now;
     time_t tv_sec;
+    time_t initialTimeout;
+    time_t timeout;
 
     LOG_ARG("timeoutP: %" PRId64, *timeoutP);
-    tv_sec = lwm2m_gettime();
-    if (tv_sec < 0) return COAP_500_INTERNAL_SERVER_ERROR;
+    now = utils_gettimeMs();
+    if (now < 0) return COAP_500_INTERNAL_SERVER_ERROR;
+    tv_sec = (time_t)(now / 1000);
+
+    // the registration, bootstrap and observation timers use seconds
+    initialTimeout = (time_t)((*timeoutP + 999) / 1000);
+    timeout = initialTimeout;
 
 #ifdef LWM2M_CLIENT_MODE
     LOG_ARG("State: %s", STR_STATE(contextP->state));
@@ -397,7 +442,7 @@ next_step:
         {
             bootstrap_start(contextP);
             contextP->state = STATE_BOOTSTRAPPING;
-            bootstrap_step(contextP, tv_sec, timeoutP);
+            bootstrap_step(contextP, tv_sec, &timeout);
         }
         else
 #endif
@@ -420,7 +465,7 @@ next_step:
 
         default:
             // keep on waiting
-            bootstrap_step(contextP, tv_sec, timeoutP);
+            bootstrap_step(contextP, tv_sec, &timeout);
             break;
         }
         break;
@@ -470,11 +515,21 @@ next_step:
         break;
     }
 
-    observe_step(contextP, tv_sec, timeoutP);
+    observe_step(contextP, tv_sec, &timeout);
 #endif
 
-    registration_step(contextP, tv_sec, timeoutP);
-    transaction_step(contextP, tv_sec, timeoutP);
+    registration_step(contextP, tv_sec, &timeout);
+    if (timeout < initialTimeout)
+    {
+        int64_t timeoutMs;
+
+        // the events are due at the start of the second
+        timeoutMs = (int64_t)timeout * 1000 - now % 1000;
+        if (timeoutMs < 0) timeoutMs = 0;
+        if (*timeoutP > timeoutMs) *timeoutP = timeoutMs;
+    }
+
+    transaction_step(contextP, now, timeoutP);
 
     LOG_ARG("Final timeoutP: %" PRId64, *timeoutP);
 #ifdef LWM2M_CLIENT_MODE
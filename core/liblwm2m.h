@@ -118,6 +118,13 @@ int lwm2m_strncmp(const char * s1, const char * s2, size_t n);
 // In case of error, this must return a negative value.
 // Per POSIX specifications, time_t is a signed integer.
 time_t lwm2m_gettime(void);
+#ifdef LWM2M_WITH_TIME_MS
+// This function must return the number of milliseconds elapsed since origin.
+// A monotonic clock is preferred. When LWM2M_WITH_TIME_MS is defined, the core
+// uses only this function and not lwm2m_gettime().
+// In case of error, this must return a negative value.
+int64_t lwm2m_gettime_ms(void);
+#endif
 
 #ifdef LWM2M_WITH_LOGS
 // Same usage as C89 printf()
@@ -125,6 +132,15 @@ void lwm2m_printf(const char * format, ...);
 #endif
 
 // communication layer
+
+// A datagram exchanged with a peer
+typedef struct
+{
+    uint8_t * buffer;
+    size_t    length;
+    void *    sessionH;
+} lwm2m_packet_t;
+
 #ifdef LWM2M_CLIENT_MODE
 // Returns a session handle that MUST uniquely identify a peer.
 // secObjInstID: ID of the Securty Object instance to open a connection to
@@ -141,10 +157,23 @@ void lwm2m_close_connection(void * sessionH, void * userData);
 // buffer, length: data to send
 // userData: parameter to lwm2m_init()
 uint8_t lwm2m_buffer_send(void * sessionH, uint8_t * buffer, size_t length, void * userData);
+#ifdef LWM2M_WITH_BATCH_SEND
+// Send several datagrams at once. Used by lwm2m_handle_packets() for the responses.
+// Returns COAP_NO_ERROR or a COAP_NNN error code
+// packets, count: datagrams to send, in order. Their buffers are only valid during the call.
+// userData: parameter to lwm2m_init()
+uint8_t lwm2m_buffer_send_batch(lwm2m_packet_t * packets, size_t count, void * userData);
+#endif
 // Compare two session handles
 // Returns true if the two sessions identify the same peer. false otherwise.
 // userData: parameter to lwm2m_init()
 bool lwm2m_session_is_equal(void * session1, void * session2, void * userData);
+#ifdef LWM2M_SESSION_HASH
+// Hash a session handle to find the peers and the clients of a session without comparing all the sessions.
+// Returns a hash value. Two sessions equal for lwm2m_session_is_equal() must have the same hash value.
+// userData: parameter to lwm2m_init()
+uint32_t lwm2m_session_hash(void * sessionH, void * userData);
+#endif
 
 /*
  * Error code
@@ -263,6 +292,90 @@ void lwm2m_list_free(lwm2m_list_t * head);
 #define LWM2M_LIST_FIND(H,I) lwm2m_list_find((lwm2m_list_t *)H, I)
 #define LWM2M_LIST_FREE(H) lwm2m_list_free((lwm2m_list_t *)H)
 
+/*
+ * Hash table indexes, for internal use only.
+ *
+ * Indexed structures embed one lwm2m_hash_link_t per index.
+ */
+
+#ifndef LWM2M_HASH_MIN_SIZE
+#define LWM2M_HASH_MIN_SIZE 8   // must be a power of 2
+#endif
+
+typedef struct _lwm2m_hash_link_t
+{
+    struct _lwm2m_hash_link_t * next;
+    uint32_t                    hash;
+    void *                      itemP;
+} lwm2m_hash_link_t;
+
+typedef struct
+{
+    lwm2m_hash_link_t ** buckets;   // NULL while minBuckets is used
+    lwm2m_hash_link_t *  minBuckets[LWM2M_HASH_MIN_SIZE];
+    uint32_t             size;
+    uint32_t             count;
+} lwm2m_hash_table_t;
+
+/*
+ * Timer heaps, for internal use only.
+ *
+ * Scheduled structures embed one lwm2m_timer_t per heap.
+ */
+
+typedef struct
+{
+    int64_t  time;
+    uint32_t index;     // position in the heap plus one, 0 when not scheduled
+    void *   itemP;
+} lwm2m_timer_t;
+
+typedef struct
+{
+    lwm2m_timer_t ** timers;
+    uint32_t         size;
+    uint32_t         count;
+} lwm2m_timer_heap_t;
+
+/*
+ * Fixed-size object pools, for internal use only.
+ *
+ * The storage is allocated once. Allocations fall back on lwm2m_malloc()
+ * when the pool is exhausted.
+ */
+
+// Number of transactions and of server-side operations preallocated by a context.
+// 0 disables the pools.
+#ifndef LWM2M_TRANSACTION_POOL_SIZE
+#define LWM2M_TRANSACTION_POOL_SIZE 0
+#endif
+#ifndef LWM2M_DM_DATA_POOL_SIZE
+#define LWM2M_DM_DATA_POOL_SIZE 0
+#endif
+
+typedef struct
+{
+    uint8_t * storage;
+    void *    freeList;
+    size_t    itemSize;
+    uint16_t  capacity;
+} lwm2m_pool_t;
+
+/*
+ * Dense tables of items indexed by a 16-bit ID, for internal use only.
+ *
+ * Released IDs are given again before new ones.
+ */
+
+typedef struct
+{
+    void **    slots;       // items by ID, NULL for the released IDs
+    uint16_t * freeIds;     // released IDs
+    uint32_t   size;        // allocated slots
+    uint32_t   used;        // IDs given at least once
+    uint32_t   freeCount;
+} lwm2m_slot_table_t;
+
 /*
  * URI
  *
@@ -554,6 +667,9 @@ typedef struct _lwm2m_observation_
     struct _lwm2m_observation_ * next;  // matches lwm2m_list_t::next
     uint16_t                     id;    // matches lwm2m_list_t::id
     struct _lwm2m_client_ * clientP;
+    uint8_t                 token[8];   // for internal use only
+    uint8_t                 tokenLen;   // for internal use only
+    lwm2m_hash_link_t       tokenLink;  // for internal use only
     lwm2m_uri_t             uri;
     lwm2m_status_t          status;     // latest user operation
     lwm2m_result_callback_t callback;
@@ -592,18 +708,45 @@ typedef struct
  *
  */
 
-typedef struct _lwm2m_client_object_
+// An object instance, or an object registered without instance when instanceId is LWM2M_MAX_ID.
+typedef struct
 {
-    struct _lwm2m_client_object_ * next; // matches lwm2m_list_t::next
-    uint16_t                 id;         // matches lwm2m_list_t::id
-    lwm2m_list_t *           instanceList;
+    uint16_t objectId;
+    uint16_t instanceId;
 } lwm2m_client_object_t;
 
+// Objects sorted by object then instance ID. The clients registering the same objects share the list.
+typedef struct
+{
+    lwm2m_hash_link_t       link;       // for internal use only
+    uint32_t                refCount;   // for internal use only
+    size_t                  count;
+    lwm2m_client_object_t * objects;
+} lwm2m_client_object_list_t;
+
+/*
+ * Changes of the object list of a client on a registration Update.
+ *
+ * The URIs are sorted by object then instance ID. An URI without instance
+ * stands for the whole object.
+ */
+typedef struct
+{
+    lwm2m_uri_t * addedList;
+    size_t        addedCount;
+    lwm2m_uri_t * removedList;
+    size_t        removedCount;
+} lwm2m_client_diff_t;
+
 typedef struct _lwm2m_client_
 {
     struct _lwm2m_client_ * next;       // matches lwm2m_list_t::next
     uint16_t                internalID; // matches lwm2m_list_t::id
     char *                  name;
+    lwm2m_hash_link_t       nameLink;   // for internal use only
+    struct _lwm2m_client_ * prev;       // for internal use only
+    lwm2m_timer_t           lifetimeTimer; // for internal use only
+    lwm2m_hash_link_t       sessionLink;   // for internal use only
     lwm2m_version_t         version;
     lwm2m_binding_t         binding;
     char *                  msisdn;
@@ -612,9 +755,15 @@ typedef struct _lwm2m_client_
     uint32_t                lifetime;
     time_t                  endOfLife;
     void *                  sessionH;
-    lwm2m_client_object_t * objectList;
+    time_t                  registrationTime; // for internal use only
+    uint16_t                registrationMid;  // for internal use only
+    lwm2m_client_object_list_t * objectList;
+    lwm2m_client_diff_t *   objectDiff; // only set during the monitoring callback of an Update with an object list
     lwm2m_observation_t *   observationList;
     uint16_t                observationId;
+#ifdef LWM2M_SUPPORT_SENML_JSON
+    bool                    compositeNotifications; // see lwm2m_set_client_composite_notifications()
+#endif
 } lwm2m_client_t;
 
 
@@ -625,25 +774,96 @@ typedef struct _lwm2m_client_
  */
 
 typedef struct _lwm2m_transaction_ lwm2m_transaction_t;
+typedef struct _lwm2m_peer_ lwm2m_peer_t;
 
 typedef void (*lwm2m_transaction_callback_t) (lwm2m_context_t * contextP, lwm2m_transaction_t * transacP, void * message);
 
+// Size of the buffer storing the serialized message inside the transaction.
+// Larger messages are serialized in an allocated buffer.
+#ifndef LWM2M_TRANSACTION_BUFFER_SIZE
+#define LWM2M_TRANSACTION_BUFFER_SIZE 128
+#endif
+
 struct _lwm2m_transaction_
 {
-    lwm2m_transaction_t * next;  // matches lwm2m_list_t::next
-    uint16_t              mID;   // matches lwm2m_list_t::id
+    lwm2m_transaction_t * next;
+    lwm2m_transaction_t * prev;
+    uint16_t              mID;
+    lwm2m_hash_link_t     midLink;   // for internal use only
+    lwm2m_hash_link_t     tokenLink; // for internal use only
+    lwm2m_timer_t         retransTimer; // for internal use only
     void *                peerH;
+    lwm2m_peer_t *        peerP;        // for internal use only
+    uint8_t               waiting;      // queued until the peer has a free NSTART slot
+    uint8_t               inFlight;     // uses one of the NSTART slots of the peer
     uint8_t               ack_received; // indicates, that the ACK was received
     time_t                response_timeout; // timeout to wait for response, if token is used. When 0, use calculated acknowledge timeout.
     uint8_t  retrans_counter;
-    time_t   retrans_time;
+    int64_t  retrans_time;      // in milliseconds
+    uint32_t retrans_timeout;   // current retransmission timeout in milliseconds
+    uint32_t initial_rto;       // RTO of the peer at the first transmission, selects the CoCoA back-off factor
+    int64_t  send_time;         // first transmission in milliseconds
     void * message;
     uint16_t buffer_len;
-    uint8_t * buffer;
+    uint8_t * buffer;   // points to inlineBuffer or to an allocated buffer
+    uint8_t inlineBuffer[LWM2M_TRANSACTION_BUFFER_SIZE];
     lwm2m_transaction_callback_t callback;
     void * userData;
 };
 
+// Computation of the retransmission timeouts
+typedef enum
+{
+    LWM2M_RTO_FIXED = 0,    // random initial timeout from COAP_RESPONSE_TIMEOUT, doubled at each retransmission
+    LWM2M_RTO_COCOA         // per peer estimation from the ACK timings, as in CoCoA (draft-ietf-core-cocoa)
+} lwm2m_rto_mode_t;
+
+/*
+ * Peers with pending transactions, for internal use only
+ *
+ * At most COAP_NSTART transactions are outstanding per peer. The others
+ * wait in order in waitingList.
+ * With LWM2M_RTO_COCOA, idle peers are kept for a while to remember
+ * their round-trip time estimation.
+ * The responses to the last CON requests received from the peer are kept
+ * in responseCache for COAP_EXCHANGE_LIFETIME to answer their duplicates
+ * (RFC 7252 section 4.5). The peer is kept until they expire.
+ */
+typedef struct
+{
+    int64_t   expiry;   // in milliseconds, 0 for an unused entry
+    uint16_t  mid;
+    uint8_t * buffer;   // serialized response
+    size_t    length;
+    size_t    size;     // allocated size of buffer, reused by the next responses
+} lwm2m_cached_response_t;
+
+typedef struct
+{
+    uint32_t srtt;      // smoothed round-trip time in milliseconds, 0 before the first measure
+    uint32_t rttvar;    // round-trip time variation in milliseconds
+} lwm2m_rtt_t;
+
+struct _lwm2m_peer_
+{
+    lwm2m_peer_t *        next;
+    lwm2m_peer_t *        prev;
+    void *                sessionH;
+    lwm2m_hash_link_t     sessionLink;
+    lwm2m_transaction_t * transactionList;  // started transactions
+    lwm2m_transaction_t * waitingList;
+    lwm2m_transaction_t * waitingTail;
+    uint16_t              outstanding;      // number of transactions in flight
+    bool                  sending;          // the waiting transactions are being started, for internal use only
+    lwm2m_timer_t         idleTimer;
+    lwm2m_rtt_t           strongRtt;        // measured on transactions sent once
+    lwm2m_rtt_t           weakRtt;          // measured on retransmitted transactions
+    uint32_t              rto;              // overall retransmission timeout in milliseconds
+    int64_t               rtoTime;          // last update of rto in milliseconds
+    lwm2m_cached_response_t * responseCache; // LWM2M_RESPONSE_CACHE_SIZE entries, allocated on first use
+    uint16_t              responseNext;     // next entry to replace
+};
+
 /*
  * LWM2M observed resources
  */
@@ -653,6 +873,8 @@ typedef struct _lwm2m_watcher_
 
     bool active;
     bool update;
+    struct _lwm2m_observed_ * observed;
+    lwm2m_timer_t timer;    // next check of the notification conditions, for internal use only
     lwm2m_server_t * server;
     lwm2m_attributes_t * parameters;
     lwm2m_media_type_t format;
@@ -669,12 +891,34 @@ typedef struct _lwm2m_watcher_
     } lastValue;
 } lwm2m_watcher_t;
 
+/*
+ * Index of the observed URIs, for internal use only
+ *
+ * Each node is one level of an URI (object, instance, resource or resource
+ * instance) with the observation of this URI, if any, and the nodes of the
+ * next level. Nodes are found by parent and ID in a hash table and only
+ * exist while an observation uses them.
+ */
+typedef struct _lwm2m_uri_node_
+{
+    struct _lwm2m_uri_node_ * parent;
+    struct _lwm2m_uri_node_ * next;     // sibling
+    struct _lwm2m_uri_node_ * prev;
+    struct _lwm2m_uri_node_ * children;
+    lwm2m_hash_link_t         link;
+    uint16_t                  id;
+    struct _lwm2m_observed_ * observed;
+} lwm2m_uri_node_t;
+
 typedef struct _lwm2m_observed_
 {
     struct _lwm2m_observed_ * next;
 
     lwm2m_uri_t uri;
+    lwm2m_uri_node_t * node;    // for internal use only
     lwm2m_watcher_t * watcherList;
+    lwm2m_data_t * valueP;      // storage of the value given to lwm2m_resource_value_push()
+    bool valueSet;              // valueP was not checked yet, else the value is read from the object
 } lwm2m_observed_t;
 
 #ifdef LWM2M_CLIENT_MODE
@@ -716,18 +960,45 @@ struct _lwm2m_context_
     lwm2m_server_t *     serverList;
     lwm2m_object_t *     objectList;
     lwm2m_observed_t *   observedList;
+    lwm2m_timer_heap_t   observeTimers;     // watchers by next check
+    lwm2m_hash_table_t   observedNodeTable; // observed URIs by parent node and ID
+#ifdef LWM2M_SUPPORT_SENML_JSON
+    bool                 compositeNotifications; // notifications packed per server, see lwm2m_set_composite_notifications()
+#endif
 #endif
 #ifdef LWM2M_SERVER_MODE
     lwm2m_client_t *        clientList;
+    lwm2m_hash_table_t      clientNameTable;        // clients by endpoint name
+    lwm2m_slot_table_t      clientSlots;            // clients by internal ID
+    lwm2m_timer_heap_t      clientTimers;           // clients by endOfLife
+    lwm2m_hash_table_t      clientSessionTable;     // clients by session
+    lwm2m_hash_table_t      observationTokenTable;  // observations by token
+    lwm2m_hash_table_t      objectListTable;        // shared client object lists
+    uint32_t                observationCount;       // observations ever requested
+    uint32_t                registrationLimit;      // Register requests processed per second, 0 for no limit
+    uint32_t                registrationBackoff;    // Max-Age of the rejected Register requests
+    time_t                  registrationWindow;     // second of the counted Register requests
+    uint32_t                registrationCount;      // Register requests received in this second
     lwm2m_result_callback_t monitorCallback;
     void *                  monitorUserData;
+    lwm2m_pool_t            dmDataPool;             // pending DM operations
 #endif
 #ifdef LWM2M_BOOTSTRAP_SERVER_MODE
     lwm2m_bootstrap_callback_t bootstrapCallback;
     void *                     bootstrapUserData;
 #endif
     uint16_t                nextMID;
-    lwm2m_transaction_t *   transactionList;
+    lwm2m_peer_t *          peerList;               // peers with transactions
+    lwm2m_hash_table_t      peerSessionTable;       // peers by session
+    lwm2m_hash_table_t      transactionMidTable;    // transactions by message ID
+    lwm2m_hash_table_t      transactionTokenTable;  // transactions by token
+    lwm2m_timer_heap_t      transactionTimers;      // transactions by retrans_time
+    lwm2m_pool_t            transactionPool;        // transactions with their message
+    lwm2m_timer_heap_t      peerTimers;             // idle peers by expiration time
+    lwm2m_rto_mode_t        rtoMode;
+#ifdef LWM2M_WITH_BATCH_SEND
+    struct _lwm2m_send_batch_ * sendBatchP;         // for internal use only
+#endif
     void *                  userData;
 };
 
@@ -739,8 +1010,15 @@ void lwm2m_close(lwm2m_context_t * contextP);
 
 // perform any required pending operation and adjust timeoutP to the maximal time interval to wait in seconds.
 int lwm2m_step(lwm2m_context_t * contextP, time_t * timeoutP);
+// same as lwm2m_step() with timeoutP in milliseconds.
+int lwm2m_step_ms(lwm2m_context_t * contextP, int64_t * timeoutP);
 // dispatch received data to liblwm2m
 void lwm2m_handle_packet(lwm2m_context_t * contextP, uint8_t * buffer, int length, void * fromSessionH);
+// dispatch several received datagrams to liblwm2m
+// With LWM2M_WITH_BATCH_SEND, the responses are sent at the end, except when a request is sent to the same peer before.
+void lwm2m_handle_packets(lwm2m_context_t * contextP, lwm2m_packet_t * packets, size_t count);
+// select how the retransmission timeouts of the context are computed. Default is LWM2M_RTO_FIXED.
+void lwm2m_set_rto_mode(lwm2m_context_t * contextP, lwm2m_rto_mode_t mode);
 
 #ifdef LWM2M_CLIENT_MODE
 // configure the client side with the Endpoint Name, binding, MSISDN (can be nil), alternative path
@@ -757,6 +1035,20 @@ int lwm2m_remove_object(lwm2m_context_t * contextP, uint16_t id);
 int lwm2m_update_registration(lwm2m_context_t * contextP, uint16_t shortServerID, bool withObjects);
 
 void lwm2m_resource_value_changed(lwm2m_context_t * contextP, lwm2m_uri_t * uriP);
+// same as lwm2m_resource_value_changed() for count URIs. An URI without resource marks all the resources of the
+// object or instance. The watchers of several changed URIs send a single notification in the next lwm2m_step().
+void lwm2m_resources_value_changed(lwm2m_context_t * contextP, lwm2m_uri_t * uriList, size_t count);
+// same as lwm2m_resource_value_changed() for a resource URI with its new value. The library keeps a copy of dataP
+// and uses it to check the notification conditions of the resource instead of reading it from the object.
+void lwm2m_resource_value_push(lwm2m_context_t * contextP, lwm2m_uri_t * uriP, lwm2m_data_t * dataP);
+#ifdef LWM2M_SUPPORT_SENML_JSON
+// When enabled, the SenML-JSON notifications due for a server in one lwm2m_step() are packed in as few messages as
+// fit in LWM2M_SEND_BUFFER_SIZE, each carrying the token and the observe counter of its first notification. The
+// records of each notification start with the observed URI as base name. Default is disabled. Only enable it with
+// servers which split these messages, like the server side of this library after
+// lwm2m_set_client_composite_notifications().
+void lwm2m_set_composite_notifications(lwm2m_context_t * contextP, bool enable);
+#endif
 #endif
 
 #ifdef LWM2M_SERVER_MODE
@@ -766,7 +1058,20 @@ void lwm2m_resource_value_changed(lwm2m_context_t * contextP, lwm2m_uri_t * uriP
 // clientID is the internal ID of the LWM2M Client.
 // The callback's parameters uri, data, dataLength are always NULL.
 // The lwm2m_client_t is present in the lwm2m_context_t's clientList when the callback is called. On a deregistration, it deleted when the callback returns.
+// When a LWM2M client updates its registration, the callback is called with status COAP_204_CHANGED. If the update
+// contains an object list, the objectDiff of the lwm2m_client_t lists the added and removed objects and instances.
 void lwm2m_set_monitoring_callback(lwm2m_context_t * contextP, lwm2m_result_callback_t callback, void * userData);
+// Registration admission control.
+// At most maxPerSecond new Register requests are processed each second, 0 meaning no limit (default). The others are
+// answered with a 5.03 Service Unavailable and a Max-Age between backoff and 2 * backoff - 1 seconds so the rejected
+// clients do not retry at the same time, or without Max-Age if backoff is 0. Registration Updates and De-registrations are never rejected.
+// Retransmissions of an accepted Register are answered again without notifying the monitoring callback.
+void lwm2m_set_registration_limit(lwm2m_context_t * contextP, uint32_t maxPerSecond, uint32_t backoff);
+// Returns the registered client with this internal ID or NULL. The clientList is not sorted by ID.
+lwm2m_client_t * lwm2m_get_client(lwm2m_context_t * contextP, uint16_t clientID);
+// Returns the client registered from this session or NULL.
+// The lookup is indexed only with LWM2M_SESSION_HASH, else it compares the session to the ones of all the clients.
+lwm2m_client_t * lwm2m_get_client_by_session(lwm2m_context_t * contextP, void * sessionH);
 
 // Device Management APIs
 int lwm2m_dm_read(lwm2m_context_t * contextP, uint16_t clientID, lwm2m_uri_t * uriP, lwm2m_result_callback_t callback, void * userData);
@@ -780,6 +1085,12 @@ int lwm2m_dm_delete(lwm2m_context_t * contextP, uint16_t clientID, lwm2m_uri_t *
 // Information Reporting APIs
 int lwm2m_observe(lwm2m_context_t * contextP, uint16_t clientID, lwm2m_uri_t * uriP, lwm2m_result_callback_t callback, void * userData);
 int lwm2m_observe_cancel(lwm2m_context_t * contextP, uint16_t clientID, lwm2m_uri_t * uriP, lwm2m_result_callback_t callback, void * userData);
+#ifdef LWM2M_SUPPORT_SENML_JSON
+// Tells that the client packs its notifications with lwm2m_set_composite_notifications(). Default is disabled. When
+// enabled, a SenML-JSON notification is split by the base names starting each pack of records and every observation
+// of the client whose URI is such a base name gets its pack. Call it in the monitoring callback of the registration.
+int lwm2m_set_client_composite_notifications(lwm2m_context_t * contextP, uint16_t clientID, bool enable);
+#endif
 #endif
 
 #ifdef LWM2M_BOOTSTRAP_SERVER_MODE
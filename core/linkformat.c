@@ -0,0 +1,135 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2026 Eclipse Wakaama contributors and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * The Eclipse Distribution License is available at
+ *    http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Please refer to git log
+ *
+ *******************************************************************************/
+
+/*
+ * Tokenizer of CoRE link-format payloads (RFC 6690).
+ *
+ * Each call reads one link or one attribute and leaves the index after it,
+ * so a payload is read in a single pass without allocation. The delimiters
+ * are searched with memchr() which is usually vectorized by the C library.
+ */
+
+#include "internals.h"
+
+static size_t prv_skipSpaces(const uint8_t * buffer,
+                             size_t length,
+                             size_t index)
+{
+    while (index < length && buffer[index] == ' ') index++;
+
+    return index;
+}
+
+static size_t prv_trimSpaces(const uint8_t * buffer,
+                             size_t start,
+                             size_t end)
+{
+    while (end > start && buffer[end - 1] == ' ') end--;
+
+    return end;
+}
+
+// Returns the index of the first c in buffer from index, or length.
+static size_t prv_find(const uint8_t * buffer,
+                       size_t length,
+                       size_t index,
+                       uint8_t c)
+{
+    const uint8_t * found;
+
+    if (index >= length) return length;
+
+    found = (const uint8_t *)memchr(buffer + index, c, length - index);
+    if (found == NULL) return length;
+
+    return (size_t)(found - buffer);
+}
+
+int linkformat_nextLink(uint8_t * buffer,
+                        size_t length,
+                        size_t * indexP,
+                        link_entry_t * linkP)
+{
+    size_t index;
+    size_t end;
+
+    index = prv_skipSpaces(buffer, length, *indexP);
+    if (index == length) return 0;
+    if (buffer[index] != REG_URI_START) return -1;
+    index++;
+
+    end = prv_find(buffer, length, index, REG_URI_END);
+    if (end == length) return -1;
+
+    // the path is given without the leading '/'
+    if (index < end && buffer[index] == '/') index++;
+    linkP->path = buffer + index;
+    linkP->pathLength = end - index;
+    linkP->attributes = NULL;
+    linkP->attributesLength = 0;
+
+    index = prv_skipSpaces(buffer, length, end + 1);
+    if (index < length && buffer[index] == REG_ATTR_SEPARATOR)
+    {
+        index++;
+        end = prv_find(buffer, length, index, REG_DELIMITER);
+        linkP->attributes = buffer + index;
+        linkP->attributesLength = prv_trimSpaces(buffer, index, end) - index;
+        index = end;
+    }
+
+    if (index < length)
+    {
+        if (buffer[index] != REG_DELIMITER) return -1;
+        index++;
+    }
+    *indexP = index;
+
+    return 1;
+}
+
+int linkformat_nextAttribute(uint8_t * buffer,
+                             size_t length,
+                             size_t * indexP,
+                             uint8_t ** keyP,
+                             size_t * keyLengthP,
+                             uint8_t ** valueP,
+                             size_t * valueLengthP)
+{
+    size_t index;
+    size_t equals;
+    size_t end;
+
+    index = prv_skipSpaces(buffer, length, *indexP);
+    if (index == length) return 0;
+
+    end = prv_find(buffer, length, index, REG_ATTR_SEPARATOR);
+    equals = prv_find(buffer, end, index, REG_ATTR_EQUALS);
+    if (equals == index || equals == end) return -1;
+
+    *keyP = buffer + index;
+    *keyLengthP = prv_trimSpaces(buffer, index, equals) - index;
+
+    index = prv_skipSpaces(buffer, end, equals + 1);
+    if (index == end) return -1;
+    *valueP = buffer + index;
+    *valueLengthP = prv_trimSpaces(buffer, index, end) - index;
+
+    *indexP = end < length ? end + 1 : end;
+
+    return 1;
+}
@@ -366,8 +366,6 @@ static void prv_resultCallback(lwm2m_context_t * contextP,
 {
     dm_data_t * dataP = (dm_data_t *)transacP->userData;
 
-    (void)contextP; /* unused */
-
     if (message == NULL)
     {
         dataP->callback(dataP->clientID,
@@ -425,7 +423,7 @@ static void prv_resultCallback(lwm2m_context_t * contextP,
                         packet->payload_len,
                         dataP->userData);
     }
-    lwm2m_free(dataP);
+    pool_release(&contextP->dmDataPool, dataP);
 }
 
 static int prv_makeOperation(lwm2m_context_t * contextP,
@@ -442,10 +440,10 @@ static int prv_makeOperation(lwm2m_context_t * contextP,
     lwm2m_transaction_t * transaction;
     dm_data_t * dataP;
 
-    clientP = (lwm2m_client_t *)lwm2m_list_find((lwm2m_list_t *)contextP->clientList, clientID);
+    clientP = lwm2m_get_client(contextP, clientID);
     if (clientP == NULL) return COAP_404_NOT_FOUND;
 
-    transaction = transaction_new(clientP->sessionH, method, clientP->altPath, uriP, contextP->nextMID++, 4, NULL);
+    transaction = transaction_new(contextP, clientP->sessionH, method, clientP->altPath, uriP, contextP->nextMID++, 4, NULL);
     if (transaction == NULL) return COAP_500_INTERNAL_SERVER_ERROR;
 
     if (method == COAP_GET)
@@ -461,10 +459,10 @@ static int prv_makeOperation(lwm2m_context_t * contextP,
 
     if (callback != NULL)
     {
-        dataP = (dm_data_t *)lwm2m_malloc(sizeof(dm_data_t));
+        dataP = (dm_data_t *)pool_alloc(&contextP->dmDataPool);
         if (dataP == NULL)
         {
-            transaction_free(transaction);
+            transaction_free(contextP, transaction);
             return COAP_500_INTERNAL_SERVER_ERROR;
         }
         memcpy(&dataP->uri, uriP, sizeof(lwm2m_uri_t));
@@ -476,7 +474,7 @@ static int prv_makeOperation(lwm2m_context_t * contextP,
         transaction->userData = (void *)dataP;
     }
 
-    contextP->transactionList = (lwm2m_transaction_t *)LWM2M_LIST_ADD(contextP->transactionList, transaction);
+    transaction_add(contextP, transaction);
 
     return transaction_send(contextP, transaction);
 }
@@ -492,7 +490,7 @@ int lwm2m_dm_read(lwm2m_context_t * contextP,
     LOG_ARG("clientID: %d", clientID);
     LOG_URI(uriP);
 
-    clientP = (lwm2m_client_t *)lwm2m_list_find((lwm2m_list_t *)contextP->clientList, clientID);
+    clientP = lwm2m_get_client(contextP, clientID);
     if (clientP == NULL) return COAP_404_NOT_FOUND;
 
     return prv_makeOperation(contextP, clientID, uriP,
@@ -624,20 +622,20 @@ int lwm2m_dm_write_attributes(lwm2m_context_t * contextP,
     if (ATTR_FLAG_NUMERIC == (attrP->toSet & ATTR_FLAG_NUMERIC)
      && (attrP->lessThan + 2 * attrP->step >= attrP->greaterThan)) return COAP_400_BAD_REQUEST;
 
-    clientP = (lwm2m_client_t *)lwm2m_list_find((lwm2m_list_t *)contextP->clientList, clientID);
+    clientP = lwm2m_get_client(contextP, clientID);
     if (clientP == NULL) return COAP_404_NOT_FOUND;
 
-    transaction = transaction_new(clientP->sessionH, COAP_PUT, clientP->altPath, uriP, contextP->nextMID++, 4, NULL);
+    transaction = transaction_new(contextP, clientP->sessionH, COAP_PUT, clientP->altPath, uriP, contextP->nextMID++, 4, NULL);
     if (transaction == NULL) return COAP_500_INTERNAL_SERVER_ERROR;
 
     if (callback != NULL)
     {
         dm_data_t * dataP;
 
-        dataP = (dm_data_t *)lwm2m_malloc(sizeof(dm_data_t));
+        dataP = (dm_data_t *)pool_alloc(&contextP->dmDataPool);
         if (dataP == NULL)
         {
-            transaction_free(transaction);
+            transaction_free(contextP, transaction);
             return COAP_500_INTERNAL_SERVER_ERROR;
         }
         memcpy(&dataP->uri, uriP, sizeof(lwm2m_uri_t));
@@ -657,7 +655,7 @@ int lwm2m_dm_write_attributes(lwm2m_context_t * contextP,
         length = utils_intToText(attrP->minPeriod, buffer + ATTR_MIN_PERIOD_LEN, _PRV_BUFFER_SIZE - ATTR_MIN_PERIOD_LEN);
         if (length == 0)
         {
-            transaction_free(transaction);
+            transaction_free(contextP, transaction);
             return COAP_500_INTERNAL_SERVER_ERROR;
         }
         coap_add_multi_option(&(coap_pkt->uri_query), buffer, ATTR_MIN_PERIOD_LEN + length, 0);
@@ -669,7 +667,7 @@ int lwm2m_dm_write_attributes(lwm2m_context_t * contextP,
         length = utils_intToText(attrP->maxPeriod, buffer + ATTR_MAX_PERIOD_LEN, _PRV_BUFFER_SIZE - ATTR_MAX_PERIOD_LEN);
         if (length == 0)
         {
-            transaction_free(transaction);
+            transaction_free(contextP, transaction);
             return COAP_500_INTERNAL_SERVER_ERROR;
         }
         coap_add_multi_option(&(coap_pkt->uri_query), buffer, ATTR_MAX_PERIOD_LEN + length, 0);
@@ -681,7 +679,7 @@ int lwm2m_dm_write_attributes(lwm2m_context_t * contextP,
         length = utils_floatToText(attrP->greaterThan, buffer + ATTR_GREATER_THAN_LEN, _PRV_BUFFER_SIZE - ATTR_GREATER_THAN_LEN);
         if (length == 0)
         {
-            transaction_free(transaction);
+            transaction_free(contextP, transaction);
             return COAP_500_INTERNAL_SERVER_ERROR;
         }
         coap_add_multi_option(&(coap_pkt->uri_query), buffer, ATTR_GREATER_THAN_LEN + length, 0);
@@ -693,7 +691,7 @@ int lwm2m_dm_write_attributes(lwm2m_context_t * contextP,
         length = utils_floatToText(attrP->lessThan, buffer + ATTR_LESS_THAN_LEN, _PRV_BUFFER_SIZE - ATTR_LESS_THAN_LEN);
         if (length == 0)
         {
-            transaction_free(transaction);
+            transaction_free(contextP, transaction);
             return COAP_500_INTERNAL_SERVER_ERROR;
         }
         coap_add_multi_option(&(coap_pkt->uri_query), buffer, ATTR_LESS_THAN_LEN + length, 0);
@@ -705,7 +703,7 @@ int lwm2m_dm_write_attributes(lwm2m_context_t * contextP,
         length = utils_floatToText(attrP->step, buffer + ATTR_STEP_LEN, _PRV_BUFFER_SIZE - ATTR_STEP_LEN);
         if (length == 0)
         {
-            transaction_free(transaction);
+            transaction_free(contextP, transaction);
             return COAP_500_INTERNAL_SERVER_ERROR;
         }
         coap_add_multi_option(&(coap_pkt->uri_query), buffer, ATTR_STEP_LEN + length, 0);
@@ -737,7 +735,7 @@ int lwm2m_dm_write_attributes(lwm2m_context_t * contextP,
         SET_OPTION(coap_pkt, COAP_OPTION_URI_QUERY);
     }
 
-    contextP->transactionList = (lwm2m_transaction_t *)LWM2M_LIST_ADD(contextP->transactionList, transaction);
+    transaction_add(contextP, transaction);
 
     return transaction_send(contextP, transaction);
 }
@@ -754,20 +752,20 @@ int lwm2m_dm_discover(lwm2m_context_t * contextP,
 
     LOG_ARG("clientID: %d", clientID);
     LOG_URI(uriP);
-    clientP = (lwm2m_client_t *)lwm2m_list_find((lwm2m_list_t *)contextP->clientList, clientID);
+    clientP = lwm2m_get_client(contextP, clientID);
     if (clientP == NULL) return COAP_404_NOT_FOUND;
 
-    transaction = transaction_new(clientP->sessionH, COAP_GET, clientP->altPath, uriP, contextP->nextMID++, 4, NULL);
+    transaction = transaction_new(contextP, clientP->sessionH, COAP_GET, clientP->altPath, uriP, contextP->nextMID++, 4, NULL);
     if (transaction == NULL) return COAP_500_INTERNAL_SERVER_ERROR;
 
     coap_set_header_accept(transaction->message, LWM2M_CONTENT_LINK);
 
     if (callback != NULL)
     {
-        dataP = (dm_data_t *)lwm2m_malloc(sizeof(dm_data_t));
+        dataP = (dm_data_t *)pool_alloc(&contextP->dmDataPool);
         if (dataP == NULL)
         {
-            transaction_free(transaction);
+            transaction_free(contextP, transaction);
             return COAP_500_INTERNAL_SERVER_ERROR;
         }
         memcpy(&dataP->uri, uriP, sizeof(lwm2m_uri_t));
@@ -779,7 +777,7 @@ int lwm2m_dm_discover(lwm2m_context_t * contextP,
         transaction->userData = (void *)dataP;
     }
 
-    contextP->transactionList = (lwm2m_transaction_t *)LWM2M_LIST_ADD(contextP->transactionList, transaction);
+    transaction_add(contextP, transaction);
 
     return transaction_send(contextP, transaction);
 }
@@ -53,30 +53,176 @@
 
 
 #ifdef LWM2M_CLIENT_MODE
+// Returns the number of levels set in the URI and their IDs.
+static int prv_getUriIds(lwm2m_uri_t * uriP,
+                         uint16_t * ids)
+{
+    int depth = 0;
+
+    if (!LWM2M_URI_IS_SET_OBJECT(uriP)) return 0;
+    ids[depth++] = uriP->objectId;
+    if (!LWM2M_URI_IS_SET_INSTANCE(uriP)) return depth;
+    ids[depth++] = uriP->instanceId;
+    if (!LWM2M_URI_IS_SET_RESOURCE(uriP)) return depth;
+    ids[depth++] = uriP->resourceId;
+#ifndef LWM2M_VERSION_1_0
+    if (!LWM2M_URI_IS_SET_RESOURCE_INSTANCE(uriP)) return depth;
+    ids[depth++] = uriP->resourceInstanceId;
+#endif
+
+    return depth;
+}
+
+static uint32_t prv_hashNode(lwm2m_uri_node_t * parentP,
+                             uint16_t id)
+{
+    return hash_integer((uint32_t)(uintptr_t)parentP ^ ((uint32_t)id << 16 | id));
+}
+
+static lwm2m_uri_node_t * prv_findNode(lwm2m_context_t * contextP,
+                                       lwm2m_uri_node_t * parentP,
+                                       uint16_t id)
+{
+    lwm2m_hash_link_t * linkP;
+
+    for (linkP = hash_find(&contextP->observedNodeTable, prv_hashNode(parentP, id)) ;
+         linkP != NULL ;
+         linkP = hash_findNext(linkP))
+    {
+        lwm2m_uri_node_t * nodeP = (lwm2m_uri_node_t *)linkP->itemP;
+
+        if (nodeP->parent == parentP && nodeP->id == id) return nodeP;
+    }
+
+    return NULL;
+}
+
+// Frees the nodes left without observation nor children from nodeP to the root.
+static void prv_releaseNode(lwm2m_context_t * contextP,
+                            lwm2m_uri_node_t * nodeP)
+{
+    while (nodeP != NULL
+        && nodeP->observed == NULL
+        && nodeP->children == NULL)
+    {
+        lwm2m_uri_node_t * parentP = nodeP->parent;
+
+        if (nodeP->prev != NULL)
+        {
+            nodeP->prev->next = nodeP->next;
+        }
+        else if (parentP != NULL)
+        {
+            parentP->children = nodeP->next;
+        }
+        if (nodeP->next != NULL) nodeP->next->prev = nodeP->prev;
+        hash_remove(&contextP->observedNodeTable, &nodeP->link);
+        lwm2m_free(nodeP);
+
+        nodeP = parentP;
+    }
+}
+
+// Returns the node of the URI, creating the missing levels if create is true.
+static lwm2m_uri_node_t * prv_getNode(lwm2m_context_t * contextP,
+                                      lwm2m_uri_t * uriP,
+                                      bool create)
+{
+    uint16_t ids[4];
+    int depth;
+    int i;
+    lwm2m_uri_node_t * nodeP = NULL;
+
+    depth = prv_getUriIds(uriP, ids);
+    if (depth == 0) return NULL;
+
+    for (i = 0 ; i < depth ; i++)
+    {
+        lwm2m_uri_node_t * childP;
+
+        childP = prv_findNode(contextP, nodeP, ids[i]);
+        if (childP == NULL)
+        {
+            if (create == false) return NULL;
+
+            childP = (lwm2m_uri_node_t *)lwm2m_malloc(sizeof(lwm2m_uri_node_t));
+            if (childP == NULL)
+            {
+                prv_releaseNode(contextP, nodeP);
+                return NULL;
+            }
+            memset(childP, 0, sizeof(lwm2m_uri_node_t));
+            childP->id = ids[i];
+            childP->parent = nodeP;
+            if (nodeP != NULL)
+            {
+                childP->next = nodeP->children;
+                if (nodeP->children != NULL) nodeP->children->prev = childP;
+                nodeP->children = childP;
+            }
+            hash_add(&contextP->observedNodeTable, &childP->link, prv_hashNode(nodeP, ids[i]), childP);
+        }
+        nodeP = childP;
+    }
+
+    return nodeP;
+}
+
 static lwm2m_observed_t * prv_findObserved(lwm2m_context_t * contextP,
                                            lwm2m_uri_t * uriP)
 {
-    lwm2m_observed_t * targetP;
+    lwm2m_uri_node_t * nodeP;
 
-    targetP = contextP->observedList;
-    while (targetP != NULL
-        && ((LWM2M_URI_IS_SET_OBJECT(uriP) && targetP->uri.objectId != uriP->objectId)
-         || (LWM2M_URI_IS_SET_INSTANCE(uriP) && targetP->uri.instanceId != uriP->instanceId)
-         || (LWM2M_URI_IS_SET_RESOURCE(uriP) && targetP->uri.resourceId != uriP->resourceId)
-#ifndef LWM2M_VERSION_1_0
-         || (LWM2M_URI_IS_SET_RESOURCE_INSTANCE(uriP) && targetP->uri.resourceInstanceId != uriP->resourceInstanceId)
-#endif
-           ))
+    nodeP = prv_getNode(contextP, uriP, false);
+    if (nodeP == NULL) return NULL;
+
+    return nodeP->observed;
+}
+
+static bool prv_isScalar(const lwm2m_data_t * dataP)
+{
+    switch (dataP->type)
     {
-        targetP = targetP->next;
+    case LWM2M_TYPE_INTEGER:
+    case LWM2M_TYPE_UNSIGNED_INTEGER:
+    case LWM2M_TYPE_FLOAT:
+    case LWM2M_TYPE_BOOLEAN:
+    case LWM2M_TYPE_OBJECT_LINK:
+        return true;
+    default:
+        return false;
     }
+}
 
-    return targetP;
+static void prv_freeValue(lwm2m_observed_t * observedP)
+{
+    if (observedP->valueP != NULL)
+    {
+        lwm2m_data_free(1, observedP->valueP);
+        observedP->valueP = NULL;
+    }
+    observedP->valueSet = false;
+}
+
+// Forgets the given value. The storage of a numeric value is kept for the next one.
+static void prv_dropValue(lwm2m_observed_t * observedP)
+{
+    if (observedP->valueP != NULL
+     && !prv_isScalar(observedP->valueP))
+    {
+        prv_freeValue(observedP);
+    }
+    observedP->valueSet = false;
 }
 
 static void prv_unlinkObserved(lwm2m_context_t * contextP,
                                lwm2m_observed_t * observedP)
 {
+    prv_freeValue(observedP);
+    observedP->node->observed = NULL;
+    prv_releaseNode(contextP, observedP->node);
+    observedP->node = NULL;
+
     if (contextP->observedList == observedP)
     {
         contextP->observedList = contextP->observedList->next;
@@ -113,6 +259,50 @@ static lwm2m_watcher_t * prv_findWatcher(lwm2m_observed_t * observedP,
     return targetP;
 }
 
+// Schedules the next check of the notification conditions of the watcher:
+// when its minimal period elapses after a change, when its maximal period
+// elapses, or at once after a change without minimal period.
+static void prv_scheduleWatcher(lwm2m_context_t * contextP,
+                                lwm2m_watcher_t * watcherP,
+                                time_t currentTime,
+                                bool changed)
+{
+    lwm2m_attributes_t * paramP = watcherP->parameters;
+    int64_t deadline = -1;
+
+    if (watcherP->active == true)
+    {
+        if (watcherP->update == true)
+        {
+            if (paramP != NULL && (paramP->toSet & LWM2M_ATTR_FLAG_MIN_PERIOD) != 0)
+            {
+                deadline = watcherP->lastTime + paramP->minPeriod;
+            }
+            else if (changed == true)
+            {
+                deadline = currentTime;
+            }
+        }
+        if (paramP != NULL && (paramP->toSet & LWM2M_ATTR_FLAG_MAX_PERIOD) != 0
+         && (deadline < 0 || deadline > watcherP->lastTime + paramP->maxPeriod))
+        {
+            deadline = watcherP->lastTime + paramP->maxPeriod;
+        }
+    }
+
+    if (deadline < 0)
+    {
+        timer_cancel(&contextP->observeTimers, &watcherP->timer);
+        return;
+    }
+    // a watcher checked in this step waits for the next one
+    if (changed == false && deadline <= currentTime) deadline = currentTime + 1;
+    if (!timer_schedule(&contextP->observeTimers, &watcherP->timer, deadline, watcherP))
+    {
+        LOG("Failed to schedule the watcher");
+    }
+}
+
 static lwm2m_watcher_t * prv_getWatcher(lwm2m_context_t * contextP,
                                         lwm2m_uri_t * uriP,
                                         lwm2m_server_t * serverP)
@@ -126,11 +316,21 @@ static lwm2m_watcher_t * prv_getWatcher(lwm2m_context_t * contextP,
     observedP = prv_findObserved(contextP, uriP);
     if (observedP == NULL)
     {
+        lwm2m_uri_node_t * nodeP;
+
+        nodeP = prv_getNode(contextP, uriP, true);
+        if (nodeP == NULL) return NULL;
         observedP = (lwm2m_observed_t *)lwm2m_malloc(sizeof(lwm2m_observed_t));
-        if (observedP == NULL) return NULL;
+        if (observedP == NULL)
+        {
+            prv_releaseNode(contextP, nodeP);
+            return NULL;
+        }
         allocatedObserver = true;
         memset(observedP, 0, sizeof(lwm2m_observed_t));
         memcpy(&(observedP->uri), uriP, sizeof(lwm2m_uri_t));
+        observedP->node = nodeP;
+        nodeP->observed = observedP;
         observedP->next = contextP->observedList;
         contextP->observedList = observedP;
     }
@@ -143,12 +343,14 @@ static lwm2m_watcher_t * prv_getWatcher(lwm2m_context_t * contextP,
         {
             if (allocatedObserver == true)
             {
+                prv_unlinkObserved(contextP, observedP);
                 lwm2m_free(observedP);
             }
             return NULL;
         }
         memset(watcherP, 0, sizeof(lwm2m_watcher_t));
         watcherP->active = false;
+        watcherP->observed = observedP;
         watcherP->server = serverP;
         watcherP->next = observedP->watcherList;
         observedP->watcherList = watcherP;
@@ -188,7 +390,7 @@ uint8_t observe_handleRequest(lwm2m_context_t * contextP,
         watcherP->tokenLen = message->token_len;
         memcpy(watcherP->token, message->token, message->token_len);
         watcherP->active = true;
-        watcherP->lastTime = lwm2m_gettime();
+        watcherP->lastTime = utils_gettime();
         watcherP->lastMid = response->mid;
         if (IS_OPTION(message, COAP_OPTION_ACCEPT))
         {
@@ -217,6 +419,7 @@ uint8_t observe_handleRequest(lwm2m_context_t * contextP,
             }
         }
 
+        prv_scheduleWatcher(contextP, watcherP, watcherP->lastTime, false);
         coap_set_header_observe(response, watcherP->counter++);
 
         return COAP_205_CONTENT;
@@ -278,6 +481,7 @@ void observe_cancel(lwm2m_context_t * contextP,
         }
         if (targetP != NULL)
         {
+            timer_cancel(&contextP->observeTimers, &targetP->timer);
             if (targetP->parameters != NULL) lwm2m_free(targetP->parameters);
             lwm2m_free(targetP);
             if (observedP->watcherList == NULL)
@@ -290,6 +494,33 @@ void observe_cancel(lwm2m_context_t * contextP,
     }
 }
 
+void observe_clearAll(lwm2m_context_t * contextP)
+{
+    LOG("Entering");
+    // the timers are reset in the watchers
+    timer_free(&contextP->observeTimers);
+    while (NULL != contextP->observedList)
+    {
+        lwm2m_observed_t * targetP;
+        lwm2m_watcher_t * watcherP;
+
+        targetP = contextP->observedList;
+        contextP->observedList = contextP->observedList->next;
+
+        for (watcherP = targetP->watcherList ; watcherP != NULL ; watcherP = watcherP->next)
+        {
+            if (watcherP->parameters != NULL) lwm2m_free(watcherP->parameters);
+        }
+        LWM2M_LIST_FREE(targetP->watcherList);
+
+        prv_freeValue(targetP);
+        targetP->node->observed = NULL;
+        prv_releaseNode(contextP, targetP->node);
+        lwm2m_free(targetP);
+    }
+    hash_free(&contextP->observedNodeTable);
+}
+
 void observe_clear(lwm2m_context_t * contextP,
                    lwm2m_uri_t * uriP)
 {
@@ -311,6 +542,7 @@ void observe_clear(lwm2m_context_t * contextP,
 
             for (watcherP = observedP->watcherList; watcherP != NULL; watcherP = watcherP->next)
             {
+                timer_cancel(&contextP->observeTimers, &watcherP->timer);
                 if (watcherP->parameters != NULL) lwm2m_free(watcherP->parameters);
             }
             LWM2M_LIST_FREE(observedP->watcherList);
@@ -419,6 +651,9 @@ uint8_t observe_setParameters(lwm2m_context_t * contextP,
     LOG_ARG("Final toSet: %08X, minPeriod: %d, maxPeriod: %d, greaterThan: %f, lessThan: %f, step: %f",
             watcherP->parameters->toSet, watcherP->parameters->minPeriod, watcherP->parameters->maxPeriod, watcherP->parameters->greaterThan, watcherP->parameters->lessThan, watcherP->parameters->step);
 
+    // the periods may have changed
+    prv_scheduleWatcher(contextP, watcherP, utils_gettime(), watcherP->update);
+
     return COAP_204_CHANGED;
 }
 
@@ -428,401 +663,822 @@ lwm2m_observed_t * observe_findByUri(lwm2m_context_t * contextP,
     lwm2m_observed_t * targetP;
 
     LOG_URI(uriP);
-    targetP = contextP->observedList;
-    while (targetP != NULL)
+    targetP = prv_findObserved(contextP, uriP);
+    if (targetP == NULL)
     {
-        if (targetP->uri.objectId == uriP->objectId)
+        LOG("Found nothing");
+        return NULL;
+    }
+
+    LOG_ARG("Found one with%s observers.", targetP->watcherList ? "" : " no");
+    LOG_URI(&(targetP->uri));
+    return targetP;
+}
+
+static void prv_tagObserved(lwm2m_context_t * contextP,
+                            lwm2m_observed_t * targetP,
+                            time_t currentTime)
+{
+    lwm2m_watcher_t * watcherP;
+
+    LOG("Found an observation");
+    LOG_URI(&(targetP->uri));
+
+    for (watcherP = targetP->watcherList ; watcherP != NULL ; watcherP = watcherP->next)
+    {
+        if (watcherP->active == true)
         {
-            if ((!LWM2M_URI_IS_SET_INSTANCE(uriP) && !LWM2M_URI_IS_SET_INSTANCE(&(targetP->uri)))
-             || (LWM2M_URI_IS_SET_INSTANCE(uriP) && LWM2M_URI_IS_SET_INSTANCE(&(targetP->uri)) && (uriP->instanceId == targetP->uri.instanceId)))
-             {
-                 if ((!LWM2M_URI_IS_SET_RESOURCE(uriP) && !LWM2M_URI_IS_SET_RESOURCE(&(targetP->uri)))
-                     || (LWM2M_URI_IS_SET_RESOURCE(uriP) && LWM2M_URI_IS_SET_RESOURCE(&(targetP->uri)) && (uriP->resourceId == targetP->uri.resourceId)))
-                 {
-#ifndef LWM2M_VERSION_1_0
-                     if ((!LWM2M_URI_IS_SET_RESOURCE_INSTANCE(uriP) && !LWM2M_URI_IS_SET_RESOURCE_INSTANCE(&(targetP->uri)))
-                      || (LWM2M_URI_IS_SET_RESOURCE_INSTANCE(uriP) && LWM2M_URI_IS_SET_RESOURCE_INSTANCE(&(targetP->uri)) && (uriP->resourceInstanceId == targetP->uri.resourceInstanceId)))
-#endif
-                     {
-                         LOG_ARG("Found one with%s observers.", targetP->watcherList ? "" : " no");
-                         LOG_URI(&(targetP->uri));
-                         return targetP;
-                     }
-                 }
-             }
+            LOG("Tagging a watcher");
+            // a watcher tagged several times before the next step is notified once
+            if (watcherP->update == true
+             && watcherP->timer.index != 0
+             && watcherP->timer.time <= currentTime)
+            {
+                continue;
+            }
+            watcherP->update = true;
+            prv_scheduleWatcher(contextP, watcherP, currentTime, true);
         }
-        targetP = targetP->next;
     }
+}
 
-    LOG("Found nothing");
-    return NULL;
+static void prv_tagSubtree(lwm2m_context_t * contextP,
+                           lwm2m_uri_node_t * nodeP,
+                           time_t currentTime)
+{
+    lwm2m_uri_node_t * childP;
+
+    for (childP = nodeP->children ; childP != NULL ; childP = childP->next)
+    {
+        if (childP->observed != NULL)
+        {
+            prv_dropValue(childP->observed);
+            prv_tagObserved(contextP, childP->observed, currentTime);
+        }
+        prv_tagSubtree(contextP, childP, currentTime);
+    }
 }
 
-void lwm2m_resource_value_changed(lwm2m_context_t * contextP,
-                                  lwm2m_uri_t * uriP)
+static bool prv_copyData(lwm2m_data_t * destP,
+                         const lwm2m_data_t * srcP)
 {
-    lwm2m_observed_t * targetP;
+    size_t i;
+
+    *destP = *srcP;
+    switch (srcP->type)
+    {
+    case LWM2M_TYPE_MULTIPLE_RESOURCE:
+    case LWM2M_TYPE_OBJECT_INSTANCE:
+    case LWM2M_TYPE_OBJECT:
+        destP->value.asChildren.array = NULL;
+        if (srcP->value.asChildren.count == 0) return true;
+        destP->value.asChildren.array = lwm2m_data_new((int)srcP->value.asChildren.count);
+        if (destP->value.asChildren.array == NULL) return false;
+        for (i = 0 ; i < srcP->value.asChildren.count ; i++)
+        {
+            if (!prv_copyData(destP->value.asChildren.array + i, srcP->value.asChildren.array + i)) return false;
+        }
+        break;
+
+    case LWM2M_TYPE_STRING:
+    case LWM2M_TYPE_OPAQUE:
+    case LWM2M_TYPE_CORE_LINK:
+        destP->value.asBuffer.buffer = NULL;
+        if (srcP->value.asBuffer.length == 0) return true;
+        destP->value.asBuffer.buffer = (uint8_t *)lwm2m_malloc(srcP->value.asBuffer.length);
+        if (destP->value.asBuffer.buffer == NULL) return false;
+        memcpy(destP->value.asBuffer.buffer, srcP->value.asBuffer.buffer, srcP->value.asBuffer.length);
+        break;
+
+    default:
+        break;
+    }
+
+    return true;
+}
+
+// Keeps a copy of the new value of the observed resource.
+static void prv_setValue(lwm2m_observed_t * observedP,
+                         lwm2m_data_t * dataP)
+{
+    if (observedP->valueP != NULL
+     && prv_isScalar(observedP->valueP)
+     && prv_isScalar(dataP))
+    {
+        // no allocation for the numeric values
+        *observedP->valueP = *dataP;
+    }
+    else
+    {
+        prv_freeValue(observedP);
+        observedP->valueP = lwm2m_data_new(1);
+        if (observedP->valueP == NULL) return;
+        if (!prv_copyData(observedP->valueP, dataP))
+        {
+            // the resource will be read from the object
+            prv_freeValue(observedP);
+            return;
+        }
+    }
+    observedP->valueP->id = observedP->uri.resourceId;
+    observedP->valueSet = true;
+}
+
+// Marks the watchers of the URI, of its parents and of its children.
+// dataP is the new value of the resource URI, or NULL when it has to be read.
+static void prv_valueChanged(lwm2m_context_t * contextP,
+                             lwm2m_uri_t * uriP,
+                             lwm2m_data_t * dataP,
+                             time_t currentTime)
+{
+    uint16_t ids[4];
+    int depth;
+    int i;
+    lwm2m_uri_node_t * nodeP;
 
     LOG_URI(uriP);
-    targetP = contextP->observedList;
-    while (targetP != NULL)
+    depth = prv_getUriIds(uriP, ids);
+    nodeP = NULL;
+    for (i = 0 ; i < depth ; i++)
     {
-        if (targetP->uri.objectId == uriP->objectId)
+        nodeP = prv_findNode(contextP, nodeP, ids[i]);
+        if (nodeP == NULL) return;
+        if (nodeP->observed != NULL)
         {
-            if (!LWM2M_URI_IS_SET_INSTANCE(uriP)
-             || !LWM2M_URI_IS_SET_INSTANCE(&targetP->uri)
-             || uriP->instanceId == targetP->uri.instanceId)
+            if (dataP != NULL && i == depth - 1)
             {
-                if (!LWM2M_URI_IS_SET_RESOURCE(uriP)
-                 || !LWM2M_URI_IS_SET_RESOURCE(&targetP->uri)
-                 || uriP->resourceId == targetP->uri.resourceId)
-                {
+                prv_setValue(nodeP->observed, dataP);
+            }
+            else
+            {
+                prv_dropValue(nodeP->observed);
+            }
+            prv_tagObserved(contextP, nodeP->observed, currentTime);
+        }
+    }
+
+    if (nodeP != NULL) prv_tagSubtree(contextP, nodeP, currentTime);
+}
+
+static time_t prv_getChangeTime(void)
+{
+    time_t currentTime;
+
+    // on failure, the changes are checked in the next step
+    currentTime = utils_gettime();
+    if (currentTime < 0) currentTime = 0;
+
+    return currentTime;
+}
+
+void lwm2m_resource_value_changed(lwm2m_context_t * contextP,
+                                  lwm2m_uri_t * uriP)
+{
+    prv_valueChanged(contextP, uriP, NULL, prv_getChangeTime());
+}
+
+void lwm2m_resources_value_changed(lwm2m_context_t * contextP,
+                                   lwm2m_uri_t * uriList,
+                                   size_t count)
+{
+    time_t currentTime;
+    size_t i;
+
+    LOG_ARG("count: %u", (unsigned int)count);
+    if (contextP->observedList == NULL) return;
+
+    currentTime = prv_getChangeTime();
+    for (i = 0 ; i < count ; i++)
+    {
+        prv_valueChanged(contextP, uriList + i, NULL, currentTime);
+    }
+}
+
+void lwm2m_resource_value_push(lwm2m_context_t * contextP,
+                               lwm2m_uri_t * uriP,
+                               lwm2m_data_t * dataP)
+{
+    if (!LWM2M_URI_IS_SET_RESOURCE(uriP)
 #ifndef LWM2M_VERSION_1_0
-                    if (!LWM2M_URI_IS_SET_RESOURCE_INSTANCE(uriP)
-                     || !LWM2M_URI_IS_SET_RESOURCE_INSTANCE(&targetP->uri)
-                     || uriP->resourceInstanceId == targetP->uri.resourceInstanceId)
+     || LWM2M_URI_IS_SET_RESOURCE_INSTANCE(uriP)
 #endif
-                    {
-                        lwm2m_watcher_t * watcherP;
+       )
+    {
+        // only the resource values are kept
+        dataP = NULL;
+    }
+    prv_valueChanged(contextP, uriP, dataP, prv_getChangeTime());
+}
 
-                        LOG("Found an observation");
-                        LOG_URI(&(targetP->uri));
+#ifdef LWM2M_SUPPORT_SENML_JSON
+void lwm2m_set_composite_notifications(lwm2m_context_t * contextP,
+                                       bool enable)
+{
+    LOG_ARG("enable: %d", enable);
+    contextP->compositeNotifications = enable;
+}
+#endif
 
-                        for (watcherP = targetP->watcherList ; watcherP != NULL ; watcherP = watcherP->next)
-                        {
-                            if (watcherP->active == true)
-                            {
-                                LOG("Tagging a watcher");
-                                watcherP->update = true;
-                            }
-                        }
-                    }
-                }
-            }
+// Frees the value read from the object. A given value is only checked once:
+// the resource is read from the object in the next checks.
+static void prv_releaseData(lwm2m_observed_t * targetP,
+                            int size,
+                            lwm2m_data_t * dataP)
+{
+    if (dataP == targetP->valueP)
+    {
+        prv_dropValue(targetP);
+    }
+    else
+    {
+        lwm2m_data_free(size, dataP);
+    }
+}
+
+// Retries the observation in the next step after a read failure.
+static void prv_retryObserved(lwm2m_context_t * contextP,
+                              lwm2m_observed_t * targetP,
+                              time_t currentTime)
+{
+    lwm2m_watcher_t * watcherP;
+
+    for (watcherP = targetP->watcherList ; watcherP != NULL ; watcherP = watcherP->next)
+    {
+        if (watcherP->active == true)
+        {
+            (void)timer_schedule(&contextP->observeTimers, &watcherP->timer, currentTime + 1, watcherP);
         }
-        targetP = targetP->next;
     }
 }
 
-void observe_step(lwm2m_context_t * contextP,
-                  time_t currentTime,
-                  time_t * timeoutP)
+// notifications waiting for the end of the step, in the composite mode
+typedef struct
 {
-    lwm2m_observed_t * targetP;
+    lwm2m_watcher_t * watcherP;
+    uint8_t *         buffer;     // SenML-JSON pack of the observed URI
+    size_t            length;
+} composite_item_t;
 
-    LOG("Entering");
-    for (targetP = contextP->observedList ; targetP != NULL ; targetP = targetP->next)
+typedef struct
+{
+    composite_item_t * items;
+    size_t             count;
+    size_t             size;
+} composite_list_t;
+
+#ifdef LWM2M_SUPPORT_SENML_JSON
+#define COMPOSITE_LIST_MIN_SIZE 8
+// the packed records and the message header fit in the send buffer
+#define COMPOSITE_MAX_LENGTH    (LWM2M_SEND_BUFFER_SIZE - COAP_MAX_HEADER_SIZE)
+
+// Queues the notification of the watcher. Returns false if it must be sent alone.
+static bool prv_addComposite(lwm2m_context_t * contextP,
+                             composite_list_t * listP,
+                             lwm2m_observed_t * targetP,
+                             lwm2m_watcher_t * watcherP,
+                             int * sizeP,
+                             lwm2m_data_t ** dataP)
+{
+    composite_item_t * itemP;
+    uint8_t * buffer;
+    int res;
+
+    // the server splits the packed records by their base name
+    if (watcherP->format != LWM2M_CONTENT_SENML_JSON) return false;
+
+    if (listP->count == listP->size)
     {
-        lwm2m_watcher_t * watcherP;
-        uint8_t * buffer = NULL;
-        size_t length = 0;
-        lwm2m_data_t * dataP = NULL;
-        int size = 0;
-        double floatValue = 0;
-        int64_t integerValue = 0;
-        uint64_t unsignedValue = 0;
-        bool storeValue = false;
-        coap_packet_t message[1];
-        time_t interval;
-
-        // TODO: handle resource instances
-
-        LOG_URI(&(targetP->uri));
-        if (LWM2M_URI_IS_SET_RESOURCE(&targetP->uri))
+        composite_item_t * itemsP;
+        size_t size;
+
+        size = listP->size == 0 ? COMPOSITE_LIST_MIN_SIZE : listP->size * 2;
+        itemsP = (composite_item_t *)lwm2m_malloc(size * sizeof(composite_item_t));
+        if (itemsP == NULL) return false;
+        if (listP->count != 0) memcpy(itemsP, listP->items, listP->count * sizeof(composite_item_t));
+        if (listP->items != NULL) lwm2m_free(listP->items);
+        listP->items = itemsP;
+        listP->size = size;
+    }
+
+    // the watchers of an observation are checked one after the other
+    if (listP->count != 0
+     && listP->items[listP->count - 1].watcherP->observed == targetP)
+    {
+        res = (int)listP->items[listP->count - 1].length;
+        buffer = (uint8_t *)lwm2m_malloc(res);
+        if (buffer == NULL) return false;
+        memcpy(buffer, listP->items[listP->count - 1].buffer, res);
+    }
+    else
+    {
+        if (*dataP == NULL
+         && COAP_205_CONTENT != object_readData(contextP, &targetP->uri, sizeP, dataP))
         {
-            if (COAP_205_CONTENT != object_readData(contextP, &targetP->uri, &size, &dataP)) continue;
-            switch (dataP->type)
+            *dataP = NULL;
+            return false;
+        }
+        buffer = NULL;
+        res = senml_json_serialize(&targetP->uri, *sizeP, *dataP, &buffer);
+        if (res <= 2)
+        {
+            if (buffer != NULL) lwm2m_free(buffer);
+            return false;
+        }
+    }
+
+    itemP = listP->items + listP->count;
+    itemP->watcherP = watcherP;
+    itemP->buffer = buffer;
+    itemP->length = (size_t)res;
+    listP->count++;
+
+    return true;
+}
+
+static void prv_sendNotification(lwm2m_context_t * contextP,
+                                 lwm2m_watcher_t * watcherP,
+                                 uint8_t * buffer,
+                                 size_t length)
+{
+    coap_packet_t message[1];
+
+    coap_init_message(message, COAP_TYPE_NON, COAP_205_CONTENT, watcherP->lastMid);
+    coap_set_header_content_type(message, LWM2M_CONTENT_SENML_JSON);
+    coap_set_payload(message, buffer, length);
+    coap_set_header_token(message, watcherP->token, watcherP->tokenLen);
+    coap_set_header_observe(message, watcherP->counter++);
+    (void)message_send(contextP, message, watcherP->server->sessionH);
+}
+
+// Tells if the records of the item j are packed in the message of the item i which
+// already holds length bytes.
+static bool prv_isPacked(composite_list_t * listP,
+                         size_t i,
+                         size_t j,
+                         size_t length)
+{
+    return listP->items[j].buffer != NULL
+        && listP->items[j].watcherP->server == listP->items[i].watcherP->server
+        && length + listP->items[j].length - 1 <= COMPOSITE_MAX_LENGTH;
+}
+
+// Sends the queued notifications of each server in as few messages as possible, each
+// with the records of several notifications up to COMPOSITE_MAX_LENGTH bytes.
+static void prv_sendComposite(lwm2m_context_t * contextP,
+                              composite_list_t * listP)
+{
+    size_t i;
+    size_t j;
+
+    for (i = 0 ; i < listP->count ; i++)
+    {
+        lwm2m_watcher_t * firstP;
+        uint8_t * buffer;
+        size_t length;
+        size_t head;
+
+        if (listP->items[i].buffer == NULL) continue;
+        firstP = listP->items[i].watcherP;
+
+        // the records without the brackets, and a separator or the closing bracket
+        length = listP->items[i].length;
+        for (j = i + 1 ; j < listP->count ; j++)
+        {
+            if (prv_isPacked(listP, i, j, length)) length += listP->items[j].length - 1;
+        }
+
+        if (length == listP->items[i].length)
+        {
+            buffer = NULL;
+        }
+        else
+        {
+            buffer = (uint8_t *)lwm2m_malloc(length);
+        }
+        if (buffer == NULL)
+        {
+            firstP->lastMid = contextP->nextMID++;
+            prv_sendNotification(contextP, firstP, listP->items[i].buffer, listP->items[i].length);
+            lwm2m_free(listP->items[i].buffer);
+            listP->items[i].buffer = NULL;
+            continue;
+        }
+
+        head = 0;
+        buffer[head++] = '[';
+        memcpy(buffer + head, listP->items[i].buffer + 1, listP->items[i].length - 2);
+        head += listP->items[i].length - 2;
+        lwm2m_free(listP->items[i].buffer);
+        listP->items[i].buffer = NULL;
+        firstP->lastMid = contextP->nextMID;
+
+        length = listP->items[i].length;
+        for (j = i + 1 ; j < listP->count ; j++)
+        {
+            composite_item_t * itemP = listP->items + j;
+
+            if (!prv_isPacked(listP, i, j, length)) continue;
+            length += itemP->length - 1;
+
+            buffer[head++] = ',';
+            memcpy(buffer + head, itemP->buffer + 1, itemP->length - 2);
+            head += itemP->length - 2;
+            lwm2m_free(itemP->buffer);
+            itemP->buffer = NULL;
+
+            itemP->watcherP->lastMid = contextP->nextMID;
+            itemP->watcherP->counter++;
+        }
+        buffer[head++] = ']';
+        contextP->nextMID++;
+
+        prv_sendNotification(contextP, firstP, buffer, head);
+        lwm2m_free(buffer);
+    }
+
+    if (listP->items != NULL) lwm2m_free(listP->items);
+}
+#endif
+
+// Reads the observed resource and notifies the watchers whose conditions are met.
+static void prv_stepObserved(lwm2m_context_t * contextP,
+                             lwm2m_observed_t * targetP,
+                             time_t currentTime,
+                             composite_list_t * compositeP)
+{
+    lwm2m_watcher_t * watcherP;
+    uint8_t * buffer = NULL;
+    size_t length = 0;
+    lwm2m_data_t * dataP = NULL;
+    int size = 0;
+    double floatValue = 0;
+    int64_t integerValue = 0;
+    uint64_t unsignedValue = 0;
+    bool storeValue = false;
+    bool readFailed = false;
+    coap_packet_t message[1];
+
+#ifndef LWM2M_SUPPORT_SENML_JSON
+    (void)compositeP; /* unused */
+#endif
+
+    // TODO: handle resource instances
+
+    LOG_URI(&(targetP->uri));
+    if (LWM2M_URI_IS_SET_RESOURCE(&targetP->uri))
+    {
+        if (targetP->valueSet == true)
+        {
+            // the value was given with the change
+            dataP = targetP->valueP;
+            size = 1;
+        }
+        else if (COAP_205_CONTENT != object_readData(contextP, &targetP->uri, &size, &dataP))
+        {
+            prv_retryObserved(contextP, targetP, currentTime);
+            return;
+        }
+        switch (dataP->type)
+        {
+        case LWM2M_TYPE_INTEGER:
+            if (1 != lwm2m_data_decode_int(dataP, &integerValue))
             {
-            case LWM2M_TYPE_INTEGER:
-                if (1 != lwm2m_data_decode_int(dataP, &integerValue))
-                {
-                    lwm2m_data_free(size, dataP);
-                    continue;
-                }
-                storeValue = true;
-                break;
-            case LWM2M_TYPE_UNSIGNED_INTEGER:
-                if (1 != lwm2m_data_decode_uint(dataP, &unsignedValue))
-                {
-                    lwm2m_data_free(size, dataP);
-                    continue;
-                }
-                storeValue = true;
-                break;
-            case LWM2M_TYPE_FLOAT:
-                if (1 != lwm2m_data_decode_float(dataP, &floatValue))
-                {
-                    lwm2m_data_free(size, dataP);
-                    continue;
-                }
-                storeValue = true;
-                break;
-            default:
-                break;
+                prv_releaseData(targetP, size, dataP);
+                prv_retryObserved(contextP, targetP, currentTime);
+                return;
+            }
+            storeValue = true;
+            break;
+        case LWM2M_TYPE_UNSIGNED_INTEGER:
+            if (1 != lwm2m_data_decode_uint(dataP, &unsignedValue))
+            {
+                prv_releaseData(targetP, size, dataP);
+                prv_retryObserved(contextP, targetP, currentTime);
+                return;
             }
+            storeValue = true;
+            break;
+        case LWM2M_TYPE_FLOAT:
+            if (1 != lwm2m_data_decode_float(dataP, &floatValue))
+            {
+                prv_releaseData(targetP, size, dataP);
+                prv_retryObserved(contextP, targetP, currentTime);
+                return;
+            }
+            storeValue = true;
+            break;
+        default:
+            break;
         }
-        for (watcherP = targetP->watcherList ; watcherP != NULL ; watcherP = watcherP->next)
+    }
+    for (watcherP = targetP->watcherList ; watcherP != NULL ; watcherP = watcherP->next)
+    {
+        if (watcherP->active == true)
         {
-            if (watcherP->active == true)
+            bool notify = false;
+
+            if (watcherP->update == true)
             {
-                bool notify = false;
+                // value changed, should we notify the server ?
 
-                if (watcherP->update == true)
+                if (watcherP->parameters == NULL || watcherP->parameters->toSet == 0)
                 {
-                    // value changed, should we notify the server ?
+                    // no conditions
+                    notify = true;
+                    LOG("Notify with no conditions");
+                    LOG_URI(&(targetP->uri));
+                }
 
-                    if (watcherP->parameters == NULL || watcherP->parameters->toSet == 0)
+                if (notify == false
+                 && watcherP->parameters != NULL
+                 && (watcherP->parameters->toSet & ATTR_FLAG_NUMERIC) != 0)
+                {
+                    if ((watcherP->parameters->toSet & LWM2M_ATTR_FLAG_LESS_THAN) != 0)
                     {
-                        // no conditions
-                        notify = true;
-                        LOG("Notify with no conditions");
-                        LOG_URI(&(targetP->uri));
+                        LOG("Checking lower threshold");
+                        // Did we cross the lower threshold ?
+                        switch (dataP->type)
+                        {
+                        case LWM2M_TYPE_INTEGER:
+                            if ((integerValue < watcherP->parameters->lessThan
+                              && watcherP->lastValue.asInteger > watcherP->parameters->lessThan)
+                             || (integerValue > watcherP->parameters->lessThan
+                              && watcherP->lastValue.asInteger < watcherP->parameters->lessThan))
+                            {
+                                LOG("Notify on lower threshold crossing");
+                                notify = true;
+                            }
+                            break;
+                        case LWM2M_TYPE_UNSIGNED_INTEGER:
+                            if ((unsignedValue < watcherP->parameters->lessThan
+                              && watcherP->lastValue.asUnsigned > watcherP->parameters->lessThan)
+                             || (unsignedValue > watcherP->parameters->lessThan
+                              && watcherP->lastValue.asUnsigned < watcherP->parameters->lessThan))
+                            {
+                                LOG("Notify on lower threshold crossing");
+                                notify = true;
+                            }
+                            break;
+                        case LWM2M_TYPE_FLOAT:
+                            if ((floatValue < watcherP->parameters->lessThan
+                              && watcherP->lastValue.asFloat > watcherP->parameters->lessThan)
+                             || (floatValue > watcherP->parameters->lessThan
+                              && watcherP->lastValue.asFloat < watcherP->parameters->lessThan))
+                            {
+                                LOG("Notify on lower threshold crossing");
+                                notify = true;
+                            }
+                            break;
+                        default:
+                            break;
+                        }
                     }
-
-                    if (notify == false
-                     && watcherP->parameters != NULL
-                     && (watcherP->parameters->toSet & ATTR_FLAG_NUMERIC) != 0)
+                    if ((watcherP->parameters->toSet & LWM2M_ATTR_FLAG_GREATER_THAN) != 0)
                     {
-                        if ((watcherP->parameters->toSet & LWM2M_ATTR_FLAG_LESS_THAN) != 0)
+                        LOG("Checking upper threshold");
+                        // Did we cross the upper threshold ?
+                        switch (dataP->type)
                         {
-                            LOG("Checking lower threshold");
-                            // Did we cross the lower threshold ?
-                            switch (dataP->type)
+                        case LWM2M_TYPE_INTEGER:
+                            if ((integerValue < watcherP->parameters->greaterThan
+                              && watcherP->lastValue.asInteger > watcherP->parameters->greaterThan)
+                             || (integerValue > watcherP->parameters->greaterThan
+                              && watcherP->lastValue.asInteger < watcherP->parameters->greaterThan))
+                            {
+                                LOG("Notify on lower upper crossing");
+                                notify = true;
+                            }
+                            break;
+                        case LWM2M_TYPE_UNSIGNED_INTEGER:
+                            if ((unsignedValue < watcherP->parameters->greaterThan
+                              && watcherP->lastValue.asUnsigned > watcherP->parameters->greaterThan)
+                             || (unsignedValue > watcherP->parameters->greaterThan
+                              && watcherP->lastValue.asUnsigned < watcherP->parameters->greaterThan))
+                            {
+                                LOG("Notify on lower upper crossing");
+                                notify = true;
+                            }
+                            break;
+                        case LWM2M_TYPE_FLOAT:
+                            if ((floatValue < watcherP->parameters->greaterThan
+                              && watcherP->lastValue.asFloat > watcherP->parameters->greaterThan)
+                             || (floatValue > watcherP->parameters->greaterThan
+                              && watcherP->lastValue.asFloat < watcherP->parameters->greaterThan))
                             {
-                            case LWM2M_TYPE_INTEGER:
-                                if ((integerValue < watcherP->parameters->lessThan
-                                  && watcherP->lastValue.asInteger > watcherP->parameters->lessThan)
-                                 || (integerValue > watcherP->parameters->lessThan
-                                  && watcherP->lastValue.asInteger < watcherP->parameters->lessThan))
-                                {
-                                    LOG("Notify on lower threshold crossing");
-                                    notify = true;
-                                }
-                                break;
-                            case LWM2M_TYPE_UNSIGNED_INTEGER:
-                                if ((unsignedValue < watcherP->parameters->lessThan
-                                  && watcherP->lastValue.asUnsigned > watcherP->parameters->lessThan)
-                                 || (unsignedValue > watcherP->parameters->lessThan
-                                  && watcherP->lastValue.asUnsigned < watcherP->parameters->lessThan))
-                                {
-                                    LOG("Notify on lower threshold crossing");
-                                    notify = true;
-                                }
-                                break;
-                            case LWM2M_TYPE_FLOAT:
-                                if ((floatValue < watcherP->parameters->lessThan
-                                  && watcherP->lastValue.asFloat > watcherP->parameters->lessThan)
-                                 || (floatValue > watcherP->parameters->lessThan
-                                  && watcherP->lastValue.asFloat < watcherP->parameters->lessThan))
-                                {
-                                    LOG("Notify on lower threshold crossing");
-                                    notify = true;
-                                }
-                                break;
-                            default:
-                                break;
+                                LOG("Notify on lower upper crossing");
+                                notify = true;
                             }
+                            break;
+                        default:
+                            break;
                         }
-                        if ((watcherP->parameters->toSet & LWM2M_ATTR_FLAG_GREATER_THAN) != 0)
+                    }
+                    if ((watcherP->parameters->toSet & LWM2M_ATTR_FLAG_STEP) != 0)
+                    {
+                        LOG("Checking step");
+
+                        switch (dataP->type)
+                        {
+                        case LWM2M_TYPE_INTEGER:
                         {
-                            LOG("Checking upper threshold");
-                            // Did we cross the upper threshold ?
-                            switch (dataP->type)
+                            int64_t diff;
+
+                            diff = integerValue - watcherP->lastValue.asInteger;
+                            if ((diff < 0 && (0 - diff) >= watcherP->parameters->step)
+                             || (diff >= 0 && diff >= watcherP->parameters->step))
                             {
-                            case LWM2M_TYPE_INTEGER:
-                                if ((integerValue < watcherP->parameters->greaterThan
-                                  && watcherP->lastValue.asInteger > watcherP->parameters->greaterThan)
-                                 || (integerValue > watcherP->parameters->greaterThan
-                                  && watcherP->lastValue.asInteger < watcherP->parameters->greaterThan))
-                                {
-                                    LOG("Notify on lower upper crossing");
-                                    notify = true;
-                                }
-                                break;
-                            case LWM2M_TYPE_UNSIGNED_INTEGER:
-                                if ((unsignedValue < watcherP->parameters->greaterThan
-                                  && watcherP->lastValue.asUnsigned > watcherP->parameters->greaterThan)
-                                 || (unsignedValue > watcherP->parameters->greaterThan
-                                  && watcherP->lastValue.asUnsigned < watcherP->parameters->greaterThan))
-                                {
-                                    LOG("Notify on lower upper crossing");
-                                    notify = true;
-                                }
-                                break;
-                            case LWM2M_TYPE_FLOAT:
-                                if ((floatValue < watcherP->parameters->greaterThan
-                                  && watcherP->lastValue.asFloat > watcherP->parameters->greaterThan)
-                                 || (floatValue > watcherP->parameters->greaterThan
-                                  && watcherP->lastValue.asFloat < watcherP->parameters->greaterThan))
-                                {
-                                    LOG("Notify on lower upper crossing");
-                                    notify = true;
-                                }
-                                break;
-                            default:
-                                break;
+                                LOG("Notify on step condition");
+                                notify = true;
                             }
                         }
-                        if ((watcherP->parameters->toSet & LWM2M_ATTR_FLAG_STEP) != 0)
+                            break;
+                        case LWM2M_TYPE_UNSIGNED_INTEGER:
                         {
-                            LOG("Checking step");
+                            uint64_t diff;
 
-                            switch (dataP->type)
-                            {
-                            case LWM2M_TYPE_INTEGER:
+                            if (unsignedValue >= watcherP->lastValue.asUnsigned)
                             {
-                                int64_t diff;
-
-                                diff = integerValue - watcherP->lastValue.asInteger;
-                                if ((diff < 0 && (0 - diff) >= watcherP->parameters->step)
-                                 || (diff >= 0 && diff >= watcherP->parameters->step))
-                                {
-                                    LOG("Notify on step condition");
-                                    notify = true;
-                                }
+                                diff = unsignedValue - watcherP->lastValue.asUnsigned;
                             }
-                                break;
-                            case LWM2M_TYPE_UNSIGNED_INTEGER:
+                            else
                             {
-                                uint64_t diff;
-
-                                if (unsignedValue >= watcherP->lastValue.asUnsigned)
-                                {
-                                    diff = unsignedValue - watcherP->lastValue.asUnsigned;
-                                }
-                                else
-                                {
-                                    diff = watcherP->lastValue.asUnsigned - unsignedValue;
-                                }
-                                if (diff >= watcherP->parameters->step)
-                                {
-                                    LOG("Notify on step condition");
-                                    notify = true;
-                                }
+                                diff = watcherP->lastValue.asUnsigned - unsignedValue;
                             }
-                                break;
-                            case LWM2M_TYPE_FLOAT:
+                            if (diff >= watcherP->parameters->step)
                             {
-                                double diff;
-
-                                diff = floatValue - watcherP->lastValue.asFloat;
-                                if ((diff < 0 && (0 - diff) >= watcherP->parameters->step)
-                                 || (diff >= 0 && diff >= watcherP->parameters->step))
-                                {
-                                    LOG("Notify on step condition");
-                                    notify = true;
-                                }
-                            }
-                                break;
-                            default:
-                                break;
+                                LOG("Notify on step condition");
+                                notify = true;
                             }
                         }
-                    }
-
-                    if (watcherP->parameters != NULL
-                     && (watcherP->parameters->toSet & LWM2M_ATTR_FLAG_MIN_PERIOD) != 0)
-                    {
-                        LOG_ARG("Checking minimal period (%d s)", watcherP->parameters->minPeriod);
-
-                        if (watcherP->lastTime + watcherP->parameters->minPeriod > currentTime)
+                            break;
+                        case LWM2M_TYPE_FLOAT:
                         {
-                            // Minimum Period did not elapse yet
-                            interval = watcherP->lastTime + watcherP->parameters->minPeriod - currentTime;
-                            if (*timeoutP > interval) *timeoutP = interval;
-                            notify = false;
+                            double diff;
+
+                            diff = floatValue - watcherP->lastValue.asFloat;
+                            if ((diff < 0 && (0 - diff) >= watcherP->parameters->step)
+                             || (diff >= 0 && diff >= watcherP->parameters->step))
+                            {
+                                LOG("Notify on step condition");
+                                notify = true;
+                            }
                         }
-                        else
-                        {
-                            LOG("Notify on minimal period");
-                            notify = true;
+                            break;
+                        default:
+                            break;
                         }
                     }
                 }
 
-                // Is the Maximum Period reached ?
-                if (notify == false
-                 && watcherP->parameters != NULL
-                 && (watcherP->parameters->toSet & LWM2M_ATTR_FLAG_MAX_PERIOD) != 0)
+                if (watcherP->parameters != NULL
+                 && (watcherP->parameters->toSet & LWM2M_ATTR_FLAG_MIN_PERIOD) != 0)
                 {
-                    LOG_ARG("Checking maximal period (%d s)", watcherP->parameters->maxPeriod);
+                    LOG_ARG("Checking minimal period (%d s)", watcherP->parameters->minPeriod);
 
-                    if (watcherP->lastTime + watcherP->parameters->maxPeriod <= currentTime)
+                    if (watcherP->lastTime + watcherP->parameters->minPeriod > currentTime)
+                    {
+                        // Minimum Period did not elapse yet
+                        notify = false;
+                    }
+                    else
                     {
-                        LOG("Notify on maximal period");
+                        LOG("Notify on minimal period");
                         notify = true;
                     }
                 }
+            }
+
+            // Is the Maximum Period reached ?
+            if (notify == false
+             && watcherP->parameters != NULL
+             && (watcherP->parameters->toSet & LWM2M_ATTR_FLAG_MAX_PERIOD) != 0)
+            {
+                LOG_ARG("Checking maximal period (%d s)", watcherP->parameters->maxPeriod);
 
-                if (notify == true)
+                if (watcherP->lastTime + watcherP->parameters->maxPeriod <= currentTime)
                 {
-                    if (buffer == NULL)
-                    {
-                        if (dataP != NULL)
-                        {
-                            int res;
+                    LOG("Notify on maximal period");
+                    notify = true;
+                }
+            }
 
-                            res = lwm2m_data_serialize(&targetP->uri, size, dataP, &(watcherP->format), &buffer);
-                            if (res < 0)
-                            {
-                                break;
-                            }
-                            else
-                            {
-                                length = (size_t)res;
-                            }
+#ifdef LWM2M_SUPPORT_SENML_JSON
+            if (notify == true
+             && compositeP != NULL
+             && prv_addComposite(contextP, compositeP, targetP, watcherP, &size, &dataP))
+            {
+                // sent with the other notifications to this server at the end of the step
+                watcherP->lastTime = currentTime;
+                watcherP->update = false;
+            }
+            else
+#endif
+            if (notify == true)
+            {
+                if (buffer == NULL)
+                {
+                    if (dataP != NULL)
+                    {
+                        int res;
 
+                        res = lwm2m_data_serialize(&targetP->uri, size, dataP, &(watcherP->format), &buffer);
+                        if (res < 0)
+                        {
+                            readFailed = true;
+                            break;
                         }
                         else
                         {
-                            if (COAP_205_CONTENT != object_read(contextP, &targetP->uri, &(watcherP->format), &buffer, &length))
-                            {
-                                buffer = NULL;
-                                break;
-                            }
+                            length = (size_t)res;
                         }
-                        coap_init_message(message, COAP_TYPE_NON, COAP_205_CONTENT, 0);
-                        coap_set_header_content_type(message, watcherP->format);
-                        coap_set_payload(message, buffer, length);
-                    }
-                    watcherP->lastTime = currentTime;
-                    watcherP->lastMid = contextP->nextMID++;
-                    message->mid = watcherP->lastMid;
-                    coap_set_header_token(message, watcherP->token, watcherP->tokenLen);
-                    coap_set_header_observe(message, watcherP->counter++);
-                    (void)message_send(contextP, message, watcherP->server->sessionH);
-                    watcherP->update = false;
-                }
 
-                // Store this value
-                if (notify == true && storeValue == true)
-                {
-                    switch (dataP->type)
+                    }
+                    else
                     {
-                    case LWM2M_TYPE_INTEGER:
-                        watcherP->lastValue.asInteger = integerValue;
-                        break;
-                    case LWM2M_TYPE_UNSIGNED_INTEGER:
-                        watcherP->lastValue.asUnsigned = unsignedValue;
-                        break;
-                    case LWM2M_TYPE_FLOAT:
-                        watcherP->lastValue.asFloat = floatValue;
-                        break;
-                    default:
-                        break;
+                        if (COAP_205_CONTENT != object_read(contextP, &targetP->uri, &(watcherP->format), &buffer, &length))
+                        {
+                            buffer = NULL;
+                            readFailed = true;
+                            break;
+                        }
                     }
+                    coap_init_message(message, COAP_TYPE_NON, COAP_205_CONTENT, 0);
+                    coap_set_header_content_type(message, watcherP->format);
+                    coap_set_payload(message, buffer, length);
                 }
+                watcherP->lastTime = currentTime;
+                watcherP->lastMid = contextP->nextMID++;
+                message->mid = watcherP->lastMid;
+                coap_set_header_token(message, watcherP->token, watcherP->tokenLen);
+                coap_set_header_observe(message, watcherP->counter++);
+                (void)message_send(contextP, message, watcherP->server->sessionH);
+                watcherP->update = false;
+            }
 
-                if (watcherP->parameters != NULL && (watcherP->parameters->toSet & LWM2M_ATTR_FLAG_MAX_PERIOD) != 0)
+            // Store this value
+            if (notify == true && storeValue == true)
+            {
+                switch (dataP->type)
                 {
-                    // update timers
-                    interval = watcherP->lastTime + watcherP->parameters->maxPeriod - currentTime;
-                    if (*timeoutP > interval) *timeoutP = interval;
+                case LWM2M_TYPE_INTEGER:
+                    watcherP->lastValue.asInteger = integerValue;
+                    break;
+                case LWM2M_TYPE_UNSIGNED_INTEGER:
+                    watcherP->lastValue.asUnsigned = unsignedValue;
+                    break;
+                case LWM2M_TYPE_FLOAT:
+                    watcherP->lastValue.asFloat = floatValue;
+                    break;
+                default:
+                    break;
                 }
             }
         }
-        if (dataP != NULL) lwm2m_data_free(size, dataP);
-        if (buffer != NULL) lwm2m_free(buffer);
+    }
+    if (dataP != NULL) prv_releaseData(targetP, size, dataP);
+    if (buffer != NULL) lwm2m_free(buffer);
+
+    if (readFailed == true)
+    {
+        prv_retryObserved(contextP, targetP, currentTime);
+        return;
+    }
+
+    for (watcherP = targetP->watcherList ; watcherP != NULL ; watcherP = watcherP->next)
+    {
+        prv_scheduleWatcher(contextP, watcherP, currentTime, false);
+    }
+}
+
+void observe_step(lwm2m_context_t * contextP,
+                  time_t currentTime,
+                  time_t * timeoutP)
+{
+    lwm2m_timer_t * timerP;
+    composite_list_t * compositeP = NULL;
+#ifdef LWM2M_SUPPORT_SENML_JSON
+    composite_list_t composite;
+
+    memset(&composite, 0, sizeof(composite_list_t));
+    if (contextP->compositeNotifications) compositeP = &composite;
+#endif
+
+    LOG("Entering");
+    // only the observations with a watcher due for a check are read,
+    // all their watchers are checked and scheduled again after the current time
+    while (NULL != (timerP = timer_peek(&contextP->observeTimers))
+        && timerP->time <= currentTime)
+    {
+        prv_stepObserved(contextP, ((lwm2m_watcher_t *)timerP->itemP)->observed, currentTime, compositeP);
+    }
+#ifdef LWM2M_SUPPORT_SENML_JSON
+    if (compositeP != NULL) prv_sendComposite(contextP, compositeP);
+#endif
+
+    timerP = timer_peek(&contextP->observeTimers);
+    if (timerP != NULL && *timeoutP > timerP->time - currentTime)
+    {
+        *timeoutP = (time_t)(timerP->time - currentTime);
     }
 }
 
@@ -830,23 +1486,25 @@ void observe_step(lwm2m_context_t * contextP,
 
 #ifdef LWM2M_SERVER_MODE
 
+// client ID, observation ID and observation count
+#define OBSERVE_TOKEN_LEN 8
+
 typedef struct
 {
     uint16_t                client;
     lwm2m_uri_t             uri;
     lwm2m_result_callback_t callbackP;
     void *                  userDataP;
-    lwm2m_context_t *       contextP;
 } cancellation_data_t;
 
 typedef struct
 {
     uint16_t                id;
     uint16_t                client;
+    uint8_t                 token[OBSERVE_TOKEN_LEN];
     lwm2m_uri_t             uri;
     lwm2m_result_callback_t callback;
     void *                  userData;
-    lwm2m_context_t *       contextP;
 } observation_data_t;
 
 
@@ -876,10 +1534,54 @@ static lwm2m_observation_t * prv_findObservationByURI(lwm2m_client_t * clientP,
     return targetP;
 }
 
-void observe_remove(lwm2m_observation_t * observationP)
+// The client and observation IDs make the token unique among the current observations.
+// The observation count tells it apart from the tokens of the removed observations
+// whose IDs were reused.
+static void prv_makeToken(lwm2m_context_t * contextP,
+                          uint16_t clientID,
+                          uint16_t obsID,
+                          uint8_t * token)
+{
+    uint32_t count = contextP->observationCount++;
+
+    token[0] = clientID >> 8;
+    token[1] = clientID & 0xFF;
+    token[2] = obsID >> 8;
+    token[3] = obsID & 0xFF;
+    token[4] = count >> 24;
+    token[5] = (count >> 16) & 0xFF;
+    token[6] = (count >> 8) & 0xFF;
+    token[7] = count & 0xFF;
+}
+
+static lwm2m_observation_t * prv_findObservationByToken(lwm2m_context_t * contextP,
+                                                        const uint8_t * token,
+                                                        size_t tokenLen)
+{
+    lwm2m_hash_link_t * linkP;
+
+    for (linkP = hash_find(&contextP->observationTokenTable, hash_bytes(token, tokenLen)) ;
+         linkP != NULL ;
+         linkP = hash_findNext(linkP))
+    {
+        lwm2m_observation_t * targetP = (lwm2m_observation_t *)linkP->itemP;
+
+        if (targetP->tokenLen == tokenLen
+         && memcmp(targetP->token, token, tokenLen) == 0)
+        {
+            return targetP;
+        }
+    }
+
+    return NULL;
+}
+
+void observe_remove(lwm2m_context_t * contextP,
+                    lwm2m_observation_t * observationP)
 {
     LOG("Entering");
     observationP->clientP->observationList = (lwm2m_observation_t *) LWM2M_LIST_RM(observationP->clientP->observationList, observationP->id, NULL);
+    hash_remove(&contextP->observationTokenTable, &observationP->tokenLink);
     lwm2m_free(observationP);
 }
 
@@ -894,9 +1596,7 @@ static void prv_obsRequestCallback(lwm2m_context_t * contextP,
     lwm2m_client_t * clientP;
     lwm2m_uri_t * uriP = & observationData->uri;
 
-    (void)contextP; /* unused */
-
-    clientP = (lwm2m_client_t *)lwm2m_list_find((lwm2m_list_t *)observationData->contextP->clientList, observationData->client);
+    clientP = lwm2m_get_client(contextP, observationData->client);
     if (clientP == NULL)
     {
         observationData->callback(observationData->client,
@@ -947,6 +1647,7 @@ static void prv_obsRequestCallback(lwm2m_context_t * contextP,
         else
         {
             observationP->clientP->observationList = (lwm2m_observation_t *) LWM2M_LIST_RM(observationP->clientP->observationList, observationP->id, NULL);
+            hash_remove(&contextP->observationTokenTable, &observationP->tokenLink);
 
             // give the user chance to free previous observation userData
             // indicator: COAP_202_DELETED and (Length ==0)
@@ -959,6 +1660,8 @@ static void prv_obsRequestCallback(lwm2m_context_t * contextP,
 
         observationP->id = observationData->id;
         observationP->clientP = clientP;
+        memcpy(observationP->token, observationData->token, OBSERVE_TOKEN_LEN);
+        observationP->tokenLen = OBSERVE_TOKEN_LEN;
 
         observationP->callback = observationData->callback;
         observationP->userData = observationData->userData;
@@ -966,11 +1669,15 @@ static void prv_obsRequestCallback(lwm2m_context_t * contextP,
         memcpy(&observationP->uri, uriP, sizeof(lwm2m_uri_t));
 
         observationP->clientP->observationList = (lwm2m_observation_t *)LWM2M_LIST_ADD(observationP->clientP->observationList, observationP);
+        hash_add(&contextP->observationTokenTable,
+                 &observationP->tokenLink,
+                 hash_bytes(observationP->token, observationP->tokenLen),
+                 observationP);
 
         observationData->callback(observationData->client,
                 &observationData->uri,
                 0,
-                packet->content_type, packet->payload, packet->payload_len,
+                (lwm2m_media_type_t)packet->content_type, packet->payload, packet->payload_len,
                 observationData->userData);
     }
 
@@ -986,16 +1693,14 @@ static void prv_obsCancelRequestCallback(lwm2m_context_t * contextP,
     cancellation_data_t * cancelP = (cancellation_data_t *)transacP->userData;
     coap_packet_t * packet = (coap_packet_t *)message;
     uint8_t code;
-    lwm2m_client_t * clientP = (lwm2m_client_t *)lwm2m_list_find((lwm2m_list_t *)cancelP->contextP->clientList, cancelP->client);
-
-    (void)contextP; /* unused */
+    lwm2m_client_t * clientP = lwm2m_get_client(contextP, cancelP->client);
 
     if (clientP == NULL)
     {
         cancelP->callbackP(cancelP->client,
                 &cancelP->uri,
                 COAP_500_INTERNAL_SERVER_ERROR,
-                packet->content_type, NULL, 0,
+                (lwm2m_media_type_t)packet->content_type, NULL, 0,
                 cancelP->userDataP);
         goto end;
     }
@@ -1024,11 +1729,11 @@ static void prv_obsCancelRequestCallback(lwm2m_context_t * contextP,
         cancelP->callbackP(cancelP->client,
                 &cancelP->uri,
                 0,
-                packet->content_type, packet->payload, packet->payload_len,
+                (lwm2m_media_type_t)packet->content_type, packet->payload, packet->payload_len,
                 cancelP->userDataP);
     }
 
-    observe_remove(observationP);
+    observe_remove(contextP, observationP);
 end:
     lwm2m_free(cancelP);
 }
@@ -1044,14 +1749,13 @@ int lwm2m_observe(lwm2m_context_t * contextP,
     lwm2m_transaction_t * transactionP;
     observation_data_t * observationData;
     lwm2m_observation_t * observationP;
-    uint8_t token[4];
 
     LOG_ARG("clientID: %d", clientID);
     LOG_URI(uriP);
 
     if (!LWM2M_URI_IS_SET_INSTANCE(uriP) && LWM2M_URI_IS_SET_RESOURCE(uriP)) return COAP_400_BAD_REQUEST;
 
-    clientP = (lwm2m_client_t *)lwm2m_list_find((lwm2m_list_t *)contextP->clientList, clientID);
+    clientP = lwm2m_get_client(contextP, clientID);
     if (clientP == NULL) return COAP_404_NOT_FOUND;
 
     observationP = prv_findObservationByURI(clientP, uriP);
@@ -1076,14 +1780,10 @@ int lwm2m_observe(lwm2m_context_t * contextP,
     observationData->client = clientP->internalID;
     observationData->callback = callback;
     observationData->userData = userData;
-    observationData->contextP = contextP;
 
-    token[0] = clientP->internalID >> 8;
-    token[1] = clientP->internalID & 0xFF;
-    token[2] = observationData->id >> 8;
-    token[3] = observationData->id & 0xFF;
+    prv_makeToken(contextP, clientP->internalID, observationData->id, observationData->token);
 
-    transactionP = transaction_new(clientP->sessionH, COAP_GET, clientP->altPath, uriP, contextP->nextMID++, 4, token);
+    transactionP = transaction_new(contextP, clientP->sessionH, COAP_GET, clientP->altPath, uriP, contextP->nextMID++, OBSERVE_TOKEN_LEN, observationData->token);
     if (transactionP == NULL)
     {
         lwm2m_free(observationData);
@@ -1096,7 +1796,7 @@ int lwm2m_observe(lwm2m_context_t * contextP,
     transactionP->callback = prv_obsRequestCallback;
     transactionP->userData = (void *)observationData;
 
-    contextP->transactionList = (lwm2m_transaction_t *)LWM2M_LIST_ADD(contextP->transactionList, transactionP);
+    transaction_add(contextP, transactionP);
 
     // update the user latest intention
     if(observationP) observationP->status = STATE_REG_PENDING;
@@ -1123,7 +1823,7 @@ int lwm2m_observe_cancel(lwm2m_context_t * contextP,
     LOG_ARG("clientID: %d", clientID);
     LOG_URI(uriP);
 
-    clientP = (lwm2m_client_t *)lwm2m_list_find((lwm2m_list_t *)contextP->clientList, clientID);
+    clientP = lwm2m_get_client(contextP, clientID);
     if (clientP == NULL) return COAP_404_NOT_FOUND;
 
     observationP = prv_findObservationByURI(clientP, uriP);
@@ -1135,14 +1835,9 @@ int lwm2m_observe_cancel(lwm2m_context_t * contextP,
     {
         lwm2m_transaction_t * transactionP;
         cancellation_data_t * cancelP;
-        uint8_t token[4];
-
-        token[0] = clientP->internalID >> 8;
-        token[1] = clientP->internalID & 0xFF;
-        token[2] = observationP->id >> 8;
-        token[3] = observationP->id & 0xFF;
 
-        transactionP = transaction_new(clientP->sessionH, COAP_GET, clientP->altPath, uriP, contextP->nextMID++, 4, token);
+        // the cancellation uses the token of the observation
+        transactionP = transaction_new(contextP, clientP->sessionH, COAP_GET, clientP->altPath, uriP, contextP->nextMID++, observationP->tokenLen, observationP->token);
         if (transactionP == NULL)
         {
             return COAP_500_INTERNAL_SERVER_ERROR;
@@ -1150,7 +1845,7 @@ int lwm2m_observe_cancel(lwm2m_context_t * contextP,
         cancelP = (cancellation_data_t *)lwm2m_malloc(sizeof(cancellation_data_t));
         if (cancelP == NULL)
         {
-            lwm2m_free(transactionP);
+            transaction_free(contextP, transactionP);
             return COAP_500_INTERNAL_SERVER_ERROR;
         }
 
@@ -1161,16 +1856,15 @@ int lwm2m_observe_cancel(lwm2m_context_t * contextP,
         memcpy(&cancelP->uri, uriP, sizeof(lwm2m_uri_t));
         cancelP->callbackP = callback;
         cancelP->userDataP = userData;
-        cancelP->contextP = contextP;
 
         transactionP->callback = prv_obsCancelRequestCallback;
         transactionP->userData = (void *)cancelP;
 
-        contextP->transactionList = (lwm2m_transaction_t *)LWM2M_LIST_ADD(contextP->transactionList, transactionP);
+        transaction_add(contextP, transactionP);
 
         observationP->status = STATE_DEREG_PENDING;
 
-        int ret = transaction_send(contextP, transactionP);
+        ret = transaction_send(contextP, transactionP);
         if (ret != 0) lwm2m_free(cancelP);
         return ret;
     }
@@ -1187,12 +1881,85 @@ int lwm2m_observe_cancel(lwm2m_context_t * contextP,
     }
 
     // no other chance to remove the observationP since not sending a transaction
-    observe_remove(observationP);
+    observe_remove(contextP, observationP);
 
     // need to give a indicator (non-zero) to user for properly freeing the userData
     return ret;
 }
 
+#ifdef LWM2M_SUPPORT_SENML_JSON
+int lwm2m_set_client_composite_notifications(lwm2m_context_t * contextP,
+                                             uint16_t clientID,
+                                             bool enable)
+{
+    lwm2m_client_t * clientP;
+
+    LOG_ARG("clientID: %d, enable: %d", clientID, enable);
+    clientP = lwm2m_get_client(contextP, clientID);
+    if (clientP == NULL) return COAP_404_NOT_FOUND;
+
+    clientP->compositeNotifications = enable;
+    return COAP_NO_ERROR;
+}
+
+// Gives each observation of the client its pack of a notification packing the notifications
+// of several observations. Returns false if the notification is not packed.
+static bool prv_dispatchComposite(lwm2m_observation_t * observationP,
+                                  uint32_t count,
+                                  coap_packet_t * message)
+{
+    lwm2m_client_t * clientP = observationP->clientP;
+    lwm2m_uri_t uri;
+    size_t index;
+    size_t start;
+    size_t length;
+    int res;
+
+    if (!clientP->compositeNotifications) return false;
+
+    // the first pack is the one of the observation of the token
+    index = 0;
+    res = senml_json_nextPack(message->payload, message->payload_len, &index, &uri, &start, &length);
+    if (res != 1 || prv_findObservationByURI(clientP, &uri) != observationP) return false;
+
+    // the whole payload is checked before calling the observations
+    while (res == 1)
+    {
+        res = senml_json_nextPack(message->payload, message->payload_len, &index, &uri, &start, &length);
+    }
+    if (res < 0) return false;
+
+    index = 0;
+    while (1 == senml_json_nextPack(message->payload, message->payload_len, &index, &uri, &start, &length))
+    {
+        lwm2m_observation_t * targetP;
+        uint8_t * buffer;
+
+        targetP = prv_findObservationByURI(clientP, &uri);
+        if (targetP == NULL)
+        {
+            LOG("No observation of the pack");
+            LOG_URI(&uri);
+            continue;
+        }
+
+        buffer = (uint8_t *)lwm2m_malloc(length + 2);
+        if (buffer == NULL) continue;
+        buffer[0] = '[';
+        memcpy(buffer + 1, message->payload + start, length);
+        buffer[length + 1] = ']';
+        targetP->callback(clientP->internalID,
+                          &targetP->uri,
+                          (int)count,
+                          LWM2M_CONTENT_SENML_JSON, buffer, (int)(length + 2),
+                          targetP->userData);
+        lwm2m_free(buffer);
+    }
+
+    return true;
+}
+#endif
+
 bool observe_handleNotify(lwm2m_context_t * contextP,
                            void * fromSessionH,
                            coap_packet_t * message,
@@ -1200,25 +1967,16 @@ bool observe_handleNotify(lwm2m_context_t * contextP,
 {
     uint8_t * tokenP;
     int token_len;
-    uint16_t clientID;
-    uint16_t obsID;
-    lwm2m_client_t * clientP;
     lwm2m_observation_t * observationP;
     uint32_t count;
 
     LOG("Entering");
     token_len = coap_get_header_token(message, &tokenP);
-    if (token_len != sizeof(uint32_t)) return false;
+    if (token_len <= 0) return false;
 
     if (1 != coap_get_header_observe(message, &count)) return false;
 
-    clientID = (tokenP[0] << 8) | tokenP[1];
-    obsID = (tokenP[2] << 8) | tokenP[3];
-
-    clientP = (lwm2m_client_t *)lwm2m_list_find((lwm2m_list_t *)contextP->clientList, clientID);
-    if (clientP == NULL) return false;
-
-    observationP = (lwm2m_observation_t *)lwm2m_list_find((lwm2m_list_t *)clientP->observationList, obsID);
+    observationP = prv_findObservationByToken(contextP, tokenP, (size_t)token_len);
     if (observationP == NULL)
     {
         coap_init_message(response, COAP_TYPE_RST, 0, message->mid);
@@ -1230,10 +1988,17 @@ bool observe_handleNotify(lwm2m_context_t * contextP,
             coap_init_message(response, COAP_TYPE_ACK, 0, message->mid);
             message_send(contextP, response, fromSessionH);
         }
-        observationP->callback(clientID,
+#ifdef LWM2M_SUPPORT_SENML_JSON
+        if (message->content_type == (coap_content_type_t)LWM2M_CONTENT_SENML_JSON
+         && prv_dispatchComposite(observationP, count, message))
+        {
+            return true;
+        }
+#endif
+        observationP->callback(observationP->clientP->internalID,
                                &observationP->uri,
                                (int)count,
-                               message->content_type, message->payload, message->payload_len,
+                               (lwm2m_media_type_t)message->content_type, message->payload, message->payload_len,
                                observationP->userData);
     }
     return true;
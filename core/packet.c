@@ -194,6 +194,158 @@ static uint8_t handle_request(lwm2m_context_t * contextP,
     return result;
 }
 
+#ifdef LWM2M_WITH_BATCH_SEND
+static void prv_flushBatch(lwm2m_context_t * contextP,
+                           send_batch_t * batchP)
+{
+    if (batchP->count != 0)
+    {
+        LOG_ARG("Sending %u responses", (unsigned int)batchP->count);
+        (void)lwm2m_buffer_send_batch(batchP->packets, batchP->count, contextP->userData);
+    }
+    batchP->count = 0;
+    batchP->used = 0;
+}
+
+// Serializes the message at the end of the batch.
+// Returns false if the message does not fit in an empty batch.
+static bool prv_addToBatch(lwm2m_context_t * contextP,
+                           send_batch_t * batchP,
+                           coap_packet_t * message,
+                           void * sessionH)
+{
+    size_t length;
+
+    if (batchP->count == LWM2M_SEND_BATCH_SIZE) prv_flushBatch(contextP, batchP);
+
+    length = coap_serialize_message(message, batchP->buffer + batchP->used, LWM2M_SEND_BATCH_BUFFER_SIZE - batchP->used);
+    if (length == 0 && batchP->used != 0)
+    {
+        // no room left, send the pending responses first
+        prv_flushBatch(contextP, batchP);
+        length = coap_serialize_message(message, batchP->buffer, LWM2M_SEND_BATCH_BUFFER_SIZE);
+    }
+    if (length == 0) return false;
+
+    batchP->packets[batchP->count].buffer = batchP->buffer + batchP->used;
+    batchP->packets[batchP->count].length = length;
+    batchP->packets[batchP->count].sessionH = sessionH;
+    batchP->count++;
+    batchP->used += length;
+
+    return true;
+}
+
+// Copies a serialized message at the end of the batch.
+static bool prv_addBufferToBatch(lwm2m_context_t * contextP,
+                                 send_batch_t * batchP,
+                                 uint8_t * buffer,
+                                 size_t length,
+                                 void * sessionH)
+{
+    if (length > LWM2M_SEND_BATCH_BUFFER_SIZE) return false;
+    if (batchP->count == LWM2M_SEND_BATCH_SIZE
+     || length > LWM2M_SEND_BATCH_BUFFER_SIZE - batchP->used)
+    {
+        prv_flushBatch(contextP, batchP);
+    }
+
+    memcpy(batchP->buffer + batchP->used, buffer, length);
+    batchP->packets[batchP->count].buffer = batchP->buffer + batchP->used;
+    batchP->packets[batchP->count].length = length;
+    batchP->packets[batchP->count].sessionH = sessionH;
+    batchP->count++;
+    batchP->used += length;
+
+    return true;
+}
+
+void message_flush(lwm2m_context_t * contextP,
+                   void * sessionH)
+{
+    size_t i;
+
+    if (contextP->sendBatchP == NULL) return;
+
+    for (i = 0 ; i < contextP->sendBatchP->count ; i++)
+    {
+        if (lwm2m_session_is_equal(contextP->sendBatchP->packets[i].sessionH, sessionH, contextP->userData))
+        {
+            prv_flushBatch(contextP, contextP->sendBatchP);
+            return;
+        }
+    }
+}
+#endif
+
+// Sends a serialized message, in the current batch if any.
+static uint8_t prv_sendBuffer(lwm2m_context_t * contextP,
+                              uint8_t * buffer,
+                              size_t length,
+                              void * sessionH)
+{
+#ifdef LWM2M_WITH_BATCH_SEND
+    if (contextP->sendBatchP != NULL
+     && prv_addBufferToBatch(contextP, contextP->sendBatchP, buffer, length, sessionH))
+    {
+        return COAP_NO_ERROR;
+    }
+#endif
+    return lwm2m_buffer_send(sessionH, buffer, length, contextP->userData);
+}
+
+// Serializes the message in buffer or, if it is too large, in an allocated
+// buffer returned in pktBufferP. Returns the length of the message or 0.
+static size_t prv_serialize(coap_packet_t * message,
+                            uint8_t * buffer,
+                            size_t size,
+                            uint8_t ** pktBufferP)
+{
+    size_t length;
+    size_t allocLen;
+
+    *pktBufferP = buffer;
+    length = coap_serialize_message(message, buffer, size);
+    LOG_ARG("coap_serialize_message() returned %d", length);
+    if (0 != length) return length;
+
+    allocLen = coap_serialize_get_size(message);
+    LOG_ARG("Size to allocate: %d", allocLen);
+    if (allocLen == 0) return 0;
+
+    *pktBufferP = (uint8_t *)lwm2m_malloc(allocLen);
+    if (*pktBufferP == NULL) return 0;
+
+    length = coap_serialize_message(message, *pktBufferP, allocLen);
+    LOG_ARG("coap_serialize_message() returned %d", length);
+
+    return length;
+}
+
+// Sends the response to a request. The piggybacked responses to CON requests
+// are kept to answer the duplicates of the requests without handling them again.
+static uint8_t prv_sendResponse(lwm2m_context_t * contextP,
+                                coap_packet_t * response,
+                                void * sessionH)
+{
+    uint8_t result = COAP_500_INTERNAL_SERVER_ERROR;
+    uint8_t buffer[LWM2M_SEND_BUFFER_SIZE];
+    uint8_t * pktBuffer;
+    size_t length;
+
+    if (response->type != COAP_TYPE_ACK) return message_send(contextP, response, sessionH);
+
+    length = prv_serialize(response, buffer, LWM2M_SEND_BUFFER_SIZE, &pktBuffer);
+    if (0 != length)
+    {
+        transaction_cacheResponse(contextP, sessionH, response->mid, pktBuffer, length);
+        result = prv_sendBuffer(contextP, pktBuffer, length, sessionH);
+    }
+    if (pktBuffer != NULL && pktBuffer != buffer) lwm2m_free(pktBuffer);
+
+    return result;
+}
+
 /* This function is an adaptation of function coap_receive() from Erbium's er-coap-13-engine.c.
  * Erbium is Copyright (c) 2013, Institute for Pervasive Computing, ETH Zurich
  * All rights reserved.
@@ -204,8 +356,10 @@ void lwm2m_handle_packet(lwm2m_context_t * contextP,
                          void * fromSessionH)
 {
     uint8_t coap_error_code = NO_ERROR;
-    static coap_packet_t message[1];
-    static coap_packet_t response[1];
+    coap_packet_t message[1];
+    coap_packet_t response[1];
+    uint8_t * cachedBuffer;
+    size_t cachedLength;
 
     LOG("Entering");
     coap_error_code = coap_parse_message(message, buffer, (uint16_t)length);
@@ -214,7 +368,15 @@ void lwm2m_handle_packet(lwm2m_context_t * contextP,
         LOG_ARG("Parsed: ver %u, type %u, tkl %u, code %u.%.2u, mid %u, Content type: %d",
                 message->version, message->type, message->token_len, message->code >> 5, message->code & 0x1F, message->mid, message->content_type);
         LOG_ARG("Payload: %.*s", message->payload_len, message->payload);
-        if (message->code >= COAP_GET && message->code <= COAP_DELETE)
+        if (message->code >= COAP_GET && message->code <= COAP_DELETE
+         && message->type == COAP_TYPE_CON
+         && transaction_findResponse(contextP, fromSessionH, message->mid, &cachedBuffer, &cachedLength))
+        {
+            // duplicate of an answered request (RFC 7252 section 4.5)
+            LOG_ARG("Duplicate request %u, sending the same response", message->mid);
+            (void)prv_sendBuffer(contextP, cachedBuffer, cachedLength, fromSessionH);
+        }
+        else if (message->code >= COAP_GET && message->code <= COAP_DELETE)
         {
             uint32_t block_num = 0;
             uint16_t block_size = REST_MAX_CHUNK_SIZE;
@@ -338,7 +500,7 @@ void lwm2m_handle_packet(lwm2m_context_t * contextP,
                     coap_set_payload(response, response->payload, MIN(response->payload_len, REST_MAX_CHUNK_SIZE));
                 } /* if (blockwise request) */
 
-                coap_error_code = message_send(contextP, response, fromSessionH);
+                coap_error_code = prv_sendResponse(contextP, response, fromSessionH);
 
                 lwm2m_free(payload);
                 response->payload = NULL;
@@ -348,7 +510,7 @@ void lwm2m_handle_packet(lwm2m_context_t * contextP,
             {
                 if (1 == coap_set_status_code(response, coap_error_code))
                 {
-                    coap_error_code = message_send(contextP, response, fromSessionH);
+                    coap_error_code = prv_sendResponse(contextP, response, fromSessionH);
                 }
             }
         }
@@ -400,7 +562,9 @@ void lwm2m_handle_packet(lwm2m_context_t * contextP,
 
     if (coap_error_code != NO_ERROR && coap_error_code != COAP_IGNORE)
     {
-        LOG_ARG("ERROR %u: %s", coap_error_code, coap_error_message);
+        const char * error_message = message->error_message != NULL ? message->error_message : "";
+
+        LOG_ARG("ERROR %u: %s", coap_error_code, error_message);
 
         /* Set to sendable error code. */
         if (coap_error_code >= 192)
@@ -409,37 +573,60 @@ void lwm2m_handle_packet(lwm2m_context_t * contextP,
         }
         /* Reuse input buffer for error message. */
         coap_init_message(message, COAP_TYPE_ACK, coap_error_code, message->mid);
-        coap_set_payload(message, coap_error_message, strlen(coap_error_message));
+        coap_set_payload(message, error_message, strlen(error_message));
         message_send(contextP, message, fromSessionH);
     }
 }
 
 
+void lwm2m_handle_packets(lwm2m_context_t * contextP,
+                          lwm2m_packet_t * packets,
+                          size_t count)
+{
+    size_t i;
+#ifdef LWM2M_WITH_BATCH_SEND
+    send_batch_t batch;
+
+    batch.count = 0;
+    batch.used = 0;
+    contextP->sendBatchP = &batch;
+#endif
+
+    LOG_ARG("Entering. count: %u", (unsigned int)count);
+    for (i = 0 ; i < count ; i++)
+    {
+        lwm2m_handle_packet(contextP, packets[i].buffer, (int)packets[i].length, packets[i].sessionH);
+    }
+
+#ifdef LWM2M_WITH_BATCH_SEND
+    prv_flushBatch(contextP, &batch);
+    contextP->sendBatchP = NULL;
+#endif
+}
+
 uint8_t message_send(lwm2m_context_t * contextP,
                      coap_packet_t * message,
                      void * sessionH)
 {
     uint8_t result = COAP_500_INTERNAL_SERVER_ERROR;
+    uint8_t buffer[LWM2M_SEND_BUFFER_SIZE];
     uint8_t * pktBuffer;
-    size_t pktBufferLen = 0;
-    size_t allocLen;
+    size_t pktBufferLen;
 
     LOG("Entering");
-    allocLen = coap_serialize_get_size(message);
-    LOG_ARG("Size to allocate: %d", allocLen);
-    if (allocLen == 0) return COAP_500_INTERNAL_SERVER_ERROR;
-
-    pktBuffer = (uint8_t *)lwm2m_malloc(allocLen);
-    if (pktBuffer != NULL)
+#ifdef LWM2M_WITH_BATCH_SEND
+    if (contextP->sendBatchP != NULL
+     && prv_addToBatch(contextP, contextP->sendBatchP, message, sessionH))
     {
-        pktBufferLen = coap_serialize_message(message, pktBuffer);
-        LOG_ARG("coap_serialize_message() returned %d", pktBufferLen);
-        if (0 != pktBufferLen)
-        {
-            result = lwm2m_buffer_send(sessionH, pktBuffer, pktBufferLen, contextP->userData);
-        }
-        lwm2m_free(pktBuffer);
+        return COAP_NO_ERROR;
+    }
+#endif
+    pktBufferLen = prv_serialize(message, buffer, LWM2M_SEND_BUFFER_SIZE, &pktBuffer);
+    if (0 != pktBufferLen)
+    {
+        result = lwm2m_buffer_send(sessionH, pktBuffer, pktBufferLen, contextP->userData);
     }
+    if (pktBuffer != NULL && pktBuffer != buffer) lwm2m_free(pktBuffer);
 
     return result;
 }
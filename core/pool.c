@@ -0,0 +1,97 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2026 Eclipse Wakaama contributors and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * The Eclipse Distribution License is available at
+ *    http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Please refer to git log
+ *
+ *******************************************************************************/
+
+/*
+ * Fixed-size object pools used for the frequently allocated core structures.
+ *
+ * The storage of a pool is allocated once when the pool is initialized.
+ * Released items are kept in a free list and reused by the next allocations.
+ * When the pool is empty, items are allocated with lwm2m_malloc() and given
+ * back with lwm2m_free() when released.
+ */
+
+#include "internals.h"
+
+// keep the items aligned for any member type
+#define POOL_ALIGNMENT  sizeof(uint64_t)
+
+void pool_init(lwm2m_pool_t * poolP,
+               size_t itemSize,
+               uint16_t capacity)
+{
+    uint16_t i;
+
+    memset(poolP, 0, sizeof(lwm2m_pool_t));
+
+    if (itemSize < sizeof(void *)) itemSize = sizeof(void *);
+    itemSize = (itemSize + POOL_ALIGNMENT - 1) & ~(POOL_ALIGNMENT - 1);
+    poolP->itemSize = itemSize;
+
+    if (capacity == 0) return;
+
+    poolP->storage = (uint8_t *)lwm2m_malloc(itemSize * capacity);
+    // the pool will only use the heap
+    if (poolP->storage == NULL) return;
+    poolP->capacity = capacity;
+
+    for (i = capacity ; i > 0 ; i--)
+    {
+        void ** itemP = (void **)(poolP->storage + (i - 1) * itemSize);
+
+        *itemP = poolP->freeList;
+        poolP->freeList = itemP;
+    }
+}
+
+void * pool_alloc(lwm2m_pool_t * poolP)
+{
+    void ** itemP;
+
+    if (poolP->freeList == NULL)
+    {
+        return lwm2m_malloc(poolP->itemSize);
+    }
+
+    itemP = (void **)poolP->freeList;
+    poolP->freeList = *itemP;
+
+    return itemP;
+}
+
+void pool_release(lwm2m_pool_t * poolP,
+                  void * itemP)
+{
+    if (itemP == NULL) return;
+
+    if (poolP->storage == NULL
+     || (uint8_t *)itemP < poolP->storage
+     || (uint8_t *)itemP >= poolP->storage + poolP->capacity * poolP->itemSize)
+    {
+        // allocated when the pool was empty
+        lwm2m_free(itemP);
+        return;
+    }
+
+    *(void **)itemP = poolP->freeList;
+    poolP->freeList = itemP;
+}
+
+void pool_free(lwm2m_pool_t * poolP)
+{
+    if (poolP->storage != NULL) lwm2m_free(poolP->storage);
+    memset(poolP, 0, sizeof(lwm2m_pool_t));
+}
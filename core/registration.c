@@ -503,7 +503,7 @@ static uint8_t prv_startRegistration(lwm2m_server_t* targetP,
     }
     if (result == COAP_NO_ERROR)
     {
-        targetP->registration = lwm2m_gettime() + delay;
+        targetP->registration = utils_gettime() + delay;
         targetP->status = STATE_REG_HOLD_OFF;
     }
 
@@ -559,7 +559,7 @@ static void prv_handleRegistrationSequenceFailure(lwm2m_context_t *contextP, lwm
         }
         else
         {
-            targetP->registration = lwm2m_gettime() + sequenceDelay;
+            targetP->registration = utils_gettime() + sequenceDelay;
             targetP->status = STATE_REG_HOLD_OFF;
             targetP->attempt = 0;
             LOG_ARG("%d Registration sequence failed", targetP->shortID);
@@ -592,7 +592,7 @@ static void prv_handleRegistrationAttemptFailure(lwm2m_context_t *contextP, lwm2
             }
             else
             {
-                targetP->registration = lwm2m_gettime() + attemptDelay * (1 << (targetP->attempt - 1));
+                targetP->registration = utils_gettime() + attemptDelay * (1 << (targetP->attempt - 1));
                 targetP->status = STATE_REG_HOLD_OFF;
                 LOG_ARG("%d Registration attempt failed", targetP->shortID);
             }
@@ -624,7 +624,7 @@ static void prv_handleRegistrationReply(lwm2m_context_t * contextP,
 
     if (targetP->status == STATE_REG_PENDING)
     {
-        time_t tv_sec = lwm2m_gettime();
+        time_t tv_sec = utils_gettime();
         if (tv_sec >= 0)
         {
             targetP->registration = tv_sec;
@@ -737,7 +737,7 @@ static uint8_t prv_register(lwm2m_context_t * contextP,
         return COAP_503_SERVICE_UNAVAILABLE;
     }
 
-    transaction = transaction_new(server->sessionH, COAP_POST, NULL, NULL, contextP->nextMID++, 4, NULL);
+    transaction = transaction_new(contextP, server->sessionH, COAP_POST, NULL, NULL, contextP->nextMID++, 4, NULL);
     if (transaction == NULL)
     {
         lwm2m_free(payload);
@@ -753,7 +753,7 @@ static uint8_t prv_register(lwm2m_context_t * contextP,
     transaction->callback = prv_handleRegistrationReply;
     transaction->userData = (void *) server;
 
-    contextP->transactionList = (lwm2m_transaction_t *)LWM2M_LIST_ADD(contextP->transactionList, transaction);
+    transaction_add(contextP, transaction);
     if (transaction_send(contextP, transaction) != 0)
     {
         lwm2m_free(payload);
@@ -786,7 +786,7 @@ static void prv_handleRegistrationUpdateReply(lwm2m_context_t * contextP,
 
     if (targetP->status == STATE_REG_UPDATE_PENDING)
     {
-        time_t tv_sec = lwm2m_gettime();
+        time_t tv_sec = utils_gettime();
         if (tv_sec >= 0)
         {
             targetP->registration = tv_sec;
@@ -812,7 +812,7 @@ static int prv_updateRegistration(lwm2m_context_t * contextP,
     uint8_t * payload = NULL;
     int payload_length;
 
-    transaction = transaction_new(server->sessionH, COAP_POST, NULL, NULL, contextP->nextMID++, 4, NULL);
+    transaction = transaction_new(contextP, server->sessionH, COAP_POST, NULL, NULL, contextP->nextMID++, 4, NULL);
     if (transaction == NULL) return COAP_500_INTERNAL_SERVER_ERROR;
 
     coap_set_header_uri_path(transaction->message, server->location);
@@ -822,21 +822,21 @@ static int prv_updateRegistration(lwm2m_context_t * contextP,
         payload_length = object_getRegisterPayloadBufferLength(contextP);
         if(payload_length == 0)
         {
-            transaction_free(transaction);
+            transaction_free(contextP, transaction);
             return COAP_500_INTERNAL_SERVER_ERROR;
         }
 
         payload = lwm2m_malloc(payload_length);
         if(!payload)
         {
-            transaction_free(transaction);
+            transaction_free(contextP, transaction);
             return COAP_500_INTERNAL_SERVER_ERROR;
         }
 
         payload_length = object_getRegisterPayload(contextP, payload, payload_length);
         if(payload_length == 0)
         {
-            transaction_free(transaction);
+            transaction_free(contextP, transaction);
             lwm2m_free(payload);
             return COAP_500_INTERNAL_SERVER_ERROR;
         }
@@ -846,7 +846,7 @@ static int prv_updateRegistration(lwm2m_context_t * contextP,
     transaction->callback = prv_handleRegistrationUpdateReply;
     transaction->userData = (void *) server;
 
-    contextP->transactionList = (lwm2m_transaction_t *)LWM2M_LIST_ADD(contextP->transactionList, transaction);
+    transaction_add(contextP, transaction);
 
     if (transaction_send(contextP, transaction) == 0)
     {
@@ -1095,7 +1095,7 @@ void registration_deregister(lwm2m_context_t * contextP,
         return;
     }
 
-    transaction = transaction_new(serverP->sessionH, COAP_DELETE, NULL, NULL, contextP->nextMID++, 4, NULL);
+    transaction = transaction_new(contextP, serverP->sessionH, COAP_DELETE, NULL, NULL, contextP->nextMID++, 4, NULL);
     if (transaction == NULL) return;
 
     coap_set_header_uri_path(transaction->message, serverP->location);
@@ -1103,7 +1103,7 @@ void registration_deregister(lwm2m_context_t * contextP,
     transaction->callback = prv_handleDeregistrationReply;
     transaction->userData = (void *) serverP;
 
-    contextP->transactionList = (lwm2m_transaction_t *)LWM2M_LIST_ADD(contextP->transactionList, transaction);
+    transaction_add(contextP, transaction);
     if (transaction_send(contextP, transaction) == 0)
     {
         serverP->status = STATE_DEREG_PENDING;
@@ -1112,25 +1112,209 @@ void registration_deregister(lwm2m_context_t * contextP,
 #endif
 
 #ifdef LWM2M_SERVER_MODE
-static void prv_freeClientObjectList(lwm2m_client_object_t * objects)
+static void prv_releaseObjectList(lwm2m_context_t * contextP,
+                                  lwm2m_client_object_list_t * listP)
 {
-    while (objects != NULL)
+    if (listP == NULL) return;
+
+    listP->refCount--;
+    if (listP->refCount > 0) return;
+
+    hash_remove(&contextP->objectListTable, &listP->link);
+    lwm2m_free(listP);
+}
+
+// Returns the shared list with these objects, or a new one with a copy of them.
+static lwm2m_client_object_list_t * prv_internObjectList(lwm2m_context_t * contextP,
+                                                         lwm2m_client_object_t * objects,
+                                                         size_t count)
+{
+    lwm2m_client_object_list_t * listP;
+    lwm2m_hash_link_t * linkP;
+    uint32_t hash;
+
+    hash = hash_bytes((uint8_t *)objects, count * sizeof(lwm2m_client_object_t));
+    for (linkP = hash_find(&contextP->objectListTable, hash) ;
+         linkP != NULL ;
+         linkP = hash_findNext(linkP))
+    {
+        listP = (lwm2m_client_object_list_t *)linkP->itemP;
+        if (listP->count == count
+         && memcmp(listP->objects, objects, count * sizeof(lwm2m_client_object_t)) == 0)
+        {
+            listP->refCount++;
+            return listP;
+        }
+    }
+
+    // the objects are stored after the list header
+    listP = (lwm2m_client_object_list_t *)lwm2m_malloc(sizeof(lwm2m_client_object_list_t) + count * sizeof(lwm2m_client_object_t));
+    if (listP == NULL) return NULL;
+    memset(listP, 0, sizeof(lwm2m_client_object_list_t));
+    listP->refCount = 1;
+    listP->count = count;
+    listP->objects = (lwm2m_client_object_t *)(listP + 1);
+    memcpy(listP->objects, objects, count * sizeof(lwm2m_client_object_t));
+    hash_add(&contextP->objectListTable, &listP->link, hash, listP);
+
+    return listP;
+}
+
+#define DIFF_MIN_SIZE 4     // must be a power of 2
+
+static bool prv_addDiffUri(lwm2m_uri_t ** listP,
+                           size_t * countP,
+                           uint16_t objectId,
+                           uint16_t instanceId)
+{
+    // the array is full when its count is 0 or a power of 2 from DIFF_MIN_SIZE
+    if (*countP == 0
+     || (*countP >= DIFF_MIN_SIZE && (*countP & (*countP - 1)) == 0))
     {
-        lwm2m_client_object_t * objP;
+        lwm2m_uri_t * newList;
+        size_t newSize;
 
-        while (objects->instanceList != NULL)
+        newSize = *countP == 0 ? DIFF_MIN_SIZE : *countP << 1;
+        newList = (lwm2m_uri_t *)lwm2m_malloc(newSize * sizeof(lwm2m_uri_t));
+        if (newList == NULL) return false;
+        if (*listP != NULL)
         {
-            lwm2m_list_t * target;
+            memcpy(newList, *listP, *countP * sizeof(lwm2m_uri_t));
+            lwm2m_free(*listP);
+        }
+        *listP = newList;
+    }
+
+    LWM2M_URI_RESET(*listP + *countP);
+    (*listP)[*countP].objectId = objectId;
+    (*listP)[*countP].instanceId = instanceId;
+    (*countP)++;
+
+    return true;
+}
+
+static void prv_freeDiff(lwm2m_client_diff_t * diffP)
+{
+    if (diffP->addedList != NULL) lwm2m_free(diffP->addedList);
+    if (diffP->removedList != NULL) lwm2m_free(diffP->removedList);
+    memset(diffP, 0, sizeof(lwm2m_client_diff_t));
+}
+
+// Returns the index of the first entry of the next object.
+static size_t prv_nextObject(lwm2m_client_object_list_t * listP,
+                             size_t index)
+{
+    uint16_t objectId = listP->objects[index].objectId;
+
+    while (index < listP->count && listP->objects[index].objectId == objectId) index++;
+
+    return index;
+}
+
+static bool prv_diffInstances(lwm2m_client_object_list_t * oldP,
+                              size_t i,
+                              size_t iEnd,
+                              lwm2m_client_object_list_t * newP,
+                              size_t j,
+                              size_t jEnd,
+                              lwm2m_client_diff_t * diffP)
+{
+    lwm2m_client_object_t * oldObjects = oldP->objects;
+    lwm2m_client_object_t * newObjects = newP->objects;
 
-            target = objects->instanceList;
-            objects->instanceList = objects->instanceList->next;
-            lwm2m_free(target);
+    while (i < iEnd || j < jEnd)
+    {
+        // an object registered without instance has no instance to compare
+        if (i < iEnd && oldObjects[i].instanceId == LWM2M_MAX_ID)
+        {
+            i++;
+        }
+        else if (j < jEnd && newObjects[j].instanceId == LWM2M_MAX_ID)
+        {
+            j++;
+        }
+        else if (j == jEnd || (i < iEnd && oldObjects[i].instanceId < newObjects[j].instanceId))
+        {
+            if (!prv_addDiffUri(&diffP->removedList, &diffP->removedCount, oldObjects[i].objectId, oldObjects[i].instanceId)) return false;
+            i++;
+        }
+        else if (i == iEnd || newObjects[j].instanceId < oldObjects[i].instanceId)
+        {
+            if (!prv_addDiffUri(&diffP->addedList, &diffP->addedCount, newObjects[j].objectId, newObjects[j].instanceId)) return false;
+            j++;
         }
+        else
+        {
+            i++;
+            j++;
+        }
+    }
+
+    return true;
+}
+
+// Both lists are sorted, they are compared in one pass.
+static bool prv_diffObjectList(lwm2m_client_object_list_t * oldP,
+                               lwm2m_client_object_list_t * newP,
+                               lwm2m_client_diff_t * diffP)
+{
+    size_t i;
+    size_t j;
 
-        objP = objects;
-        objects = objects->next;
-        lwm2m_free(objP);
+    // identical lists are shared
+    if (oldP == newP) return true;
+
+    i = 0;
+    j = 0;
+    while (i < oldP->count || j < newP->count)
+    {
+        if (j == newP->count
+         || (i < oldP->count && oldP->objects[i].objectId < newP->objects[j].objectId))
+        {
+            if (!prv_addDiffUri(&diffP->removedList, &diffP->removedCount, oldP->objects[i].objectId, LWM2M_MAX_ID)) return false;
+            i = prv_nextObject(oldP, i);
+        }
+        else if (i == oldP->count || newP->objects[j].objectId < oldP->objects[i].objectId)
+        {
+            if (!prv_addDiffUri(&diffP->addedList, &diffP->addedCount, newP->objects[j].objectId, LWM2M_MAX_ID)) return false;
+            j = prv_nextObject(newP, j);
+        }
+        else
+        {
+            size_t iEnd = prv_nextObject(oldP, i);
+            size_t jEnd = prv_nextObject(newP, j);
+
+            if (!prv_diffInstances(oldP, i, iEnd, newP, j, jEnd, diffP)) return false;
+            i = iEnd;
+            j = jEnd;
+        }
     }
+
+    return true;
+}
+
+// Returns true if the object, and the instance if set, of the URI are in the list.
+static bool prv_isRegistered(lwm2m_client_object_list_t * listP,
+                             lwm2m_uri_t * uriP)
+{
+    uint16_t instanceId = LWM2M_URI_IS_SET_INSTANCE(uriP) ? uriP->instanceId : 0;
+    uint32_t key = ((uint32_t)uriP->objectId << 16) | instanceId;
+    size_t low = 0;
+    size_t high = listP->count;
+
+    // first entry not lower than the key
+    while (low < high)
+    {
+        size_t middle = low + (high - low) / 2;
+        uint32_t middleKey = ((uint32_t)listP->objects[middle].objectId << 16) | listP->objects[middle].instanceId;
+
+        if (middleKey < key) low = middle + 1;
+        else high = middle;
+    }
+
+    if (low == listP->count || listP->objects[low].objectId != uriP->objectId) return false;
+
+    return !LWM2M_URI_IS_SET_INSTANCE(uriP) || listP->objects[low].instanceId == instanceId;
 }
 
 static int prv_getParameters(multi_option_t * query,
@@ -1231,135 +1415,54 @@ error:
     return -1;
 }
 
-static uint16_t prv_splitLinkAttribute(uint8_t * data,
-                                       uint16_t length,
-                                       uint16_t * keyStart,
-                                       uint16_t * keyLength,
-                                       uint16_t * valueStart,
-                                       uint16_t * valueLength)
+static bool prv_isEqual(uint8_t * data,
+                        size_t length,
+                        const char * str,
+                        size_t strLength)
 {
-    uint16_t index;
-    uint16_t end;
-
-    index = 0;
-    while (index < length && data[index] == ' ') index++;
-    if (index == length) return 0;
-
-    if (data[index] == REG_ATTR_SEPARATOR)
-    {
-        index++;
-    }
-    if (index == length) return 0;
-
-    *keyStart = index;
-
-    while (index < length && data[index] != REG_ATTR_EQUALS) index++;
-    if (index == *keyStart || index == length) return 0;
-
-    *keyLength = index - *keyStart;
-
-    index++;
-    while (index < length && data[index] == ' ') index++;
-    if (index == length) return 0;
-
-    *valueStart = index;
-
-    while (index < length && data[index] != REG_ATTR_SEPARATOR) index++;
-    end = index;
-
-    index--;
-    while (index > *valueStart && data[index] == ' ') index--;
-    if (index == *valueStart) return 0;
-
-    *valueLength = index - *valueStart + 1;
-
-    return end;
+    return length == strLength && memcmp(data, str, length) == 0;
 }
 
-static int prv_parseLinkAttributes(uint8_t * data,
-                                   uint16_t length,
+// Returns 1 if the attributes are valid, 0 if not, -1 if the alternate path cannot be allocated.
+static int prv_parseLinkAttributes(link_entry_t * linkP,
                                    lwm2m_media_type_t * format,
                                    char ** altPath)
 {
-    uint16_t index;
-    uint16_t pathStart;
-    uint16_t pathLength;
+    size_t index;
     bool isValid;
+    uint8_t * key;
+    size_t keyLength;
+    uint8_t * value;
+    size_t valueLength;
+    int result;
 
     isValid = false;
-
-    // Expecting application/link-format (RFC6690)
-    // leading space were removed before. Remove trailing spaces.
-    while (length > 0 && data[length-1] == ' ') length--;
-
-    // strip open tag
-    if (length >= 2 && data[0] == REG_URI_START)
-    {
-        data += 1;
-        length -= 1;
-    }
-    else
-    {
-        return 0;
-    }
-
-    pathStart = 0;
-    index = length - 1;
-    while (index > 0 && data[index] != REG_URI_END) index--;
-    // link attributes are required
-    if (index == 0 || index == length - 1) return 0;
-
-    // If there is a preceding /, remove it
-    if (data[pathStart] == '/')
-    {
-        pathStart += 1;
-    }
-    pathLength = index - pathStart;
-
-    index++;
-    if (index >= length || data[index] != REG_ATTR_SEPARATOR) return 0;
-    index++;
-
-    while (index < length)
+    index = 0;
+    while (0 < (result = linkformat_nextAttribute(linkP->attributes, linkP->attributesLength, &index, &key, &keyLength, &value, &valueLength)))
     {
-        uint16_t result;
-        uint16_t keyStart;
-        uint16_t keyLength;
-        uint16_t valueStart;
-        uint16_t valueLength;
-
-        result = prv_splitLinkAttribute(data + index, length - index, &keyStart, &keyLength, &valueStart, &valueLength);
-        if (result == 0) return 0;
-
-        if (keyLength == REG_ATTR_TYPE_KEY_LEN
-         && 0 == lwm2m_strncmp(REG_ATTR_TYPE_KEY, (char*)data + index + keyStart, keyLength))
+        if (prv_isEqual(key, keyLength, REG_ATTR_TYPE_KEY, REG_ATTR_TYPE_KEY_LEN))
         {
             if (isValid == true) return 0; // declared twice
-            if (valueLength != REG_ATTR_TYPE_VALUE_LEN
-             || 0 != lwm2m_strncmp(REG_ATTR_TYPE_VALUE, (char*)data + index + valueStart, valueLength))
+            if (!prv_isEqual(value, valueLength, REG_ATTR_TYPE_VALUE, REG_ATTR_TYPE_VALUE_LEN))
             {
                 return 0;
             }
             isValid = true;
         }
-        else if (keyLength == REG_ATTR_CONTENT_KEY_LEN
-              && 0 == lwm2m_strncmp(REG_ATTR_CONTENT_KEY, (char*)data + index + keyStart, keyLength))
+        else if (prv_isEqual(key, keyLength, REG_ATTR_CONTENT_KEY, REG_ATTR_CONTENT_KEY_LEN))
         {
             if (*format != LWM2M_CONTENT_TLV) return 0; // declared twice
-            if (valueLength == REG_ATTR_CONTENT_JSON_LEN
-             && 0 == lwm2m_strncmp(REG_ATTR_CONTENT_JSON, (char*)data + index + valueStart, valueLength))
+            if (prv_isEqual(value, valueLength, REG_ATTR_CONTENT_JSON, REG_ATTR_CONTENT_JSON_LEN))
             {
                 *format = LWM2M_CONTENT_JSON;
             }
 #ifdef LWM2M_OLD_CONTENT_FORMAT_SUPPORT
-            else if (valueLength == REG_ATTR_CONTENT_JSON_OLD_LEN
-             && 0 == lwm2m_strncmp(REG_ATTR_CONTENT_JSON_OLD, (char*)data + index + valueStart, valueLength))
+            else if (prv_isEqual(value, valueLength, REG_ATTR_CONTENT_JSON_OLD, REG_ATTR_CONTENT_JSON_OLD_LEN))
             {
                 *format = LWM2M_CONTENT_JSON_OLD;
             }
 #endif
-            else if (valueLength == REG_ATTR_CONTENT_SENML_JSON_LEN
-             && 0 == lwm2m_strncmp(REG_ATTR_CONTENT_SENML_JSON, (char*)data + index + valueStart, valueLength))
+            else if (prv_isEqual(value, valueLength, REG_ATTR_CONTENT_SENML_JSON, REG_ATTR_CONTENT_SENML_JSON_LEN))
             {
                 *format = LWM2M_CONTENT_SENML_JSON;
             }
@@ -1369,154 +1472,190 @@ static int prv_parseLinkAttributes(uint8_t * data,
             }
         }
         // else ignore this one
-
-        index += result;
     }
 
-    if (isValid == false) return 0;
+    if (result < 0 || isValid == false) return 0;
 
-    if (pathLength != 0)
+    if (linkP->pathLength != 0)
     {
-        *altPath = (char *)lwm2m_malloc(pathLength + 1);
-        if (*altPath == NULL) return 0;
-        memcpy(*altPath, data + pathStart, pathLength);
-        (*altPath)[pathLength] = 0;
+        *altPath = (char *)lwm2m_malloc(linkP->pathLength + 1);
+        if (*altPath == NULL) return -1;
+        memcpy(*altPath, linkP->path, linkP->pathLength);
+        (*altPath)[linkP->pathLength] = 0;
     }
 
     return 1;
 }
 
-static int prv_getId(uint8_t * data,
-                     uint16_t length,
-                     uint16_t * objId,
-                     uint16_t * instanceId)
+// Parses "object" or "object/instance". instanceId is set to LWM2M_MAX_ID when absent.
+static bool prv_getId(uint8_t * data,
+                      size_t length,
+                      uint16_t * objId,
+                      uint16_t * instanceId)
 {
-    int value;
-    uint16_t limit;
+    uint32_t value;
+    size_t index;
 
-    // Expecting application/link-format (RFC6690)
-    // leading space were removed before. Remove trailing spaces.
-    while (length > 0 && data[length-1] == ' ') length--;
+    *instanceId = LWM2M_MAX_ID;
 
-    // strip open and close tags
-    if (length >= 1 && data[0] == REG_URI_START && data[length-1] == REG_URI_END)
+    value = 0;
+    for (index = 0 ; index < length && data[index] != '/' ; index++)
     {
-        data += 1;
-        length -= 2;
+        if (data[index] < '0' || data[index] > '9') return false;
+        value = value * 10 + (data[index] - '0');
+        if (value >= LWM2M_MAX_ID) return false;
     }
-    else
+    if (index == 0) return false;
+    *objId = (uint16_t)value;
+
+    // a trailing '/' without instance is accepted
+    if (index + 1 >= length) return true;
+
+    value = 0;
+    for (index = index + 1 ; index < length ; index++)
     {
-        return 0;
+        if (data[index] < '0' || data[index] > '9') return false;
+        value = value * 10 + (data[index] - '0');
+        if (value >= LWM2M_MAX_ID) return false;
     }
+    *instanceId = (uint16_t)value;
+
+    return true;
+}
+
+#define OBJECT_LIST_MIN_SIZE 16
 
-    // If there is a preceding /, remove it
-    if (length >= 1 && data[0] == '/')
+// Inserts an object in a sorted array, growing it by doubling.
+static bool prv_addObject(lwm2m_client_object_t ** objectsP,
+                          size_t * countP,
+                          size_t * sizeP,
+                          uint16_t objectId,
+                          uint16_t instanceId)
+{
+    lwm2m_client_object_t * objects = *objectsP;
+    size_t index;
+
+    // the objects are usually registered in order
+    index = *countP;
+    while (index > 0
+        && (objects[index - 1].objectId > objectId
+         || (objects[index - 1].objectId == objectId && objects[index - 1].instanceId > instanceId)))
     {
-        data += 1;
-        length -= 1;
+        index--;
+    }
+    if (index > 0
+     && objects[index - 1].objectId == objectId
+     && objects[index - 1].instanceId == instanceId)
+    {
+        return true;
     }
 
-    limit = 0;
-    while (limit < length && data[limit] != '/') limit++;
-    value = uri_getNumber(data, limit);
-    if (value < 0 || value >= LWM2M_MAX_ID) return 0;
-    *objId = value;
-
-    if (limit < length)
+    if (*countP == *sizeP)
     {
-        limit += 1;
-        data += limit;
-        length -= limit;
+        lwm2m_client_object_t * newObjects;
+        size_t newSize;
 
-        if (length > 0)
+        newSize = *sizeP == 0 ? OBJECT_LIST_MIN_SIZE : *sizeP << 1;
+        newObjects = (lwm2m_client_object_t *)lwm2m_malloc(newSize * sizeof(lwm2m_client_object_t));
+        if (newObjects == NULL) return false;
+        if (objects != NULL)
         {
-            value = uri_getNumber(data, length);
-            if (value >= 0 && value < LWM2M_MAX_ID)
-            {
-                *instanceId = value;
-                return 2;
-            }
-            else
-            {
-                return 0;
-            }
+            memcpy(newObjects, objects, *countP * sizeof(lwm2m_client_object_t));
+            lwm2m_free(objects);
         }
+        objects = newObjects;
+        *objectsP = objects;
+        *sizeP = newSize;
     }
 
-    return 1;
+    memmove(objects + index + 1, objects + index, (*countP - index) * sizeof(lwm2m_client_object_t));
+    objects[index].objectId = objectId;
+    objects[index].instanceId = instanceId;
+    (*countP)++;
+
+    return true;
 }
 
-static lwm2m_client_object_t * prv_decodeRegisterPayload(uint8_t * payload,
-                                                         uint16_t payloadLength,
-                                                         lwm2m_media_type_t * format,
-                                                         char ** altPath)
+// Returns COAP_NO_ERROR with the object list in objListP, COAP_400_BAD_REQUEST if the payload
+// is invalid or has no object, or COAP_500_INTERNAL_SERVER_ERROR. objListP is NULL on error.
+static uint8_t prv_decodeRegisterPayload(lwm2m_context_t * contextP,
+                                         uint8_t * payload,
+                                         uint16_t payloadLength,
+                                         lwm2m_client_object_list_t ** objListP,
+                                         lwm2m_media_type_t * format,
+                                         char ** altPath)
 {
-    uint16_t index;
-    lwm2m_client_object_t * objList;
+    size_t index;
+    link_entry_t link;
+    int result;
+    uint8_t status;
+    lwm2m_client_object_t * objects;
+    size_t count;
+    size_t size;
+    size_t i;
+    size_t j;
     bool linkAttrFound;
 
+    *objListP = NULL;
     *altPath = NULL;
     *format = LWM2M_CONTENT_TLV;
-    objList = NULL;
+    objects = NULL;
+    count = 0;
+    size = 0;
     linkAttrFound = false;
     index = 0;
+    status = COAP_400_BAD_REQUEST;
 
-    while (index <= payloadLength)
+    while (0 < (result = linkformat_nextLink(payload, payloadLength, &index, &link)))
     {
-        uint16_t start;
-        uint16_t length;
-        int result;
-        uint16_t id;
-        uint16_t instance;
-
-        while (index < payloadLength && payload[index] == ' ') index++;
-        if (index == payloadLength) break;
-
-        start = index;
-        while (index < payloadLength && payload[index] != REG_DELIMITER) index++;
-        length = index - start;
-
-        result = prv_getId(payload + start, length, &id, &instance);
-        if (result != 0)
+        if (link.attributes == NULL)
         {
-            lwm2m_client_object_t * objectP;
+            uint16_t id;
+            uint16_t instance;
 
-            objectP = (lwm2m_client_object_t *)lwm2m_list_find((lwm2m_list_t *)objList, id);
-            if (objectP == NULL)
+            if (!prv_getId(link.path, link.pathLength, &id, &instance)) goto error;
+            if (!prv_addObject(&objects, &count, &size, id, instance))
             {
-                objectP = (lwm2m_client_object_t *)lwm2m_malloc(sizeof(lwm2m_client_object_t));
-                memset(objectP, 0, sizeof(lwm2m_client_object_t));
-                if (objectP == NULL) goto error;
-                objectP->id = id;
-                objList = (lwm2m_client_object_t *)LWM2M_LIST_ADD(objList, objectP);
-            }
-            if (result == 2)
-            {
-                lwm2m_list_t * instanceP;
-
-                instanceP = lwm2m_list_find(objectP->instanceList, instance);
-                if (instanceP == NULL)
-                {
-                    instanceP = (lwm2m_list_t *)lwm2m_malloc(sizeof(lwm2m_list_t));
-                    memset(instanceP, 0, sizeof(lwm2m_list_t));
-                    instanceP->id = instance;
-                    objectP->instanceList = LWM2M_LIST_ADD(objectP->instanceList, instanceP);
-                }
+                status = COAP_500_INTERNAL_SERVER_ERROR;
+                goto error;
             }
         }
         else if (linkAttrFound == false)
         {
-            result = prv_parseLinkAttributes(payload + start, length, format, altPath);
-            if (result == 0) goto error;
+            result = prv_parseLinkAttributes(&link, format, altPath);
+            if (result < 0) status = COAP_500_INTERNAL_SERVER_ERROR;
+            if (result <= 0) goto error;
 
             linkAttrFound = true;
         }
         else goto error;
+    }
+    if (result < 0 || count == 0) goto error;
+
+    // an object is registered without instance only if none of its instances is
+    j = 0;
+    for (i = 0 ; i < count ; i++)
+    {
+        if (objects[i].instanceId == LWM2M_MAX_ID
+         && j > 0
+         && objects[j - 1].objectId == objects[i].objectId)
+        {
+            continue;
+        }
+        objects[j] = objects[i];
+        j++;
+    }
 
-        index++;
+    *objListP = prv_internObjectList(contextP, objects, j);
+    lwm2m_free(objects);
+    objects = NULL;
+    if (*objListP == NULL)
+    {
+        status = COAP_500_INTERNAL_SERVER_ERROR;
+        goto error;
     }
 
-    return objList;
+    return COAP_NO_ERROR;
 
 error:
     if (*altPath != NULL)
@@ -1524,32 +1663,78 @@ error:
         lwm2m_free(*altPath);
         *altPath = NULL;
     }
-    prv_freeClientObjectList(objList);
+    if (objects != NULL) lwm2m_free(objects);
 
-    return NULL;
+    return status;
 }
 
+// name is not nul-terminated
 static lwm2m_client_t * prv_getClientByName(lwm2m_context_t * contextP,
-                                            char * name)
+                                            const uint8_t * name,
+                                            size_t length)
 {
-    lwm2m_client_t * targetP;
+    lwm2m_hash_link_t * linkP;
 
-    targetP = contextP->clientList;
-    while (targetP != NULL && strcmp(name, targetP->name) != 0)
+    for (linkP = hash_find(&contextP->clientNameTable, hash_bytes(name, length)) ;
+         linkP != NULL ;
+         linkP = hash_findNext(linkP))
     {
-        targetP = targetP->next;
+        lwm2m_client_t * targetP = (lwm2m_client_t *)linkP->itemP;
+
+        if (lwm2m_strncmp((char *)name, targetP->name, length) == 0
+         && targetP->name[length] == 0)
+        {
+            return targetP;
+        }
     }
 
-    return targetP;
+    return NULL;
+}
+
+static bool prv_addClient(lwm2m_context_t * contextP,
+                          lwm2m_client_t * clientP)
+{
+    if (!slot_add(&contextP->clientSlots, clientP, &clientP->internalID)) return false;
+
+    // the list is not sorted, clients are found by ID in the slot table
+    clientP->prev = NULL;
+    clientP->next = contextP->clientList;
+    if (contextP->clientList != NULL) contextP->clientList->prev = clientP;
+    contextP->clientList = clientP;
+    hash_add(&contextP->clientNameTable, &clientP->nameLink, hash_string(clientP->name), clientP);
+
+    return true;
 }
 
-void registration_freeClient(lwm2m_client_t * clientP)
+static void prv_removeClient(lwm2m_context_t * contextP,
+                             lwm2m_client_t * clientP)
+{
+    lwm2m_observation_t * observationP;
+
+    if (clientP->prev != NULL) clientP->prev->next = clientP->next;
+    else contextP->clientList = clientP->next;
+    if (clientP->next != NULL) clientP->next->prev = clientP->prev;
+    clientP->next = NULL;
+    clientP->prev = NULL;
+    slot_remove(&contextP->clientSlots, clientP->internalID);
+    hash_remove(&contextP->clientNameTable, &clientP->nameLink);
+    hash_remove(&contextP->clientSessionTable, &clientP->sessionLink);
+    timer_cancel(&contextP->clientTimers, &clientP->lifetimeTimer);
+    // the observations are freed with the client
+    for (observationP = clientP->observationList ; observationP != NULL ; observationP = observationP->next)
+    {
+        hash_remove(&contextP->observationTokenTable, &observationP->tokenLink);
+    }
+}
+
+void registration_freeClient(lwm2m_context_t * contextP,
+                             lwm2m_client_t * clientP)
 {
     LOG("Entering");
     if (clientP->name != NULL) lwm2m_free(clientP->name);
     if (clientP->msisdn != NULL) lwm2m_free(clientP->msisdn);
     if (clientP->altPath != NULL) lwm2m_free(clientP->altPath);
-    prv_freeClientObjectList(clientP->objectList);
+    prv_releaseObjectList(contextP, clientP->objectList);
     while(clientP->observationList != NULL)
     {
         lwm2m_observation_t * targetP;
@@ -1579,6 +1764,66 @@ static int prv_getLocationString(uint16_t id,
     return index + result;
 }
 
+// Checks a Register request before it is decoded.
+// Returns NO_ERROR if the request must be processed, otherwise the response code.
+static uint8_t prv_admitRegistration(lwm2m_context_t * contextP,
+                                     time_t currentTime,
+                                     void * fromSessionH,
+                                     coap_packet_t * message,
+                                     coap_packet_t * response)
+{
+    multi_option_t * queryP;
+    lwm2m_client_t * clientP;
+    char location[MAX_LOCATION_LENGTH];
+
+    for (queryP = message->uri_query ; queryP != NULL ; queryP = queryP->next)
+    {
+        if (queryP->len > QUERY_NAME_LEN
+         && lwm2m_strncmp((char *)queryP->data, QUERY_NAME, QUERY_NAME_LEN) == 0)
+        {
+            break;
+        }
+    }
+    if (queryP != NULL)
+    {
+        clientP = prv_getClientByName(contextP, queryP->data + QUERY_NAME_LEN, queryP->len - QUERY_NAME_LEN);
+        if (clientP != NULL
+         && clientP->registrationMid == message->mid
+         && currentTime - clientP->registrationTime < COAP_EXCHANGE_LIFETIME
+         && lwm2m_session_is_equal(clientP->sessionH, fromSessionH, contextP->userData))
+        {
+            // retransmission of an accepted Register, its response was lost
+            LOG_ARG("Register retransmission from client %d", clientP->internalID);
+            if (prv_getLocationString(clientP->internalID, location) == 0
+             || coap_set_header_location_path(response, location) == 0)
+            {
+                return COAP_500_INTERNAL_SERVER_ERROR;
+            }
+            return COAP_201_CREATED;
+        }
+    }
+
+    if (contextP->registrationLimit == 0) return NO_ERROR;
+
+    if (contextP->registrationWindow != currentTime)
+    {
+        contextP->registrationWindow = currentTime;
+        contextP->registrationCount = 0;
+    }
+    contextP->registrationCount++;
+    if (contextP->registrationCount <= contextP->registrationLimit) return NO_ERROR;
+
+    LOG_ARG("Register rejected, %u requests in this second", contextP->registrationCount);
+    if (contextP->registrationBackoff != 0)
+    {
+        // spread the retries of the rejected clients
+        coap_set_header_max_age(response, contextP->registrationBackoff
+                                          + (contextP->registrationCount - contextP->registrationLimit - 1) % contextP->registrationBackoff);
+    }
+
+    return COAP_503_SERVICE_UNAVAILABLE;
+}
+
 uint8_t registration_handleRequest(lwm2m_context_t * contextP,
                                    lwm2m_uri_t * uriP,
                                    void * fromSessionH,
@@ -1589,7 +1834,7 @@ uint8_t registration_handleRequest(lwm2m_context_t * contextP,
     time_t tv_sec;
 
     LOG_URI(uriP);
-    tv_sec = lwm2m_gettime();
+    tv_sec = utils_gettime();
     if (tv_sec < 0) return COAP_500_INTERNAL_SERVER_ERROR;
 
     switch(message->code)
@@ -1602,11 +1847,18 @@ uint8_t registration_handleRequest(lwm2m_context_t * contextP,
         char * altPath;
         lwm2m_version_t version;
         lwm2m_binding_t binding;
-        lwm2m_client_object_t * objects;
+        lwm2m_client_object_list_t * objects;
         lwm2m_media_type_t format;
         lwm2m_client_t * clientP;
+        lwm2m_client_diff_t diff;
         char location[MAX_LOCATION_LENGTH];
 
+        if (!LWM2M_URI_IS_SET_OBJECT(uriP))
+        {
+            result = prv_admitRegistration(contextP, tv_sec, fromSessionH, message, response);
+            if (result != NO_ERROR) return result;
+        }
+
         if (0 != prv_getParameters(message->uri_query, &name, &lifetime, &msisdn, &binding, &version))
         {
             return COAP_400_BAD_REQUEST;
@@ -1617,7 +1869,13 @@ uint8_t registration_handleRequest(lwm2m_context_t * contextP,
             return COAP_400_BAD_REQUEST;
         }
 
-        objects = prv_decodeRegisterPayload(message->payload, message->payload_len, &format, &altPath);
+        // an invalid payload is handled as a missing object list
+        if (prv_decodeRegisterPayload(contextP, message->payload, message->payload_len, &objects, &format, &altPath) == COAP_500_INTERNAL_SERVER_ERROR)
+        {
+            if (name != NULL) lwm2m_free(name);
+            if (msisdn != NULL) lwm2m_free(msisdn);
+            return COAP_500_INTERNAL_SERVER_ERROR;
+        }
 
         if (!LWM2M_URI_IS_SET_OBJECT(uriP))
         {
@@ -1627,12 +1885,14 @@ uint8_t registration_handleRequest(lwm2m_context_t * contextP,
             {
                 if (name != NULL) lwm2m_free(name);
                 if (msisdn != NULL) lwm2m_free(msisdn);
+                prv_releaseObjectList(contextP, objects);
                 return COAP_400_BAD_REQUEST;
             }
             // Endpoint client name is mandatory
             if (name == NULL)
             {
                 if (msisdn != NULL) lwm2m_free(msisdn);
+                prv_releaseObjectList(contextP, objects);
                 return COAP_400_BAD_REQUEST;
             }
             // Object list is mandatory
@@ -1654,6 +1914,7 @@ uint8_t registration_handleRequest(lwm2m_context_t * contextP,
             default:
                 lwm2m_free(name);
                 if (msisdn != NULL) lwm2m_free(msisdn);
+                prv_releaseObjectList(contextP, objects);
                 return COAP_412_PRECONDITION_FAILED;
             }
 
@@ -1662,14 +1923,14 @@ uint8_t registration_handleRequest(lwm2m_context_t * contextP,
                 lifetime = LWM2M_DEFAULT_LIFETIME;
             }
 
-            clientP = prv_getClientByName(contextP, name);
+            clientP = prv_getClientByName(contextP, (uint8_t *)name, strlen(name));
             if (clientP != NULL)
             {
                 // we reset this registration
                 lwm2m_free(clientP->name);
                 if (clientP->msisdn != NULL) lwm2m_free(clientP->msisdn);
                 if (clientP->altPath != NULL) lwm2m_free(clientP->altPath);
-                prv_freeClientObjectList(clientP->objectList);
+                prv_releaseObjectList(contextP, clientP->objectList);
                 clientP->objectList = NULL;
             }
             else
@@ -1680,13 +1941,22 @@ uint8_t registration_handleRequest(lwm2m_context_t * contextP,
                     lwm2m_free(name);
                     lwm2m_free(altPath);
                     if (msisdn != NULL) lwm2m_free(msisdn);
-                    prv_freeClientObjectList(objects);
+                    prv_releaseObjectList(contextP, objects);
                     return COAP_500_INTERNAL_SERVER_ERROR;
                 }
                 memset(clientP, 0, sizeof(lwm2m_client_t));
-                clientP->internalID = lwm2m_list_newId((lwm2m_list_t *)contextP->clientList);
-                contextP->clientList = (lwm2m_client_t *)LWM2M_LIST_ADD(contextP->clientList, clientP);
+                clientP->name = name;
+                if (!prv_addClient(contextP, clientP))
+                {
+                    lwm2m_free(clientP);
+                    lwm2m_free(name);
+                    lwm2m_free(altPath);
+                    if (msisdn != NULL) lwm2m_free(msisdn);
+                    prv_releaseObjectList(contextP, objects);
+                    return COAP_500_INTERNAL_SERVER_ERROR;
+                }
             }
+            // same hash value as the name of a reset registration
             clientP->name = name;
             clientP->version = version;
             clientP->binding = binding;
@@ -1697,15 +1967,23 @@ uint8_t registration_handleRequest(lwm2m_context_t * contextP,
             clientP->endOfLife = tv_sec + lifetime;
             clientP->objectList = objects;
             clientP->sessionH = fromSessionH;
-
-            if (prv_getLocationString(clientP->internalID, location) == 0)
+            clientP->registrationTime = tv_sec;
+            clientP->registrationMid = message->mid;
+            // a reset registration may come from a new session
+            hash_remove(&contextP->clientSessionTable, &clientP->sessionLink);
+            hash_add(&contextP->clientSessionTable, &clientP->sessionLink, utils_sessionHash(contextP, fromSessionH), clientP);
+
+            if (!timer_schedule(&contextP->clientTimers, &clientP->lifetimeTimer, clientP->endOfLife, clientP)
+             || prv_getLocationString(clientP->internalID, location) == 0)
             {
-                registration_freeClient(clientP);
+                prv_removeClient(contextP, clientP);
+                registration_freeClient(contextP, clientP);
                 return COAP_500_INTERNAL_SERVER_ERROR;
             }
             if (coap_set_header_location_path(response, location) == 0)
             {
-                registration_freeClient(clientP);
+                prv_removeClient(contextP, clientP);
+                registration_freeClient(contextP, clientP);
                 return COAP_500_INTERNAL_SERVER_ERROR;
             }
 
@@ -1718,19 +1996,39 @@ uint8_t registration_handleRequest(lwm2m_context_t * contextP,
         else
         {
             // Registration update
-            if (LWM2M_URI_IS_SET_INSTANCE(uriP)) return COAP_400_BAD_REQUEST;
+            if (LWM2M_URI_IS_SET_INSTANCE(uriP))
+            {
+                prv_releaseObjectList(contextP, objects);
+                return COAP_400_BAD_REQUEST;
+            }
 
-            clientP = (lwm2m_client_t *)lwm2m_list_find((lwm2m_list_t *)contextP->clientList, uriP->objectId);
-            if (clientP == NULL) return COAP_404_NOT_FOUND;
+            clientP = lwm2m_get_client(contextP, uriP->objectId);
+            if (clientP == NULL)
+            {
+                prv_releaseObjectList(contextP, objects);
+                return COAP_404_NOT_FOUND;
+            }
 
             // Endpoint client name MUST NOT be present
             if (name != NULL)
             {
                 lwm2m_free(name);
                 if (msisdn != NULL) lwm2m_free(msisdn);
+                prv_releaseObjectList(contextP, objects);
                 return COAP_400_BAD_REQUEST;
             }
 
+            memset(&diff, 0, sizeof(diff));
+            if (objects != NULL
+             && !prv_diffObjectList(clientP->objectList, objects, &diff))
+            {
+                prv_freeDiff(&diff);
+                if (msisdn != NULL) lwm2m_free(msisdn);
+                if (altPath != NULL) lwm2m_free(altPath);
+                prv_releaseObjectList(contextP, objects);
+                return COAP_500_INTERNAL_SERVER_ERROR;
+            }
+
             if (binding != BINDING_UNKNOWN)
             {
                 clientP->binding = binding;
@@ -1746,6 +2044,8 @@ uint8_t registration_handleRequest(lwm2m_context_t * contextP,
             }
             // client IP address, port or MSISDN may have changed
             clientP->sessionH = fromSessionH;
+            hash_remove(&contextP->clientSessionTable, &clientP->sessionLink);
+            hash_add(&contextP->clientSessionTable, &clientP->sessionLink, utils_sessionHash(contextP, fromSessionH), clientP);
 
             if (objects != NULL)
             {
@@ -1755,50 +2055,38 @@ uint8_t registration_handleRequest(lwm2m_context_t * contextP,
                 observationP = clientP->observationList;
                 while (observationP != NULL)
                 {
-                    lwm2m_client_object_t * objP;
                     lwm2m_observation_t * nextP;
 
                     nextP = observationP->next;
 
-                    objP = (lwm2m_client_object_t *)lwm2m_list_find((lwm2m_list_t *)objects, observationP->uri.objectId);
-                    if (objP == NULL)
+                    if (!prv_isRegistered(objects, &observationP->uri))
                     {
                         observationP->callback(clientP->internalID,
                                                &observationP->uri,
                                                COAP_202_DELETED,
                                                LWM2M_CONTENT_TEXT, NULL, 0,
                                                observationP->userData);
-                        observe_remove(observationP);
-                    }
-                    else
-                    {
-                        if (LWM2M_URI_IS_SET_INSTANCE(&observationP->uri))
-                        {
-                            if (lwm2m_list_find((lwm2m_list_t *)objP->instanceList, observationP->uri.instanceId) == NULL)
-                            {
-                                observationP->callback(clientP->internalID,
-                                                       &observationP->uri,
-                                                       COAP_202_DELETED,
-                                                       LWM2M_CONTENT_TEXT, NULL, 0,
-                                                       observationP->userData);
-                                observe_remove(observationP);
-                            }
-                        }
+                        observe_remove(contextP, observationP);
                     }
 
                     observationP = nextP;
                 }
 
-                prv_freeClientObjectList(clientP->objectList);
+                prv_releaseObjectList(contextP, clientP->objectList);
                 clientP->objectList = objects;
             }
 
             clientP->endOfLife = tv_sec + clientP->lifetime;
+            // already scheduled, moving it cannot fail
+            (void)timer_schedule(&contextP->clientTimers, &clientP->lifetimeTimer, clientP->endOfLife, clientP);
 
             if (contextP->monitorCallback != NULL)
             {
+                if (objects != NULL) clientP->objectDiff = &diff;
                 contextP->monitorCallback(clientP->internalID, NULL, COAP_204_CHANGED, LWM2M_CONTENT_TEXT, NULL, 0, contextP->monitorUserData);
+                clientP->objectDiff = NULL;
             }
+            prv_freeDiff(&diff);
             result = COAP_204_CHANGED;
         }
     }
@@ -1811,13 +2099,14 @@ uint8_t registration_handleRequest(lwm2m_context_t * contextP,
         if (!LWM2M_URI_IS_SET_OBJECT(uriP)) return COAP_400_BAD_REQUEST;
         if (LWM2M_URI_IS_SET_INSTANCE(uriP)) return COAP_400_BAD_REQUEST;
 
-        contextP->clientList = (lwm2m_client_t *)LWM2M_LIST_RM(contextP->clientList, uriP->objectId, &clientP);
+        clientP = lwm2m_get_client(contextP, uriP->objectId);
         if (clientP == NULL) return COAP_400_BAD_REQUEST;
+        prv_removeClient(contextP, clientP);
         if (contextP->monitorCallback != NULL)
         {
             contextP->monitorCallback(clientP->internalID, NULL, COAP_202_DELETED, LWM2M_CONTENT_TEXT, NULL, 0, contextP->monitorUserData);
         }
-        registration_freeClient(clientP);
+        registration_freeClient(contextP, clientP);
         result = COAP_202_DELETED;
     }
     break;
@@ -1837,6 +2126,39 @@ void lwm2m_set_monitoring_callback(lwm2m_context_t * contextP,
     contextP->monitorCallback = callback;
     contextP->monitorUserData = userData;
 }
+
+void lwm2m_set_registration_limit(lwm2m_context_t * contextP,
+                                  uint32_t maxPerSecond,
+                                  uint32_t backoff)
+{
+    LOG_ARG("maxPerSecond: %u, backoff: %u", maxPerSecond, backoff);
+    contextP->registrationLimit = maxPerSecond;
+    contextP->registrationBackoff = backoff;
+    contextP->registrationCount = 0;
+}
+
+lwm2m_client_t * lwm2m_get_client(lwm2m_context_t * contextP,
+                                  uint16_t clientID)
+{
+    return (lwm2m_client_t *)slot_find(&contextP->clientSlots, clientID);
+}
+
+lwm2m_client_t * lwm2m_get_client_by_session(lwm2m_context_t * contextP,
+                                             void * sessionH)
+{
+    lwm2m_hash_link_t * linkP;
+
+    for (linkP = hash_find(&contextP->clientSessionTable, utils_sessionHash(contextP, sessionH)) ;
+         linkP != NULL ;
+         linkP = hash_findNext(linkP))
+    {
+        lwm2m_client_t * targetP = (lwm2m_client_t *)linkP->itemP;
+
+        if (lwm2m_session_is_equal(targetP->sessionH, sessionH, contextP->userData) == true) return targetP;
+    }
+
+    return NULL;
+}
 #endif
 
 // for each server update the registration if needed
@@ -1847,7 +2169,12 @@ void registration_step(lwm2m_context_t * contextP,
 {
 #ifdef LWM2M_CLIENT_MODE
     lwm2m_server_t * targetP = contextP->serverList;
+#endif
+#ifdef LWM2M_SERVER_MODE
+    lwm2m_timer_t * timerP;
+#endif
 
+#ifdef LWM2M_CLIENT_MODE
     LOG_ARG("State: %s", STR_STATE(contextP->state));
 
     while (targetP != NULL)
@@ -1921,36 +2248,25 @@ void registration_step(lwm2m_context_t * contextP,
 
 #endif
 #ifdef LWM2M_SERVER_MODE
-    lwm2m_client_t * clientP;
-
     LOG("Entering");
-    // monitor clients lifetime
-    clientP = contextP->clientList;
-    while (clientP != NULL)
+    // monitor clients lifetime, only the expired clients are visited
+    while (NULL != (timerP = timer_peek(&contextP->clientTimers))
+        && timerP->time <= currentTime)
     {
-        lwm2m_client_t * nextP = clientP->next;
+        lwm2m_client_t * clientP = (lwm2m_client_t *)timerP->itemP;
 
-        if (clientP->endOfLife <= currentTime)
+        prv_removeClient(contextP, clientP);
+        if (contextP->monitorCallback != NULL)
         {
-            contextP->clientList = (lwm2m_client_t *)LWM2M_LIST_RM(contextP->clientList, clientP->internalID, NULL);
-            if (contextP->monitorCallback != NULL)
-            {
-                contextP->monitorCallback(clientP->internalID, NULL, COAP_202_DELETED, LWM2M_CONTENT_TEXT, NULL, 0, contextP->monitorUserData);
-            }
-            registration_freeClient(clientP);
+            contextP->monitorCallback(clientP->internalID, NULL, COAP_202_DELETED, LWM2M_CONTENT_TEXT, NULL, 0, contextP->monitorUserData);
         }
-        else
-        {
-            time_t interval;
-
-            interval = clientP->endOfLife - currentTime;
+        registration_freeClient(contextP, clientP);
+    }
 
-            if (*timeoutP > interval)
-            {
-                *timeoutP = interval;
-            }
-        }
-        clientP = nextP;
+    timerP = timer_peek(&contextP->clientTimers);
+    if (timerP != NULL && *timeoutP > timerP->time - currentTime)
+    {
+        *timeoutP = timerP->time - currentTime;
     }
 #endif
 
@@ -572,6 +572,20 @@ static int prv_convertRecord(const _record_t * recordArray,
             }
         }
 
+        switch (targetP->type)
+        {
+        case LWM2M_TYPE_STRING:
+        case LWM2M_TYPE_OPAQUE:
+        case LWM2M_TYPE_CORE_LINK:
+            // a later record of the same resource replaces its value
+            if (targetP->value.asBuffer.buffer != NULL) lwm2m_free(targetP->value.asBuffer.buffer);
+            targetP->value.asBuffer.buffer = NULL;
+            targetP->value.asBuffer.length = 0;
+            break;
+        default:
+            break;
+        }
+
         if (!prv_convertValue(recordArray + index, targetP)) goto error;
     }
 
@@ -786,6 +800,119 @@ error:
     return -1;
 }
 
+/* Returns 1 if the record has a base name, stored in uriP, 0 if not and -1 on error. */
+static int prv_parseBaseName(const uint8_t * buffer,
+                             size_t bufferLen,
+                             lwm2m_uri_t * uriP)
+{
+    size_t index;
+
+    index = 0;
+    do
+    {
+        size_t tokenStart;
+        size_t tokenLen;
+        size_t valueStart;
+        size_t valueLen;
+        int next;
+
+        next = json_split(buffer+index,
+                          bufferLen-index,
+                          &tokenStart,
+                          &tokenLen,
+                          &valueStart,
+                          &valueLen);
+        if (next < 0) return -1;
+
+        if (tokenLen == 2
+         && buffer[index+tokenStart] == 'b'
+         && buffer[index+tokenStart+1] == 'n')
+        {
+            /* Check for " around URI */
+            if (valueLen < 3
+             || buffer[index+valueStart] != '"'
+             || buffer[index+valueStart+valueLen-1] != '"')
+            {
+                return -1;
+            }
+            if (0 == lwm2m_stringToUri((const char *)buffer+index+valueStart+1, valueLen-2, uriP)) return -1;
+            return 1;
+        }
+
+        index += next + 1;
+    } while (index < bufferLen);
+
+    return 0;
+}
+
+int senml_json_nextPack(const uint8_t * buffer,
+                        size_t bufferLen,
+                        size_t * indexP,
+                        lwm2m_uri_t * uriP,
+                        size_t * startP,
+                        size_t * lengthP)
+{
+    size_t index;
+    size_t end;
+
+    index = *indexP;
+    if (index == 0)
+    {
+        index = json_skipSpace(buffer, bufferLen);
+        if (index == bufferLen) return -1;
+        if (buffer[index] != JSON_HEADER) return -1;
+        _GO_TO_NEXT_CHAR(index, buffer, bufferLen);
+    }
+    if (index >= bufferLen) return -1;
+    if (buffer[index] == JSON_FOOTER) return 0;
+
+    *startP = index;
+    end = index;
+    while (buffer[index] != JSON_FOOTER)
+    {
+        lwm2m_uri_t uri;
+        int itemLen;
+        int res;
+
+        itemLen = json_itemLength(buffer + index, bufferLen - index);
+        if (itemLen < 0) return -1;
+        res = prv_parseBaseName(buffer + index + 1, itemLen - 2, &uri);
+        if (res < 0) return -1;
+        if (index == *startP)
+        {
+            /* A pack starts with its base name */
+            if (res == 0) return -1;
+            memcpy(uriP, &uri, sizeof(lwm2m_uri_t));
+        }
+        else if (res == 1)
+        {
+            /* Start of the next pack */
+            break;
+        }
+
+        index += itemLen - 1;
+        end = index + 1;
+        _GO_TO_NEXT_CHAR(index, buffer, bufferLen);
+        switch (buffer[index])
+        {
+        case JSON_SEPARATOR:
+            _GO_TO_NEXT_CHAR(index, buffer, bufferLen);
+            break;
+        case JSON_FOOTER:
+            break;
+        default:
+            return -1;
+        }
+    }
+
+    *indexP = index;
+    *lengthP = end - *startP;
+    return 1;
+
+error:
+    return -1;
+}
+
 static int prv_serializeValue(const lwm2m_data_t * tlvP,
                               uint8_t * buffer,
                               size_t bufferLen)
@@ -0,0 +1,119 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2026 Eclipse Wakaama contributors and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * The Eclipse Distribution License is available at
+ *    http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Please refer to git log
+ *
+ *******************************************************************************/
+
+/*
+ * Dense tables of items indexed by a 16-bit ID.
+ *
+ * The table gives the IDs and stores the item pointers in an array indexed
+ * by the ID. Released IDs are kept on a stack and given again before new
+ * ones, so the array stays dense and adding, finding or removing an item
+ * costs O(1).
+ */
+
+#include "internals.h"
+
+#define SLOT_TABLE_MIN_SIZE 8
+#define SLOT_TABLE_MAX_SIZE ((uint32_t)UINT16_MAX + 1)
+
+static bool prv_grow(lwm2m_slot_table_t * tableP)
+{
+    void ** newSlots;
+    uint16_t * newFreeIds;
+    uint32_t newSize;
+
+    if (tableP->size == SLOT_TABLE_MAX_SIZE) return false;
+
+    newSize = tableP->size == 0 ? SLOT_TABLE_MIN_SIZE : tableP->size << 1;
+    if (newSize > SLOT_TABLE_MAX_SIZE) newSize = SLOT_TABLE_MAX_SIZE;
+
+    newSlots = (void **)lwm2m_malloc(newSize * sizeof(void *));
+    if (newSlots == NULL) return false;
+    newFreeIds = (uint16_t *)lwm2m_malloc(newSize * sizeof(uint16_t));
+    if (newFreeIds == NULL)
+    {
+        lwm2m_free(newSlots);
+        return false;
+    }
+
+    memset(newSlots, 0, newSize * sizeof(void *));
+    if (tableP->slots != NULL)
+    {
+        memcpy(newSlots, tableP->slots, tableP->used * sizeof(void *));
+        memcpy(newFreeIds, tableP->freeIds, tableP->freeCount * sizeof(uint16_t));
+        lwm2m_free(tableP->slots);
+        lwm2m_free(tableP->freeIds);
+    }
+    tableP->slots = newSlots;
+    tableP->freeIds = newFreeIds;
+    tableP->size = newSize;
+
+    return true;
+}
+
+bool slot_add(lwm2m_slot_table_t * tableP,
+              void * itemP,
+              uint16_t * idP)
+{
+    uint16_t id;
+
+    if (tableP->freeCount > 0)
+    {
+        tableP->freeCount--;
+        id = tableP->freeIds[tableP->freeCount];
+    }
+    else
+    {
+        if (tableP->used == tableP->size
+         && !prv_grow(tableP))
+        {
+            return false;
+        }
+        id = (uint16_t)tableP->used;
+        tableP->used++;
+    }
+
+    tableP->slots[id] = itemP;
+    *idP = id;
+
+    return true;
+}
+
+void * slot_find(lwm2m_slot_table_t * tableP,
+                 uint16_t id)
+{
+    if (id >= tableP->used) return NULL;
+
+    return tableP->slots[id];
+}
+
+void slot_remove(lwm2m_slot_table_t * tableP,
+                 uint16_t id)
+{
+    if (id >= tableP->used || tableP->slots[id] == NULL) return;
+
+    tableP->slots[id] = NULL;
+    // the stack has room for every given ID
+    tableP->freeIds[tableP->freeCount] = id;
+    tableP->freeCount++;
+}
+
+void slot_free(lwm2m_slot_table_t * tableP)
+{
+    if (tableP->slots != NULL) lwm2m_free(tableP->slots);
+    if (tableP->freeIds != NULL) lwm2m_free(tableP->freeIds);
+    memset(tableP, 0, sizeof(lwm2m_slot_table_t));
+}
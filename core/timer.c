@@ -0,0 +1,157 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2026 Eclipse Wakaama contributors and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * The Eclipse Distribution License is available at
+ *    http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Please refer to git log
+ *
+ *******************************************************************************/
+
+/*
+ * Binary min-heaps of timers used to schedule the core internal events.
+ *
+ * Items embed one lwm2m_timer_t per heap they belong to. The timer stores
+ * its position in the heap so that rescheduling or cancelling it costs
+ * O(log n) and the next expiring timer is always at the root.
+ * The timer unit is chosen by the owner of the heap.
+ */
+
+#include "internals.h"
+
+#define TIMER_HEAP_MIN_SIZE 8
+
+static void prv_swap(lwm2m_timer_heap_t * heapP,
+                     uint32_t i,
+                     uint32_t j)
+{
+    lwm2m_timer_t * timerP;
+
+    timerP = heapP->timers[i];
+    heapP->timers[i] = heapP->timers[j];
+    heapP->timers[j] = timerP;
+
+    heapP->timers[i]->index = i + 1;
+    heapP->timers[j]->index = j + 1;
+}
+
+static void prv_siftUp(lwm2m_timer_heap_t * heapP,
+                       uint32_t i)
+{
+    while (i > 0)
+    {
+        uint32_t parent = (i - 1) / 2;
+
+        if (heapP->timers[parent]->time <= heapP->timers[i]->time) return;
+
+        prv_swap(heapP, i, parent);
+        i = parent;
+    }
+}
+
+static void prv_siftDown(lwm2m_timer_heap_t * heapP,
+                         uint32_t i)
+{
+    while (1)
+    {
+        uint32_t child = 2 * i + 1;
+
+        if (child >= heapP->count) return;
+        if (child + 1 < heapP->count
+         && heapP->timers[child + 1]->time < heapP->timers[child]->time)
+        {
+            child++;
+        }
+        if (heapP->timers[i]->time <= heapP->timers[child]->time) return;
+
+        prv_swap(heapP, i, child);
+        i = child;
+    }
+}
+
+bool timer_schedule(lwm2m_timer_heap_t * heapP,
+                    lwm2m_timer_t * timerP,
+                    int64_t time,
+                    void * itemP)
+{
+    timerP->time = time;
+    timerP->itemP = itemP;
+
+    if (timerP->index != 0)
+    {
+        // already scheduled, move it to its new place
+        prv_siftUp(heapP, timerP->index - 1);
+        prv_siftDown(heapP, timerP->index - 1);
+        return true;
+    }
+
+    if (heapP->count == heapP->size)
+    {
+        lwm2m_timer_t ** newTimers;
+        uint32_t newSize;
+
+        newSize = heapP->size == 0 ? TIMER_HEAP_MIN_SIZE : heapP->size << 1;
+        if (newSize < heapP->size) return false;
+
+        newTimers = (lwm2m_timer_t **)lwm2m_malloc(newSize * sizeof(lwm2m_timer_t *));
+        if (newTimers == NULL) return false;
+        if (heapP->timers != NULL)
+        {
+            memcpy(newTimers, heapP->timers, heapP->count * sizeof(lwm2m_timer_t *));
+            lwm2m_free(heapP->timers);
+        }
+        heapP->timers = newTimers;
+        heapP->size = newSize;
+    }
+
+    heapP->timers[heapP->count] = timerP;
+    heapP->count++;
+    timerP->index = heapP->count;
+    prv_siftUp(heapP, heapP->count - 1);
+
+    return true;
+}
+
+void timer_cancel(lwm2m_timer_heap_t * heapP,
+                  lwm2m_timer_t * timerP)
+{
+    uint32_t i;
+
+    if (timerP->index == 0) return;
+
+    i = timerP->index - 1;
+    heapP->count--;
+    if (i != heapP->count)
+    {
+        prv_swap(heapP, i, heapP->count);
+        prv_siftUp(heapP, i);
+        prv_siftDown(heapP, i);
+    }
+    timerP->index = 0;
+}
+
+lwm2m_timer_t * timer_peek(lwm2m_timer_heap_t * heapP)
+{
+    if (heapP->count == 0) return NULL;
+
+    return heapP->timers[0];
+}
+
+void timer_free(lwm2m_timer_heap_t * heapP)
+{
+    uint32_t i;
+
+    for (i = 0 ; i < heapP->count ; i++)
+    {
+        heapP->timers[i]->index = 0;
+    }
+    if (heapP->timers != NULL) lwm2m_free(heapP->timers);
+    memset(heapP, 0, sizeof(lwm2m_timer_heap_t));
+}
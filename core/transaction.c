@@ -108,11 +108,121 @@ Contains code snippets which are:
 
 
 /*
- * Modulo mask (+1 and +0.5 for rounding) for a random number to get the tick number for the random
- * retransmission time between COAP_RESPONSE_TIMEOUT and COAP_RESPONSE_TIMEOUT*COAP_RESPONSE_RANDOM_FACTOR.
+ * The initial retransmission timeout is a random duration between the RTO and
+ * RTO*COAP_ACK_RANDOM_FACTOR (RFC 7252 section 4.8), in milliseconds.
+ * With LWM2M_RTO_FIXED, the RTO is COAP_RESPONSE_TIMEOUT. With LWM2M_RTO_COCOA, it is
+ * estimated per peer from the ACK timings (draft-ietf-core-cocoa).
  */
-#define COAP_RESPONSE_TIMEOUT_TICKS         (CLOCK_SECOND * COAP_RESPONSE_TIMEOUT)
-#define COAP_RESPONSE_TIMEOUT_BACKOFF_MASK  ((CLOCK_SECOND * COAP_RESPONSE_TIMEOUT * (COAP_RESPONSE_RANDOM_FACTOR - 1)) + 1.5)
+#define COAP_RESPONSE_TIMEOUT_MS    (COAP_RESPONSE_TIMEOUT * 1000)
+
+#define COCOA_RTO_MAX_MS            60000
+#define COCOA_RTO_LOW_MS            1000    // back-off factor of 3 below
+#define COCOA_RTO_HIGH_MS           3000    // back-off factor of 1.5 above
+#define COCOA_AGING_MS              30000
+#define COCOA_WEAK_MAX_TRANSMIT     3       // no measure after more retransmissions
+
+static void prv_ageRto(lwm2m_peer_t * peerP,
+                       int64_t now)
+{
+    // estimations not updated for a while drift back to the default RTO
+    while (peerP->rto > COCOA_RTO_HIGH_MS && now - peerP->rtoTime > COCOA_AGING_MS)
+    {
+        peerP->rto = COCOA_RTO_LOW_MS + peerP->rto / 2;
+        peerP->rtoTime += COCOA_AGING_MS;
+    }
+    while (peerP->rto < COCOA_RTO_LOW_MS && now - peerP->rtoTime > 16 * (int64_t)peerP->rto)
+    {
+        peerP->rtoTime += 16 * (int64_t)peerP->rto;
+        peerP->rto *= 2;
+    }
+}
+
+static uint32_t prv_getInitialTimeout(lwm2m_context_t * contextP,
+                                      lwm2m_peer_t * peerP,
+                                      int64_t now)
+{
+    uint32_t rto = COAP_RESPONSE_TIMEOUT_MS;
+
+    if (contextP->rtoMode == LWM2M_RTO_COCOA)
+    {
+        prv_ageRto(peerP, now);
+        rto = peerP->rto;
+    }
+
+    return rto + (uint32_t)rand() % ((uint32_t)(rto * (COAP_ACK_RANDOM_FACTOR - 1)) + 1);
+}
+
+static uint32_t prv_getNextTimeout(lwm2m_context_t * contextP,
+                                   lwm2m_transaction_t * transacP)
+{
+    uint32_t timeout = transacP->retrans_timeout;
+
+    if (contextP->rtoMode == LWM2M_RTO_COCOA)
+    {
+        // variable back-off factor, from the RTO the exchange started with
+        if (transacP->initial_rto < COCOA_RTO_LOW_MS) return timeout * 3;
+        if (transacP->initial_rto > COCOA_RTO_HIGH_MS) return timeout + timeout / 2;
+    }
+
+    return timeout << 1;
+}
+
+// RFC 6298 section 2 with alpha = 1/8 and beta = 1/4. Returns the RTO of the estimator.
+static uint32_t prv_updateRtt(lwm2m_rtt_t * rttP,
+                              uint32_t measure,
+                              uint32_t k)
+{
+    if (rttP->srtt == 0)
+    {
+        rttP->srtt = measure;
+        rttP->rttvar = measure / 2;
+    }
+    else
+    {
+        uint32_t delta = rttP->srtt > measure ? rttP->srtt - measure : measure - rttP->srtt;
+
+        rttP->rttvar = (3 * rttP->rttvar + delta) / 4;
+        rttP->srtt = (7 * rttP->srtt + measure) / 8;
+    }
+
+    return rttP->srtt + k * rttP->rttvar;
+}
+
+static void prv_measureRtt(lwm2m_context_t * contextP,
+                           lwm2m_transaction_t * transacP)
+{
+    lwm2m_peer_t * peerP = transacP->peerP;
+    int64_t now;
+    uint32_t measure;
+
+    if (contextP->rtoMode != LWM2M_RTO_COCOA || peerP == NULL) return;
+    // retrans_counter is the number of transmissions plus one
+    if (transacP->retrans_counter < 2) return;
+
+    now = utils_gettimeMs();
+    if (now < transacP->send_time) return;
+    if (now - transacP->send_time > COCOA_RTO_MAX_MS) return;
+    measure = (uint32_t)(now - transacP->send_time);
+    if (measure == 0) measure = 1;
+
+    if (transacP->retrans_counter == 2)
+    {
+        peerP->rto = (prv_updateRtt(&peerP->strongRtt, measure, 4) + peerP->rto) / 2;
+    }
+    else if (transacP->retrans_counter <= COCOA_WEAK_MAX_TRANSMIT + 1)
+    {
+        // the measure may include the time before the retransmissions
+        peerP->rto = (prv_updateRtt(&peerP->weakRtt, measure, 1) + 3 * peerP->rto) / 4;
+    }
+    else
+    {
+        return;
+    }
+    if (peerP->rto > COCOA_RTO_MAX_MS) peerP->rto = COCOA_RTO_MAX_MS;
+    peerP->rtoTime = now;
+
+    LOG_ARG("RTT: %u ms, RTO: %u ms", measure, peerP->rto);
+}
 
 static int prv_checkFinished(lwm2m_transaction_t * transacP,
                              coap_packet_t * receivedMessage)
@@ -141,7 +251,8 @@ static int prv_checkFinished(lwm2m_transaction_t * transacP,
     return 0;
 }
 
-lwm2m_transaction_t * transaction_new(void * sessionH,
+lwm2m_transaction_t * transaction_new(lwm2m_context_t * contextP,
+                                      void * sessionH,
                                       coap_method_t method,
                                       char * altPath,
                                       lwm2m_uri_t * uriP,
@@ -149,6 +260,7 @@ lwm2m_transaction_t * transaction_new(void * sessionH,
                                       uint8_t token_len,
                                       uint8_t* token)
 {
+    transaction_item_t * itemP;
     lwm2m_transaction_t * transacP;
     int result;
 
@@ -159,13 +271,12 @@ lwm2m_transaction_t * transaction_new(void * sessionH,
     // no transactions without peer
     if (NULL == sessionH) return NULL;
 
-    transacP = (lwm2m_transaction_t *)lwm2m_malloc(sizeof(lwm2m_transaction_t));
-
-    if (NULL == transacP) return NULL;
+    itemP = (transaction_item_t *)pool_alloc(&contextP->transactionPool);
+    if (NULL == itemP) return NULL;
+    transacP = &itemP->transaction;
     memset(transacP, 0, sizeof(lwm2m_transaction_t));
 
-    transacP->message = lwm2m_malloc(sizeof(coap_packet_t));
-    if (NULL == transacP->message) goto error;
+    transacP->message = &itemP->message;
 
     coap_init_message(transacP->message, COAP_TYPE_CON, method, mID);
 
@@ -220,7 +331,7 @@ lwm2m_transaction_t * transaction_new(void * sessionH,
         else {
             // generate a token
             uint8_t temp_token[COAP_TOKEN_LEN];
-            time_t tv_sec = lwm2m_gettime();
+            time_t tv_sec = utils_gettime();
 
             // initialize first 6 bytes, leave the last 2 random
             temp_token[0] = mID;
@@ -239,29 +350,448 @@ lwm2m_transaction_t * transaction_new(void * sessionH,
 
 error:
     LOG("Exiting on failure");
-    lwm2m_free(transacP);
+    transaction_free(contextP, transacP);
     return NULL;
 }
 
-void transaction_free(lwm2m_transaction_t * transacP)
+void transaction_free(lwm2m_context_t * contextP,
+                      lwm2m_transaction_t * transacP)
 {
     LOG_ARG("Entering. transaction=%p", transacP);
-    if (transacP->message)
+    coap_free_header(transacP->message);
+
+    if (transacP->buffer != NULL && transacP->buffer != transacP->inlineBuffer) lwm2m_free(transacP->buffer);
+    // the transaction is the first member of its pool item
+    pool_release(&contextP->transactionPool, transacP);
+}
+
+static lwm2m_peer_t * prv_findPeer(lwm2m_context_t * contextP,
+                                   void * sessionH,
+                                   uint32_t hash)
+{
+    lwm2m_hash_link_t * linkP;
+
+    for (linkP = hash_find(&contextP->peerSessionTable, hash) ;
+         linkP != NULL ;
+         linkP = hash_findNext(linkP))
+    {
+        lwm2m_peer_t * peerP = (lwm2m_peer_t *)linkP->itemP;
+
+        if (lwm2m_session_is_equal(peerP->sessionH, sessionH, contextP->userData) == true)
+        {
+            return peerP;
+        }
+    }
+
+    return NULL;
+}
+
+static lwm2m_peer_t * prv_newPeer(lwm2m_context_t * contextP,
+                                  void * sessionH,
+                                  uint32_t hash)
+{
+    lwm2m_peer_t * peerP;
+
+    peerP = (lwm2m_peer_t *)lwm2m_malloc(sizeof(lwm2m_peer_t));
+    if (peerP == NULL) return NULL;
+    memset(peerP, 0, sizeof(lwm2m_peer_t));
+    peerP->sessionH = sessionH;
+    peerP->rto = COAP_RESPONSE_TIMEOUT_MS;
+
+    peerP->next = contextP->peerList;
+    if (contextP->peerList != NULL) contextP->peerList->prev = peerP;
+    contextP->peerList = peerP;
+    hash_add(&contextP->peerSessionTable, &peerP->sessionLink, hash, peerP);
+
+    return peerP;
+}
+
+static lwm2m_peer_t * prv_getPeer(lwm2m_context_t * contextP,
+                                  void * sessionH)
+{
+    lwm2m_peer_t * peerP;
+    uint32_t hash;
+
+    hash = utils_sessionHash(contextP, sessionH);
+    peerP = prv_findPeer(contextP, sessionH, hash);
+    if (peerP != NULL)
     {
-       coap_free_header(transacP->message);
-       lwm2m_free(transacP->message);
+        timer_cancel(&contextP->peerTimers, &peerP->idleTimer);
+        return peerP;
     }
 
-    if (transacP->buffer) lwm2m_free(transacP->buffer);
-    lwm2m_free(transacP);
+    return prv_newPeer(contextP, sessionH, hash);
+}
+
+void transaction_freePeer(lwm2m_peer_t * peerP)
+{
+    if (peerP->responseCache != NULL)
+    {
+        uint16_t i;
+
+        for (i = 0 ; i < LWM2M_RESPONSE_CACHE_SIZE ; i++)
+        {
+            if (peerP->responseCache[i].buffer != NULL) lwm2m_free(peerP->responseCache[i].buffer);
+        }
+        lwm2m_free(peerP->responseCache);
+    }
+    lwm2m_free(peerP);
+}
+
+static void prv_freePeer(lwm2m_context_t * contextP,
+                         lwm2m_peer_t * peerP)
+{
+    timer_cancel(&contextP->peerTimers, &peerP->idleTimer);
+    hash_remove(&contextP->peerSessionTable, &peerP->sessionLink);
+    if (peerP->prev != NULL)
+    {
+        peerP->prev->next = peerP->next;
+    }
+    else
+    {
+        contextP->peerList = peerP->next;
+    }
+    if (peerP->next != NULL) peerP->next->prev = peerP->prev;
+
+    transaction_freePeer(peerP);
+}
+
+// Returns the time the last cached response of the peer expires, or 0.
+static int64_t prv_getCacheExpiry(lwm2m_peer_t * peerP)
+{
+    int64_t expiry = 0;
+    uint16_t i;
+
+    if (peerP->responseCache == NULL) return 0;
+
+    for (i = 0 ; i < LWM2M_RESPONSE_CACHE_SIZE ; i++)
+    {
+        if (peerP->responseCache[i].expiry > expiry) expiry = peerP->responseCache[i].expiry;
+    }
+
+    return expiry;
+}
+
+// Frees a peer without transactions or keeps it while it has cached responses
+// and, with LWM2M_RTO_COCOA, its estimations for a while.
+static void prv_releasePeer(lwm2m_context_t * contextP,
+                            lwm2m_peer_t * peerP)
+{
+    int64_t now = utils_gettimeMs();
+    int64_t expiry;
+
+    if (0 <= now)
+    {
+        expiry = prv_getCacheExpiry(peerP);
+        if (contextP->rtoMode == LWM2M_RTO_COCOA
+         && expiry < now + LWM2M_PEER_IDLE_TIMEOUT_MS)
+        {
+            expiry = now + LWM2M_PEER_IDLE_TIMEOUT_MS;
+        }
+
+        if (expiry > now
+         && timer_schedule(&contextP->peerTimers, &peerP->idleTimer, expiry, peerP))
+        {
+            return;
+        }
+    }
+
+    prv_freePeer(contextP, peerP);
+}
+
+bool transaction_findResponse(lwm2m_context_t * contextP,
+                              void * sessionH,
+                              uint16_t mID,
+                              uint8_t ** bufferP,
+                              size_t * lengthP)
+{
+    lwm2m_peer_t * peerP;
+    int64_t now;
+    uint16_t i;
+
+    peerP = prv_findPeer(contextP, sessionH, utils_sessionHash(contextP, sessionH));
+    if (peerP == NULL || peerP->responseCache == NULL) return false;
+
+    now = utils_gettimeMs();
+    for (i = 0 ; i < LWM2M_RESPONSE_CACHE_SIZE ; i++)
+    {
+        lwm2m_cached_response_t * entryP = peerP->responseCache + i;
+
+        if (entryP->expiry > now && entryP->mid == mID)
+        {
+            *bufferP = entryP->buffer;
+            *lengthP = entryP->length;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void transaction_cacheResponse(lwm2m_context_t * contextP,
+                               void * sessionH,
+                               uint16_t mID,
+                               uint8_t * buffer,
+                               size_t length)
+{
+    lwm2m_peer_t * peerP;
+    lwm2m_cached_response_t * entryP;
+    int64_t now;
+    uint32_t hash;
+
+    now = utils_gettimeMs();
+    if (now < 0) return;
+
+    hash = utils_sessionHash(contextP, sessionH);
+    peerP = prv_findPeer(contextP, sessionH, hash);
+    if (peerP == NULL)
+    {
+        peerP = prv_newPeer(contextP, sessionH, hash);
+        if (peerP == NULL) return;
+    }
+    if (peerP->responseCache == NULL)
+    {
+        peerP->responseCache = (lwm2m_cached_response_t *)lwm2m_malloc(LWM2M_RESPONSE_CACHE_SIZE * sizeof(lwm2m_cached_response_t));
+        if (peerP->responseCache == NULL) goto exit;
+        memset(peerP->responseCache, 0, LWM2M_RESPONSE_CACHE_SIZE * sizeof(lwm2m_cached_response_t));
+    }
+
+    // the entries have the same lifetime, the next one is the oldest
+    entryP = peerP->responseCache + peerP->responseNext;
+    if (entryP->size < length)
+    {
+        if (entryP->buffer != NULL) lwm2m_free(entryP->buffer);
+        entryP->size = 0;
+        entryP->expiry = 0;
+        entryP->buffer = (uint8_t *)lwm2m_malloc(length);
+        if (entryP->buffer == NULL) goto exit;
+        entryP->size = length;
+    }
+    memcpy(entryP->buffer, buffer, length);
+    entryP->length = length;
+    entryP->mid = mID;
+    entryP->expiry = now + (int64_t)(COAP_EXCHANGE_LIFETIME * 1000);
+    peerP->responseNext = (uint16_t)((peerP->responseNext + 1) % LWM2M_RESPONSE_CACHE_SIZE);
+
+exit:
+    // an idle peer is kept until its responses expire
+    if (peerP->transactionList == NULL && peerP->waitingList == NULL)
+    {
+        prv_releasePeer(contextP, peerP);
+    }
+}
+
+static void prv_link(lwm2m_transaction_t ** listP,
+                     lwm2m_transaction_t * transacP)
+{
+    transacP->prev = NULL;
+    transacP->next = *listP;
+    if (*listP != NULL) (*listP)->prev = transacP;
+    *listP = transacP;
+}
+
+static void prv_unlink(lwm2m_transaction_t ** listP,
+                       lwm2m_transaction_t * transacP)
+{
+    if (transacP->prev != NULL)
+    {
+        transacP->prev->next = transacP->next;
+    }
+    else
+    {
+        *listP = transacP->next;
+    }
+    if (transacP->next != NULL) transacP->next->prev = transacP->prev;
+    transacP->next = NULL;
+    transacP->prev = NULL;
+}
+
+static void prv_enqueue(lwm2m_peer_t * peerP,
+                        lwm2m_transaction_t * transacP)
+{
+    prv_unlink(&peerP->transactionList, transacP);
+
+    transacP->waiting = true;
+    transacP->prev = peerP->waitingTail;
+    if (peerP->waitingTail != NULL)
+    {
+        peerP->waitingTail->next = transacP;
+    }
+    else
+    {
+        peerP->waitingList = transacP;
+    }
+    peerP->waitingTail = transacP;
+}
+
+// Starts the waiting transactions while the peer has free slots.
+// The transactions failing to be sent are removed. Their slots are reused by this loop
+// rather than by nested calls, and the peer is released at the end if it became unused.
+static void prv_sendWaiting(lwm2m_context_t * contextP,
+                            lwm2m_peer_t * peerP)
+{
+    if (peerP->sending) return;
+
+    peerP->sending = true;
+    while (peerP->outstanding < COAP_NSTART && peerP->waitingList != NULL)
+    {
+        lwm2m_transaction_t * transacP = peerP->waitingList;
+
+        if (transacP == peerP->waitingTail) peerP->waitingTail = NULL;
+        prv_unlink(&peerP->waitingList, transacP);
+        transacP->waiting = false;
+        prv_link(&peerP->transactionList, transacP);
+
+        transacP->inFlight = true;
+        peerP->outstanding++;
+        (void)transaction_send(contextP, transacP);
+    }
+    peerP->sending = false;
+
+    if (peerP->transactionList == NULL && peerP->waitingList == NULL)
+    {
+        prv_releasePeer(contextP, peerP);
+    }
+}
+
+// Gives back the slot of a transaction which does not expect an ACK anymore.
+static void prv_releaseSlot(lwm2m_context_t * contextP,
+                            lwm2m_transaction_t * transacP)
+{
+    if (!transacP->inFlight) return;
+
+    transacP->inFlight = false;
+    transacP->peerP->outstanding--;
+    prv_sendWaiting(contextP, transacP->peerP);
+}
+
+void transaction_add(lwm2m_context_t * contextP,
+                     lwm2m_transaction_t * transacP)
+{
+    coap_packet_t * message = (coap_packet_t *)transacP->message;
+
+    LOG_ARG("Entering. transaction=%p", transacP);
+
+    // on failure, transaction_send() will report the error
+    transacP->peerP = prv_getPeer(contextP, transacP->peerH);
+    if (transacP->peerP != NULL)
+    {
+        prv_link(&transacP->peerP->transactionList, transacP);
+    }
+
+    hash_add(&contextP->transactionMidTable, &transacP->midLink, hash_integer(transacP->mID), transacP);
+    if (IS_OPTION(message, COAP_OPTION_TOKEN))
+    {
+        hash_add(&contextP->transactionTokenTable,
+                 &transacP->tokenLink,
+                 hash_bytes(message->token, message->token_len),
+                 transacP);
+    }
 }
 
 void transaction_remove(lwm2m_context_t * contextP,
                         lwm2m_transaction_t * transacP)
 {
+    lwm2m_peer_t * peerP = transacP->peerP;
+    bool inFlight = transacP->inFlight;
+
     LOG_ARG("Entering. transaction=%p", transacP);
-    contextP->transactionList = (lwm2m_transaction_t *) LWM2M_LIST_RM(contextP->transactionList, transacP->mID, NULL);
-    transaction_free(transacP);
+
+    if (peerP != NULL)
+    {
+        if (transacP->waiting)
+        {
+            if (transacP == peerP->waitingTail) peerP->waitingTail = transacP->prev;
+            prv_unlink(&peerP->waitingList, transacP);
+        }
+        else
+        {
+            prv_unlink(&peerP->transactionList, transacP);
+        }
+        if (inFlight) peerP->outstanding--;
+    }
+
+    hash_remove(&contextP->transactionMidTable, &transacP->midLink);
+    timer_cancel(&contextP->transactionTimers, &transacP->retransTimer);
+    if (IS_OPTION((coap_packet_t *)transacP->message, COAP_OPTION_TOKEN))
+    {
+        hash_remove(&contextP->transactionTokenTable, &transacP->tokenLink);
+    }
+
+    transaction_free(contextP, transacP);
+
+    // while prv_sendWaiting() runs, it starts the next transactions and releases the peer
+    if (peerP != NULL && !peerP->sending)
+    {
+        if (peerP->transactionList == NULL && peerP->waitingList == NULL)
+        {
+            prv_releasePeer(contextP, peerP);
+        }
+        else if (inFlight)
+        {
+            prv_sendWaiting(contextP, peerP);
+        }
+    }
+}
+
+static bool prv_schedule(lwm2m_context_t * contextP,
+                         lwm2m_transaction_t * transacP)
+{
+    return timer_schedule(&contextP->transactionTimers,
+                          &transacP->retransTimer,
+                          transacP->retrans_time,
+                          transacP);
+}
+
+static lwm2m_transaction_t * prv_findByMid(lwm2m_context_t * contextP,
+                                           void * fromSessionH,
+                                           uint16_t mID)
+{
+    lwm2m_hash_link_t * linkP;
+
+    for (linkP = hash_find(&contextP->transactionMidTable, hash_integer(mID)) ;
+         linkP != NULL ;
+         linkP = hash_findNext(linkP))
+    {
+        lwm2m_transaction_t * transacP = (lwm2m_transaction_t *)linkP->itemP;
+
+        if (transacP->mID == mID
+         && !transacP->ack_received
+         && !transacP->waiting
+         && lwm2m_session_is_equal(fromSessionH, transacP->peerH, contextP->userData) == true)
+        {
+            return transacP;
+        }
+    }
+
+    return NULL;
+}
+
+static lwm2m_transaction_t * prv_findByToken(lwm2m_context_t * contextP,
+                                             void * fromSessionH,
+                                             coap_packet_t * message)
+{
+    lwm2m_hash_link_t * linkP;
+
+    if (!IS_OPTION(message, COAP_OPTION_TOKEN)) return NULL;
+
+    for (linkP = hash_find(&contextP->transactionTokenTable, hash_bytes(message->token, message->token_len)) ;
+         linkP != NULL ;
+         linkP = hash_findNext(linkP))
+    {
+        lwm2m_transaction_t * transacP = (lwm2m_transaction_t *)linkP->itemP;
+
+        // only requests are finished by a response carrying their token
+        if (COAP_DELETE >= ((coap_packet_t *)transacP->message)->code
+         && !transacP->waiting
+         && prv_checkFinished(transacP, message)
+         && lwm2m_session_is_equal(fromSessionH, transacP->peerH, contextP->userData) == true)
+        {
+            return transacP;
+        }
+    }
+
+    return NULL;
 }
 
 bool transaction_handleResponse(lwm2m_context_t * contextP,
@@ -269,80 +799,75 @@ bool transaction_handleResponse(lwm2m_context_t * contextP,
                                  coap_packet_t * message,
                                  coap_packet_t * response)
 {
-    bool found = false;
     bool reset = false;
-    lwm2m_transaction_t * transacP;
+    lwm2m_transaction_t * transacP = NULL;
 
     LOG("Entering");
-    transacP = contextP->transactionList;
 
-    while (NULL != transacP)
+    if ((COAP_TYPE_ACK == message->type) || (COAP_TYPE_RST == message->type))
     {
-        if (lwm2m_session_is_equal(fromSessionH, transacP->peerH, contextP->userData) == true)
+        transacP = prv_findByMid(contextP, fromSessionH, message->mid);
+        if (transacP != NULL)
         {
-            if (!transacP->ack_received)
-            {
-                if ((COAP_TYPE_ACK == message->type) || (COAP_TYPE_RST == message->type))
-                {
-                    if (transacP->mID == message->mid)
-	                {
-    	                found = true;
-        	            transacP->ack_received = true;
-            	        reset = COAP_TYPE_RST == message->type;
-            	    }
-                }
-            }
+            if (COAP_TYPE_ACK == message->type) prv_measureRtt(contextP, transacP);
+            transacP->ack_received = true;
+            reset = COAP_TYPE_RST == message->type;
 
-            if (reset || prv_checkFinished(transacP, message))
-            {
-                // HACK: If a message is sent from the monitor callback,
-                // it will arrive before the registration ACK.
-                // So we resend transaction that were denied for authentication reason.
-                if (!reset)
-                {
-                    if (COAP_TYPE_CON == message->type && NULL != response)
-                    {
-                        coap_init_message(response, COAP_TYPE_ACK, 0, message->mid);
-                        message_send(contextP, response, fromSessionH);
-                    }
-                
-	                if ((COAP_401_UNAUTHORIZED == message->code) && (COAP_MAX_RETRANSMIT > transacP->retrans_counter))
-    	            {
-        	            transacP->ack_received = false;
-            	        transacP->retrans_time += COAP_RESPONSE_TIMEOUT;
-                	    return true;
-                	}
-				}       
-                if (transacP->callback != NULL)
-                {
-                    transacP->callback(contextP, transacP, message);
-                }
-                transaction_remove(contextP, transacP);
-                return true;
-            }
-            // if we found our guy, exit
-            if (found)
+            if (!reset && !prv_checkFinished(transacP, message))
             {
-                time_t tv_sec = lwm2m_gettime();
-                if (0 <= tv_sec)
+                // empty ACK, wait for the separate response
+                int64_t now = utils_gettimeMs();
+
+                prv_releaseSlot(contextP, transacP);
+                if (0 <= now)
                 {
-                    transacP->retrans_time = tv_sec;
+                    transacP->retrans_time = now;
                 }
                 if (transacP->response_timeout)
                 {
-                    transacP->retrans_time += transacP->response_timeout;
+                    transacP->retrans_time += (int64_t)transacP->response_timeout * 1000;
                 }
                 else
                 {
-                    transacP->retrans_time += COAP_RESPONSE_TIMEOUT * transacP->retrans_counter;
+                    transacP->retrans_time += COAP_RESPONSE_TIMEOUT_MS * transacP->retrans_counter;
                 }
+                (void)prv_schedule(contextP, transacP);
                 return true;
             }
         }
+    }
 
-        transacP = transacP->next;
+    if (transacP == NULL)
+    {
+        transacP = prv_findByToken(contextP, fromSessionH, message);
+        if (transacP == NULL) return false;
     }
-    return false;
+
+    // HACK: If a message is sent from the monitor callback,
+    // it will arrive before the registration ACK.
+    // So we resend transaction that were denied for authentication reason.
+    if (!reset)
+    {
+        if (COAP_TYPE_CON == message->type && NULL != response)
+        {
+            coap_init_message(response, COAP_TYPE_ACK, 0, message->mid);
+            message_send(contextP, response, fromSessionH);
+        }
+
+        if ((COAP_401_UNAUTHORIZED == message->code) && (COAP_MAX_RETRANSMIT > transacP->retrans_counter))
+        {
+            transacP->ack_received = false;
+            transacP->retrans_time += COAP_RESPONSE_TIMEOUT_MS;
+            (void)prv_schedule(contextP, transacP);
+            return true;
+        }
+    }
+    if (transacP->callback != NULL)
+    {
+        transacP->callback(contextP, transacP, message);
+    }
+    transaction_remove(contextP, transacP);
+    return true;
 }
 
 int transaction_send(lwm2m_context_t * contextP,
@@ -351,42 +876,77 @@ int transaction_send(lwm2m_context_t * contextP,
     bool maxRetriesReached = false;
 
     LOG_ARG("Entering: transaction=%p", transacP);
+    if (transacP->peerP == NULL)
+    {
+        // transaction_add() failed
+        transaction_remove(contextP, transacP);
+        return COAP_500_INTERNAL_SERVER_ERROR;
+    }
     if (transacP->buffer == NULL)
     {
-        transacP->buffer_len = coap_serialize_get_size(transacP->message);
-        if (transacP->buffer_len == 0)
-        {
-           transaction_remove(contextP, transacP);
-           return COAP_500_INTERNAL_SERVER_ERROR;
-        }
+        size_t length;
 
-        transacP->buffer = (uint8_t*)lwm2m_malloc(transacP->buffer_len);
-        if (transacP->buffer == NULL)
+        length = coap_serialize_message(transacP->message, transacP->inlineBuffer, LWM2M_TRANSACTION_BUFFER_SIZE);
+        if (length != 0)
         {
-           transaction_remove(contextP, transacP);
-           return COAP_500_INTERNAL_SERVER_ERROR;
+            transacP->buffer = transacP->inlineBuffer;
         }
-
-        transacP->buffer_len = coap_serialize_message(transacP->message, transacP->buffer);
-        if (transacP->buffer_len == 0)
+        else
         {
-            lwm2m_free(transacP->buffer);
-            transacP->buffer = NULL;
-            transaction_remove(contextP, transacP);
-            return COAP_500_INTERNAL_SERVER_ERROR;
+            // too large for the inline buffer
+            length = coap_serialize_get_size(transacP->message);
+            if (length == 0)
+            {
+               transaction_remove(contextP, transacP);
+               return COAP_500_INTERNAL_SERVER_ERROR;
+            }
+
+            transacP->buffer = (uint8_t*)lwm2m_malloc(length);
+            if (transacP->buffer == NULL)
+            {
+               transaction_remove(contextP, transacP);
+               return COAP_500_INTERNAL_SERVER_ERROR;
+            }
+
+            length = coap_serialize_message(transacP->message, transacP->buffer, length);
+            if (length == 0)
+            {
+                lwm2m_free(transacP->buffer);
+                transacP->buffer = NULL;
+                transaction_remove(contextP, transacP);
+                return COAP_500_INTERNAL_SERVER_ERROR;
+            }
         }
+        transacP->buffer_len = (uint16_t)length;
     }
 
     if (!transacP->ack_received)
     {
-        long unsigned timeout = 0;
+        uint32_t timeout = 0;
+
+        if (!transacP->inFlight)
+        {
+            if (transacP->peerP->outstanding >= COAP_NSTART
+             || transacP->peerP->waitingList != NULL)
+            {
+                // sent by prv_sendWaiting() when a slot is released
+                if (!transacP->waiting) prv_enqueue(transacP->peerP, transacP);
+                timer_cancel(&contextP->transactionTimers, &transacP->retransTimer);
+                return 0;
+            }
+            transacP->inFlight = true;
+            transacP->peerP->outstanding++;
+        }
 
         if (0 == transacP->retrans_counter)
         {
-            time_t tv_sec = lwm2m_gettime();
-            if (0 <= tv_sec)
+            int64_t now = utils_gettimeMs();
+            if (0 <= now)
             {
-                transacP->retrans_time = tv_sec + COAP_RESPONSE_TIMEOUT;
+                transacP->retrans_timeout = prv_getInitialTimeout(contextP, transacP->peerP, now);
+                transacP->initial_rto = transacP->peerP->rto;
+                transacP->send_time = now;
+                transacP->retrans_time = now + transacP->retrans_timeout;
                 transacP->retrans_counter = 1;
             }
             else
@@ -396,15 +956,27 @@ int transaction_send(lwm2m_context_t * contextP,
         }
         else
         {
-            timeout = COAP_RESPONSE_TIMEOUT << (transacP->retrans_counter - 1);
+            // exponential back-off
+            transacP->retrans_timeout = prv_getNextTimeout(contextP, transacP);
+            timeout = transacP->retrans_timeout;
         }
 
         if (COAP_MAX_RETRANSMIT + 1 >= transacP->retrans_counter)
         {
-            (void)lwm2m_buffer_send(transacP->peerH, transacP->buffer, transacP->buffer_len, contextP->userData);
-
             transacP->retrans_time += timeout;
             transacP->retrans_counter += 1;
+
+            // only the first scheduling can fail as it may grow the heap
+            if (!prv_schedule(contextP, transacP))
+            {
+                transaction_remove(contextP, transacP);
+                return COAP_500_INTERNAL_SERVER_ERROR;
+            }
+
+#ifdef LWM2M_WITH_BATCH_SEND
+            message_flush(contextP, transacP->peerH);
+#endif
+            (void)lwm2m_buffer_send(transacP->peerH, transacP->buffer, transacP->buffer_len, contextP->userData);
         }
         else
         {
@@ -427,47 +999,48 @@ int transaction_send(lwm2m_context_t * contextP,
 }
 
 void transaction_step(lwm2m_context_t * contextP,
-                      time_t currentTime,
-                      time_t * timeoutP)
+                      int64_t currentTime,
+                      int64_t * timeoutP)
 {
-    lwm2m_transaction_t * transacP;
+    lwm2m_timer_t * timerP;
 
     LOG("Entering");
-    transacP = contextP->transactionList;
-    while (transacP != NULL)
+    // forget the peers idle for too long
+    while (NULL != (timerP = timer_peek(&contextP->peerTimers))
+        && timerP->time <= currentTime)
     {
-        // transaction_send() may remove transaction from the linked list
-        lwm2m_transaction_t * nextP = transacP->next;
-        int removed = 0;
+        prv_freePeer(contextP, (lwm2m_peer_t *)timerP->itemP);
+    }
 
-        if (transacP->retrans_time <= currentTime)
-        {
-            removed = transaction_send(contextP, transacP);
-        }
+    // only the transactions due for retransmission or expiration are visited
+    while (NULL != (timerP = timer_peek(&contextP->transactionTimers))
+        && timerP->time <= currentTime)
+    {
+        lwm2m_transaction_t * transacP = (lwm2m_transaction_t *)timerP->itemP;
 
-        if (0 == removed)
+        if (0 != transaction_send(contextP, transacP))
         {
-            time_t interval;
-
-            if (transacP->retrans_time > currentTime)
-            {
-                interval = transacP->retrans_time - currentTime;
-            }
-            else
-            {
-                interval = 1;
-            }
-
-            if (*timeoutP > interval)
-            {
-                *timeoutP = interval;
-            }
+            // the callback of the removed transaction may have queued new messages
+            *timeoutP = 1;
         }
-        else
+        else if (!transacP->waiting && transacP->retrans_time <= currentTime)
         {
-            *timeoutP = 1;
+            // late step: count the timeout from the actual transmission
+            transacP->retrans_time = currentTime + transacP->retrans_timeout;
+            (void)prv_schedule(contextP, transacP);
         }
+    }
 
-        transacP = nextP;
+    timerP = timer_peek(&contextP->transactionTimers);
+    if (timerP != NULL && *timeoutP > timerP->time - currentTime)
+    {
+        *timeoutP = timerP->time - currentTime;
     }
 }
+
+void lwm2m_set_rto_mode(lwm2m_context_t * contextP,
+                        lwm2m_rto_mode_t mode)
+{
+    LOG_ARG("mode: %d", mode);
+    contextP->rtoMode = mode;
+}
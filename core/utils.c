@@ -619,7 +619,7 @@ void utils_copyValue(void * dst,
 
 #define PRV_B64_PADDING '='
 
-static char b64Alphabet[64] =
+static const char b64Alphabet[64] =
 {
     'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J', 'K', 'L', 'M', 'N', 'O', 'P',
     'Q', 'R', 'S', 'T', 'U', 'V', 'W', 'X', 'Y', 'Z', 'a', 'b', 'c', 'd', 'e', 'f',
@@ -799,3 +799,45 @@ lwm2m_data_type_t utils_depthToDatatype(uri_depth_t depth)
 
     return LWM2M_TYPE_UNDEFINED;
 }
+
+int64_t utils_gettimeMs(void)
+{
+#ifdef LWM2M_WITH_TIME_MS
+    return lwm2m_gettime_ms();
+#else
+    time_t tv_sec;
+
+    tv_sec = lwm2m_gettime();
+    if (tv_sec < 0) return -1;
+
+    return (int64_t)tv_sec * 1000;
+#endif
+}
+
+uint32_t utils_sessionHash(lwm2m_context_t * contextP,
+                           void * sessionH)
+{
+#ifdef LWM2M_SESSION_HASH
+    return hash_integer(lwm2m_session_hash(sessionH, contextP->userData));
+#else
+    (void)contextP;
+    (void)sessionH;
+
+    // all the sessions share the same bucket and are told apart by lwm2m_session_is_equal()
+    return 0;
+#endif
+}
+
+time_t utils_gettime(void)
+{
+#ifdef LWM2M_WITH_TIME_MS
+    int64_t now;
+
+    now = lwm2m_gettime_ms();
+    if (now < 0) return -1;
+
+    return (time_t)(now / 1000);
+#else
+    return lwm2m_gettime();
+#endif
+}
@@ -1,5 +1,6 @@
 # Provides WAKAAMA_SOURCES_DIR and WAKAAMA_SOURCES and WAKAAMA_DEFINITIONS variables.
 # Add LWM2M_WITH_LOGS to compile definitions to enable logging.
+# Add LWM2M_WITH_TIME_MS to compile definitions to use lwm2m_gettime_ms() for the core timers.
 # Set LWM2M_LITTLE_ENDIAN to FALSE or TRUE according to your destination platform or leave
 # it unset to determine endianess automatically.
 # Set LWM2M_VERSION to use a particular LWM2M version or leave it unset to use the latest.
@@ -21,6 +22,11 @@ set(WAKAAMA_SOURCES
     ${WAKAAMA_SOURCES_DIR}/tlv.c
     ${WAKAAMA_SOURCES_DIR}/data.c
     ${WAKAAMA_SOURCES_DIR}/list.c
+    ${WAKAAMA_SOURCES_DIR}/hash.c
+    ${WAKAAMA_SOURCES_DIR}/timer.c
+    ${WAKAAMA_SOURCES_DIR}/pool.c
+    ${WAKAAMA_SOURCES_DIR}/slot.c
+    ${WAKAAMA_SOURCES_DIR}/linkformat.c
     ${WAKAAMA_SOURCES_DIR}/packet.c
     ${WAKAAMA_SOURCES_DIR}/transaction.c
     ${WAKAAMA_SOURCES_DIR}/registration.c
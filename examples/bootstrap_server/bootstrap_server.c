@@ -482,6 +482,7 @@ int main(int argc, char *argv[])
 {
     fd_set readfds;
     struct timeval tv;
+    int64_t timeout;
     int result;
     char * port = "5685";
     internal_data_t data;
@@ -590,10 +591,13 @@ int main(int argc, char *argv[])
         tv.tv_sec = 60;
         tv.tv_usec = 0;
 
-        result = lwm2m_step(data.lwm2mH, &(tv.tv_sec));
+        timeout = (int64_t)tv.tv_sec * 1000;
+        result = lwm2m_step_ms(data.lwm2mH, &timeout);
+        tv.tv_sec = (time_t)(timeout / 1000);
+        tv.tv_usec = (suseconds_t)((timeout % 1000) * 1000);
         if (result != 0)
         {
-            fprintf(stderr, "lwm2m_step() failed: 0x%X\r\n", result);
+            fprintf(stderr, "lwm2m_step_ms() failed: 0x%X\r\n", result);
             return -1;
         }
 
@@ -614,6 +618,21 @@ int main(int argc, char *argv[])
             // Packet received
             if (FD_ISSET(data.sock, &readfds))
             {
+#ifdef LWM2M_WITH_BATCH_SEND
+                uint8_t batchBuffers[CONNECTION_BATCH_SIZE * MAX_PACKET_SIZE];
+                lwm2m_packet_t packets[CONNECTION_BATCH_SIZE];
+                int count;
+
+                count = connection_receive_batch(data.sock, &data.connList, batchBuffers, MAX_PACKET_SIZE, packets, CONNECTION_BATCH_SIZE);
+                if (count == -1)
+                {
+                    fprintf(stderr, "Error in recvmmsg(): %d\r\n", errno);
+                }
+                else
+                {
+                    lwm2m_handle_packets(data.lwm2mH, packets, count);
+                }
+#else
                 struct sockaddr_storage addr;
                 socklen_t addrLen;
 
@@ -662,6 +681,7 @@ int main(int argc, char *argv[])
                         lwm2m_handle_packet(data.lwm2mH, buffer, numBytes, connP);
                     }
                 }
+#endif
             }
             // command line input
             else if (FD_ISSET(STDIN_FILENO, &readfds))
@@ -793,6 +793,9 @@ void print_usage(void)
     fprintf(stdout, "  -t TIME\tSet the lifetime of the Client. Default: 300\r\n");
     fprintf(stdout, "  -b\t\tBootstrap requested.\r\n");
     fprintf(stdout, "  -c\t\tChange battery level over time.\r\n");
+#ifdef LWM2M_SUPPORT_SENML_JSON
+    fprintf(stdout, "  -C\t\tPack the SenML-JSON notifications due at the same time (server option -C).\r\n");
+#endif
 #ifdef WITH_TINYDTLS
     fprintf(stdout, "  -i STRING\tSet the device management or bootstrap server PSK identity. If not set use none secure mode\r\n");
     fprintf(stdout, "  -s HEXSTRING\tSet the device management or bootstrap server Pre-Shared-Key. If not set use none secure mode\r\n");
@@ -815,6 +818,7 @@ int main(int argc, char *argv[])
     time_t reboot_time = 0;
     int opt;
     bool bootstrapRequested = false;
+    bool compositeNotifications = false;
     bool serverPortChanged = false;
 
 #ifdef LWM2M_BOOTSTRAP
@@ -882,6 +886,11 @@ int main(int argc, char *argv[])
         case 'c':
             batterylevelchanging = 1;
             break;
+#ifdef LWM2M_SUPPORT_SENML_JSON
+        case 'C':
+            compositeNotifications = true;
+            break;
+#endif
         case 't':
             opt++;
             if (opt >= argc)
@@ -1129,6 +1138,9 @@ int main(int argc, char *argv[])
         fprintf(stderr, "lwm2m_configure() failed: 0x%X\r\n", result);
         return -1;
     }
+#ifdef LWM2M_SUPPORT_SENML_JSON
+    lwm2m_set_composite_notifications(lwm2mH, compositeNotifications);
+#endif
 
     signal(SIGINT, handle_sigint);
 
@@ -1153,6 +1165,7 @@ int main(int argc, char *argv[])
     while (0 == g_quit)
     {
         struct timeval tv;
+        int64_t timeout;
         fd_set readfds;
 
         if (g_reboot)
@@ -1199,7 +1212,10 @@ int main(int argc, char *argv[])
          *  - Secondly it adjusts the timeout value (default 60s) depending on the state of the transaction
          *    (eg. retransmission) and the time between the next operation
          */
-        result = lwm2m_step(lwm2mH, &(tv.tv_sec));
+        timeout = (int64_t)tv.tv_sec * 1000;
+        result = lwm2m_step_ms(lwm2mH, &timeout);
+        tv.tv_sec = (time_t)(timeout / 1000);
+        tv.tv_usec = (suseconds_t)((timeout % 1000) * 1000);
         fprintf(stdout, " -> State: ");
         switch (lwm2mH->state)
         {
@@ -1227,7 +1243,7 @@ int main(int argc, char *argv[])
         }
         if (result != 0)
         {
-            fprintf(stderr, "lwm2m_step() failed: 0x%X\r\n", result);
+            fprintf(stderr, "lwm2m_step_ms() failed: 0x%X\r\n", result);
             if(previousState == STATE_BOOTSTRAPPING)
             {
 #ifdef WITH_LOGS
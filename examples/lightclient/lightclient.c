@@ -454,6 +454,7 @@ int main(int argc, char *argv[])
     while (0 == g_quit)
     {
         struct timeval tv;
+        int64_t timeout;
         fd_set readfds;
 
         tv.tv_sec = 60;
@@ -470,10 +471,13 @@ int main(int argc, char *argv[])
          *  - Secondly it adjusts the timeout value (default 60s) depending on the state of the transaction
          *    (eg. retransmission) and the time before the next operation
          */
-        result = lwm2m_step(lwm2mH, &(tv.tv_sec));
+        timeout = (int64_t)tv.tv_sec * 1000;
+        result = lwm2m_step_ms(lwm2mH, &timeout);
+        tv.tv_sec = (time_t)(timeout / 1000);
+        tv.tv_usec = (suseconds_t)((timeout % 1000) * 1000);
         if (result != 0)
         {
-            fprintf(stderr, "lwm2m_step() failed: 0x%X\r\n", result);
+            fprintf(stderr, "lwm2m_step_ms() failed: 0x%X\r\n", result);
             return -1;
         }
 
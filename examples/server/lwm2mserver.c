@@ -75,8 +75,13 @@
 #include "connection.h"
 
 #define MAX_PACKET_SIZE 1024
+// Max-Age in seconds of the rejected registrations
+#define REGISTRATION_BACKOFF 10
 
 static int g_quit = 0;
+#ifdef LWM2M_SUPPORT_SENML_JSON
+static bool g_composite = false;
+#endif
 
 static void prv_print_error(uint8_t status)
 {
@@ -144,6 +149,29 @@ static void prv_dump_binding(lwm2m_binding_t binding)
     }
 }
 
+static void prv_dump_diff(const char * label,
+                          lwm2m_uri_t * uriList,
+                          size_t count)
+{
+    size_t i;
+
+    if (count == 0) return;
+
+    fprintf(stdout, "\t%s: ", label);
+    for (i = 0 ; i < count ; i++)
+    {
+        if (LWM2M_URI_IS_SET_INSTANCE(uriList + i))
+        {
+            fprintf(stdout, "/%d/%d, ", uriList[i].objectId, uriList[i].instanceId);
+        }
+        else
+        {
+            fprintf(stdout, "/%d, ", uriList[i].objectId);
+        }
+    }
+    fprintf(stdout, "\r\n");
+}
+
 static void prv_dump_client(lwm2m_client_t * targetP)
 {
     lwm2m_client_object_t * objectP;
@@ -156,20 +184,15 @@ static void prv_dump_client(lwm2m_client_t * targetP)
     if (targetP->altPath) fprintf(stdout, "\talternative path: \"%s\"\r\n", targetP->altPath);
     fprintf(stdout, "\tlifetime: %d sec\r\n", targetP->lifetime);
     fprintf(stdout, "\tobjects: ");
-    for (objectP = targetP->objectList; objectP != NULL ; objectP = objectP->next)
+    for (objectP = targetP->objectList->objects; objectP < targetP->objectList->objects + targetP->objectList->count ; objectP++)
     {
-        if (objectP->instanceList == NULL)
+        if (objectP->instanceId == LWM2M_MAX_ID)
         {
-            fprintf(stdout, "/%d, ", objectP->id);
+            fprintf(stdout, "/%d, ", objectP->objectId);
         }
         else
         {
-            lwm2m_list_t * instanceP;
-
-            for (instanceP = objectP->instanceList; instanceP != NULL ; instanceP = instanceP->next)
-            {
-                fprintf(stdout, "/%d/%d, ", objectP->id, instanceP->id);
-            }
+            fprintf(stdout, "/%d/%d, ", objectP->objectId, objectP->instanceId);
         }
     }
     fprintf(stdout, "\r\n");
@@ -797,9 +820,12 @@ static void prv_monitor_callback(uint16_t clientID,
     case COAP_201_CREATED:
         fprintf(stdout, "\r\nNew client #%d registered.\r\n", clientID);
 
-        targetP = (lwm2m_client_t *)lwm2m_list_find((lwm2m_list_t *)lwm2mH->clientList, clientID);
+        targetP = lwm2m_get_client(lwm2mH, clientID);
 
         prv_dump_client(targetP);
+#ifdef LWM2M_SUPPORT_SENML_JSON
+        if (g_composite) lwm2m_set_client_composite_notifications(lwm2mH, clientID, true);
+#endif
         break;
 
     case COAP_202_DELETED:
@@ -809,9 +835,14 @@ static void prv_monitor_callback(uint16_t clientID,
     case COAP_204_CHANGED:
         fprintf(stdout, "\r\nClient #%d updated.\r\n", clientID);
 
-        targetP = (lwm2m_client_t *)lwm2m_list_find((lwm2m_list_t *)lwm2mH->clientList, clientID);
+        targetP = lwm2m_get_client(lwm2mH, clientID);
 
         prv_dump_client(targetP);
+        if (targetP->objectDiff != NULL)
+        {
+            prv_dump_diff("added", targetP->objectDiff->addedList, targetP->objectDiff->addedCount);
+            prv_dump_diff("removed", targetP->objectDiff->removedList, targetP->objectDiff->removedCount);
+        }
         break;
 
     default:
@@ -842,6 +873,10 @@ void print_usage(void)
     fprintf(stdout, "Options:\r\n");
     fprintf(stdout, "  -4\t\tUse IPv4 connection. Default: IPv6 connection\r\n");
     fprintf(stdout, "  -l PORT\tSet the local UDP port of the Server. Default: "LWM2M_STANDARD_PORT_STR"\r\n");
+    fprintf(stdout, "  -r RATE\tLimit the new registrations to RATE per second. Default: no limit\r\n");
+#ifdef LWM2M_SUPPORT_SENML_JSON
+    fprintf(stdout, "  -C\t\tSplit the SenML-JSON notifications packed by the clients (client option -C).\r\n");
+#endif
     fprintf(stdout, "\r\n");
 }
 
@@ -851,6 +886,7 @@ int main(int argc, char *argv[])
     int sock;
     fd_set readfds;
     struct timeval tv;
+    int64_t timeout;
     int result;
     lwm2m_context_t * lwm2mH = NULL;
     int i;
@@ -858,6 +894,7 @@ int main(int argc, char *argv[])
     int addressFamily = AF_INET6;
     int opt;
     const char * localPort = LWM2M_STANDARD_PORT_STR;
+    uint32_t registrationLimit = 0;
 
     command_desc_t commands[] =
     {
@@ -943,6 +980,20 @@ int main(int argc, char *argv[])
             }
             localPort = argv[opt];
             break;
+        case 'r':
+            opt++;
+            if (opt >= argc)
+            {
+                print_usage();
+                return 0;
+            }
+            registrationLimit = (uint32_t)strtoul(argv[opt], NULL, 10);
+            break;
+#ifdef LWM2M_SUPPORT_SENML_JSON
+        case 'C':
+            g_composite = true;
+            break;
+#endif
         default:
             print_usage();
             return 0;
@@ -973,6 +1024,9 @@ int main(int argc, char *argv[])
     fprintf(stdout, "> "); fflush(stdout);
 
     lwm2m_set_monitoring_callback(lwm2mH, prv_monitor_callback, lwm2mH);
+    // adapt the retransmissions to the round-trip time of each client
+    lwm2m_set_rto_mode(lwm2mH, LWM2M_RTO_COCOA);
+    lwm2m_set_registration_limit(lwm2mH, registrationLimit, REGISTRATION_BACKOFF);
 
     while (0 == g_quit)
     {
@@ -983,10 +1037,13 @@ int main(int argc, char *argv[])
         tv.tv_sec = 60;
         tv.tv_usec = 0;
 
-        result = lwm2m_step(lwm2mH, &(tv.tv_sec));
+        timeout = (int64_t)tv.tv_sec * 1000;
+        result = lwm2m_step_ms(lwm2mH, &timeout);
+        tv.tv_sec = (time_t)(timeout / 1000);
+        tv.tv_usec = (suseconds_t)((timeout % 1000) * 1000);
         if (result != 0)
         {
-            fprintf(stderr, "lwm2m_step() failed: 0x%X\r\n", result);
+            fprintf(stderr, "lwm2m_step_ms() failed: 0x%X\r\n", result);
             return -1;
         }
 
@@ -1006,6 +1063,21 @@ int main(int argc, char *argv[])
 
             if (FD_ISSET(sock, &readfds))
             {
+#ifdef LWM2M_WITH_BATCH_SEND
+                uint8_t batchBuffers[CONNECTION_BATCH_SIZE * MAX_PACKET_SIZE];
+                lwm2m_packet_t packets[CONNECTION_BATCH_SIZE];
+                int count;
+
+                count = connection_receive_batch(sock, &connList, batchBuffers, MAX_PACKET_SIZE, packets, CONNECTION_BATCH_SIZE);
+                if (count == -1)
+                {
+                    fprintf(stderr, "Error in recvmmsg(): %d\r\n", errno);
+                }
+                else
+                {
+                    lwm2m_handle_packets(lwm2mH, packets, count);
+                }
+#else
                 struct sockaddr_storage addr;
                 socklen_t addrLen;
 
@@ -1053,6 +1125,7 @@ int main(int argc, char *argv[])
                         lwm2m_handle_packet(lwm2mH, buffer, numBytes, connP);
                     }
                 }
+#endif
             }
             else if (FD_ISSET(STDIN_FILENO, &readfds))
             {
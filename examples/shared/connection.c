@@ -16,9 +16,15 @@
  *    
  *******************************************************************************/
 
+#ifdef LWM2M_WITH_BATCH_SEND
+// for recvmmsg() and sendmmsg()
+#define _GNU_SOURCE
+#endif
+
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <errno.h>
 #include "connection.h"
 #include "commandline.h"
 
@@ -230,3 +236,165 @@ bool lwm2m_session_is_equal(void * session1,
 
     return (session1 == session2);
 }
+
+#ifdef LWM2M_SESSION_HASH
+uint32_t lwm2m_session_hash(void * sessionH,
+                            void * userData)
+{
+    (void)userData; /* unused */
+
+    // sessions are equal when they are the same connection
+    return (uint32_t)(uintptr_t)sessionH;
+}
+#endif
+
+#ifdef LWM2M_WITH_BATCH_SEND
+int connection_receive_batch(int sock,
+                             connection_t ** connListP,
+                             uint8_t * buffers,
+                             size_t bufferSize,
+                             lwm2m_packet_t * packets,
+                             int count)
+{
+    struct mmsghdr msgs[CONNECTION_BATCH_SIZE];
+    struct iovec iovecs[CONNECTION_BATCH_SIZE];
+    struct sockaddr_storage addrs[CONNECTION_BATCH_SIZE];
+    int received;
+    int nbPackets;
+    int i;
+
+    if (count > CONNECTION_BATCH_SIZE) count = CONNECTION_BATCH_SIZE;
+
+    memset(msgs, 0, count * sizeof(struct mmsghdr));
+    for (i = 0 ; i < count ; i++)
+    {
+        iovecs[i].iov_base = buffers + i * bufferSize;
+        iovecs[i].iov_len = bufferSize;
+        msgs[i].msg_hdr.msg_iov = iovecs + i;
+        msgs[i].msg_hdr.msg_iovlen = 1;
+        msgs[i].msg_hdr.msg_name = addrs + i;
+        msgs[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_storage);
+    }
+
+    // only read the datagrams already queued
+    received = recvmmsg(sock, msgs, count, MSG_DONTWAIT, NULL);
+    if (received == -1) return -1;
+
+    nbPackets = 0;
+    for (i = 0 ; i < received ; i++)
+    {
+        char s[INET6_ADDRSTRLEN];
+        in_port_t port = 0;
+        connection_t * connP;
+
+        s[0] = 0;
+        if (AF_INET == addrs[i].ss_family)
+        {
+            struct sockaddr_in *saddr = (struct sockaddr_in *)(addrs + i);
+            inet_ntop(saddr->sin_family, &saddr->sin_addr, s, INET6_ADDRSTRLEN);
+            port = saddr->sin_port;
+        }
+        else if (AF_INET6 == addrs[i].ss_family)
+        {
+            struct sockaddr_in6 *saddr = (struct sockaddr_in6 *)(addrs + i);
+            inet_ntop(saddr->sin6_family, &saddr->sin6_addr, s, INET6_ADDRSTRLEN);
+            port = saddr->sin6_port;
+        }
+
+        if (msgs[i].msg_hdr.msg_flags & MSG_TRUNC)
+        {
+            // a cut-off CoAP message cannot be parsed
+            fprintf(stderr, "Dropping a datagram larger than %zu bytes from [%s]:%hu\r\n", bufferSize, s, ntohs(port));
+            continue;
+        }
+
+        fprintf(stderr, "%u bytes received from [%s]:%hu\r\n", msgs[i].msg_len, s, ntohs(port));
+        output_buffer(stderr, iovecs[i].iov_base, msgs[i].msg_len, 0);
+
+        connP = connection_find(*connListP, addrs + i, msgs[i].msg_hdr.msg_namelen);
+        if (connP == NULL)
+        {
+            connP = connection_new_incoming(*connListP, sock, (struct sockaddr *)(addrs + i), msgs[i].msg_hdr.msg_namelen);
+            if (connP != NULL)
+            {
+                *connListP = connP;
+            }
+        }
+        if (connP != NULL)
+        {
+            packets[nbPackets].buffer = iovecs[i].iov_base;
+            packets[nbPackets].length = msgs[i].msg_len;
+            packets[nbPackets].sessionH = connP;
+            nbPackets++;
+        }
+    }
+
+    return nbPackets;
+}
+
+uint8_t lwm2m_buffer_send_batch(lwm2m_packet_t * packets,
+                                size_t count,
+                                void * userData)
+{
+    struct mmsghdr msgs[CONNECTION_BATCH_SIZE];
+    struct iovec iovecs[CONNECTION_BATCH_SIZE];
+    uint8_t result = COAP_NO_ERROR;
+    size_t first;
+
+    (void)userData; /* unused */
+
+    first = 0;
+    while (first < count)
+    {
+        connection_t * connP = (connection_t *)packets[first].sessionH;
+        unsigned int nbMsgs;
+        unsigned int offset;
+
+        if (connP == NULL)
+        {
+            fprintf(stderr, "#> failed sending %zu bytes, missing connection\r\n", packets[first].length);
+            result = COAP_500_INTERNAL_SERVER_ERROR;
+            first++;
+            continue;
+        }
+
+        // consecutive datagrams sent on the same socket
+        memset(msgs, 0, sizeof(msgs));
+        nbMsgs = 0;
+        while (first + nbMsgs < count
+            && nbMsgs < CONNECTION_BATCH_SIZE
+            && packets[first + nbMsgs].sessionH != NULL
+            && ((connection_t *)packets[first + nbMsgs].sessionH)->sock == connP->sock)
+        {
+            connection_t * targetP = (connection_t *)packets[first + nbMsgs].sessionH;
+
+            iovecs[nbMsgs].iov_base = packets[first + nbMsgs].buffer;
+            iovecs[nbMsgs].iov_len = packets[first + nbMsgs].length;
+            msgs[nbMsgs].msg_hdr.msg_iov = iovecs + nbMsgs;
+            msgs[nbMsgs].msg_hdr.msg_iovlen = 1;
+            msgs[nbMsgs].msg_hdr.msg_name = &(targetP->addr);
+            msgs[nbMsgs].msg_hdr.msg_namelen = targetP->addrLen;
+            nbMsgs++;
+        }
+
+        offset = 0;
+        while (offset != nbMsgs)
+        {
+            int nbSent;
+
+            nbSent = sendmmsg(connP->sock, msgs + offset, nbMsgs - offset, 0);
+            if (nbSent == -1)
+            {
+                if (errno == EINTR) continue;
+                fprintf(stderr, "#> failed sending %u datagrams\r\n", nbMsgs - offset);
+                result = COAP_500_INTERNAL_SERVER_ERROR;
+                break;
+            }
+            offset += nbSent;
+        }
+        first += nbMsgs;
+    }
+
+    return result;
+}
+#endif
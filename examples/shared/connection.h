@@ -52,4 +52,15 @@ void connection_free(connection_t * connList);
 
 int connection_send(connection_t *connP, uint8_t * buffer, size_t length);
 
+#ifdef LWM2M_WITH_BATCH_SEND
+// Maximum number of datagrams received or sent in one system call
+#define CONNECTION_BATCH_SIZE   32
+
+// Receive up to count queued datagrams on sock in one system call.
+// buffers holds count buffers of bufferSize bytes. packets are filled with the received
+// datagrams and their connection, new connections are added to *connListP.
+// Returns the number of packets or -1 in case of error.
+int connection_receive_batch(int sock, connection_t ** connListP, uint8_t * buffers, size_t bufferSize, lwm2m_packet_t * packets, int count);
+#endif
+
 #endif
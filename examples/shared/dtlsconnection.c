@@ -646,3 +646,14 @@ bool lwm2m_session_is_equal(void * session1,
 {
     return (session1 == session2);
 }
+
+#ifdef LWM2M_SESSION_HASH
+uint32_t lwm2m_session_hash(void * sessionH,
+                            void * userData)
+{
+    (void)userData; /* unused */
+
+    // sessions are equal when they are the same connection
+    return (uint32_t)(uintptr_t)sessionH;
+}
+#endif
@@ -28,4 +28,7 @@ else()
     set(SHARED_INCLUDE_DIRS ${SHARED_SOURCES_DIR})
 endif()
 
-
+# Use the millisecond monotonic clock of platform.c for the core timers
+set(SHARED_DEFINITIONS ${SHARED_DEFINITIONS} -DLWM2M_WITH_TIME_MS)
+# connection.c and dtlsconnection.c provide lwm2m_session_hash()
+set(SHARED_DEFINITIONS ${SHARED_DEFINITIONS} -DLWM2M_SESSION_HASH)
@@ -0,0 +1,121 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2026 Eclipse Wakaama contributors and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * The Eclipse Distribution License is available at
+ *    http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Please refer to git log
+ *
+ *******************************************************************************/
+
+/*
+ * Microbenchmark of the link-format tokenizer on a large Register payload.
+ *
+ * Usage: linkformatbench [iterations]
+ */
+
+#include "internals.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define BENCH_OBJECT_COUNT    200
+#define BENCH_INSTANCE_COUNT  4
+#define BENCH_DEFAULT_LOOPS   20000
+
+static size_t prv_buildPayload(uint8_t * buffer,
+                               size_t size)
+{
+    size_t length;
+    int objId;
+    int instId;
+
+    length = (size_t)snprintf((char *)buffer, size, "</>;rt=\"oma.lwm2m\";ct=110");
+    for (objId = 0 ; objId < BENCH_OBJECT_COUNT && length < size ; objId++)
+    {
+        for (instId = 0 ; instId < BENCH_INSTANCE_COUNT && length < size ; instId++)
+        {
+            length += (size_t)snprintf((char *)buffer + length, size - length, ", </%d/%d>", 3000 + objId, instId);
+        }
+    }
+
+    return length < size ? length : size;
+}
+
+static double prv_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char * argv[])
+{
+    static uint8_t payload[BENCH_OBJECT_COUNT * BENCH_INSTANCE_COUNT * 16 + 64];
+    size_t length;
+    long loops;
+    long i;
+    size_t links;
+    size_t attributes;
+    double start;
+    double elapsed;
+
+    loops = BENCH_DEFAULT_LOOPS;
+    if (argc > 1) loops = strtol(argv[1], NULL, 10);
+    if (loops <= 0) return 1;
+
+    length = prv_buildPayload(payload, sizeof(payload));
+
+    links = 0;
+    attributes = 0;
+    start = prv_now();
+    for (i = 0 ; i < loops ; i++)
+    {
+        size_t index = 0;
+        link_entry_t link;
+        int result;
+
+        while (0 < (result = linkformat_nextLink(payload, length, &index, &link)))
+        {
+            links++;
+            if (link.attributes != NULL)
+            {
+                size_t attrIndex = 0;
+                uint8_t * key;
+                size_t keyLength;
+                uint8_t * value;
+                size_t valueLength;
+
+                while (0 < linkformat_nextAttribute(link.attributes, link.attributesLength, &attrIndex,
+                                                    &key, &keyLength, &value, &valueLength))
+                {
+                    attributes++;
+                }
+            }
+        }
+        if (result < 0)
+        {
+            fprintf(stderr, "Parsing error at index %zu\r\n", index);
+            return 1;
+        }
+    }
+    elapsed = prv_now() - start;
+
+    printf("payload: %zu bytes, %zu links, %zu attributes per iteration\r\n",
+           length, links / (size_t)loops, attributes / (size_t)loops);
+    printf("%ld iterations in %.3f s: %.2f us per payload, %.1f MB/s\r\n",
+           loops, elapsed, elapsed * 1e6 / (double)loops,
+           (double)length * (double)loops / elapsed / 1e6);
+
+    return 0;
+}
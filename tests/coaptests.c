@@ -0,0 +1,147 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2026 Eclipse Wakaama contributors and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * The Eclipse Distribution License is available at
+ *    http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Please refer to git log
+ *
+ *******************************************************************************/
+
+#include "tests.h"
+#include "CUnit/Basic.h"
+#include "internals.h"
+#include "memtest.h"
+
+static void test_coap_parse_inline_options(void)
+{
+    // CON GET /3/0/13?pmin=10 with a 2-byte token
+    uint8_t buffer[] = { 0x42, 0x01, 0x12, 0x34, 0xAB, 0xCD,
+                         0xB1, '3', 0x01, '0', 0x02, '1', '3',
+                         0x47, 'p', 'm', 'i', 'n', '=', '1', '0' };
+    coap_packet_t message;
+    multi_option_t * optP;
+    int count;
+
+    MEMORY_TRACE_BEFORE;
+    CU_ASSERT_EQUAL(coap_parse_message(&message, buffer, sizeof(buffer)), NO_ERROR);
+    CU_ASSERT_EQUAL(message.code, COAP_GET);
+    CU_ASSERT_EQUAL(message.mid, 0x1234);
+    CU_ASSERT_EQUAL(message.token_len, 2);
+    CU_ASSERT_EQUAL(message.parsed_options_count, 4);
+
+    count = 0;
+    for (optP = message.uri_path ; optP != NULL ; optP = optP->next)
+    {
+        CU_ASSERT(optP->is_inline);
+        // options point into the received buffer
+        CU_ASSERT(optP->data > buffer && optP->data < buffer + sizeof(buffer));
+        count++;
+    }
+    CU_ASSERT_EQUAL(count, 3);
+
+    CU_ASSERT_PTR_NOT_NULL(message.uri_query);
+    if (message.uri_query != NULL)
+    {
+        CU_ASSERT(message.uri_query->is_inline);
+        CU_ASSERT_EQUAL(message.uri_query->len, 7);
+        CU_ASSERT_NSTRING_EQUAL(message.uri_query->data, "pmin=10", 7);
+    }
+
+    coap_free_header(&message);
+    MEMORY_TRACE_AFTER_EQ;
+}
+
+static void test_coap_parse_many_options(void)
+{
+    // CON POST /rd?a&b&c&d&e&f&g&h&i exceeding the inline storage
+    uint8_t buffer[] = { 0x40, 0x02, 0x00, 0x01,
+                         0xB2, 'r', 'd',
+                         0x41, 'a', 0x01, 'b', 0x01, 'c', 0x01, 'd', 0x01, 'e',
+                         0x01, 'f', 0x01, 'g', 0x01, 'h', 0x01, 'i' };
+    coap_packet_t message;
+    multi_option_t * optP;
+    char expected;
+
+    MEMORY_TRACE_BEFORE;
+    CU_ASSERT_EQUAL(coap_parse_message(&message, buffer, sizeof(buffer)), NO_ERROR);
+    CU_ASSERT_EQUAL(message.parsed_options_count, COAP_PARSED_OPTIONS_MAX);
+
+    expected = 'a';
+    for (optP = message.uri_query ; optP != NULL ; optP = optP->next)
+    {
+        CU_ASSERT_EQUAL(optP->len, 1);
+        CU_ASSERT_EQUAL(optP->data[0], expected);
+        expected++;
+    }
+    CU_ASSERT_EQUAL(expected, 'j');
+
+    coap_free_header(&message);
+    MEMORY_TRACE_AFTER_EQ;
+}
+
+static void test_coap_serialize_buffer_size(void)
+{
+    coap_packet_t message;
+    coap_packet_t parsed;
+    uint8_t buffer[64];
+    uint8_t token[] = { 0x01, 0x02, 0x03, 0x04 };
+    size_t length;
+    size_t i;
+
+    MEMORY_TRACE_BEFORE;
+    coap_init_message(&message, COAP_TYPE_CON, COAP_GET, 0x4321);
+    coap_set_header_token(&message, token, sizeof(token));
+    coap_set_header_uri_path(&message, "/3/0/13");
+    coap_set_header_uri_query(&message, "pmin=10&pmax=60");
+    coap_set_payload(&message, "payload", 7);
+
+    // too small buffers are rejected without consuming the message
+    for (i = 0 ; i < 39 ; i++)
+    {
+        CU_ASSERT_EQUAL(coap_serialize_message(&message, buffer, i), 0);
+    }
+    CU_ASSERT_PTR_NOT_NULL(message.uri_path);
+
+    length = coap_serialize_message(&message, buffer, sizeof(buffer));
+    CU_ASSERT_EQUAL(length, 39);
+
+    CU_ASSERT_EQUAL(coap_parse_message(&parsed, buffer, (uint16_t)length), NO_ERROR);
+    CU_ASSERT_EQUAL(parsed.mid, 0x4321);
+    CU_ASSERT_EQUAL(parsed.token_len, sizeof(token));
+    CU_ASSERT_EQUAL(parsed.payload_len, 7);
+    CU_ASSERT_NSTRING_EQUAL(parsed.payload, "payload", 7);
+    CU_ASSERT_PTR_NOT_NULL(parsed.uri_query);
+    if (parsed.uri_query != NULL)
+    {
+        CU_ASSERT_PTR_NOT_NULL(parsed.uri_query->next);
+    }
+    coap_free_header(&parsed);
+    MEMORY_TRACE_AFTER_EQ;
+}
+
+static struct TestTable table[] = {
+        { "test of coap_parse_message() without allocation", test_coap_parse_inline_options },
+        { "test of coap_parse_message() with many options", test_coap_parse_many_options },
+        { "test of coap_serialize_message() buffer size", test_coap_serialize_buffer_size },
+        { NULL, NULL },
+};
+
+CU_ErrorCode create_coap_suit()
+{
+   CU_pSuite pSuite = NULL;
+
+   pSuite = CU_add_suite("Suite_CoAP", NULL, NULL);
+   if (NULL == pSuite) {
+      return CU_get_error();
+   }
+
+   return add_tests(pSuite, table);
+}
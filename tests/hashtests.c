@@ -0,0 +1,151 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2026 Eclipse Wakaama contributors and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * The Eclipse Distribution License is available at
+ *    http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Please refer to git log
+ *
+ *******************************************************************************/
+
+#include "tests.h"
+#include "CUnit/Basic.h"
+#include "internals.h"
+#include "memtest.h"
+
+#define HASH_TEST_ITEMS 100
+
+typedef struct
+{
+    lwm2m_hash_link_t link;
+    uint16_t key;
+} hash_test_item_t;
+
+static hash_test_item_t * prv_find(lwm2m_hash_table_t * tableP,
+                                   uint16_t key)
+{
+    lwm2m_hash_link_t * linkP;
+
+    for (linkP = hash_find(tableP, hash_integer(key)) ; linkP != NULL ; linkP = hash_findNext(linkP))
+    {
+        hash_test_item_t * itemP = (hash_test_item_t *)linkP->itemP;
+
+        if (itemP->key == key) return itemP;
+    }
+
+    return NULL;
+}
+
+static void test_hash_add_find_remove(void)
+{
+    lwm2m_hash_table_t table;
+    hash_test_item_t items[HASH_TEST_ITEMS];
+    int i;
+
+    MEMORY_TRACE_BEFORE;
+    memset(&table, 0, sizeof(table));
+
+    for (i = 0 ; i < HASH_TEST_ITEMS ; i++)
+    {
+        items[i].key = (uint16_t)(i * 3);
+        hash_add(&table, &items[i].link, hash_integer(items[i].key), items + i);
+    }
+    CU_ASSERT_EQUAL(table.count, HASH_TEST_ITEMS);
+    CU_ASSERT(table.size >= HASH_TEST_ITEMS / 2);
+
+    for (i = 0 ; i < HASH_TEST_ITEMS ; i++)
+    {
+        CU_ASSERT_PTR_EQUAL(prv_find(&table, (uint16_t)(i * 3)), items + i);
+    }
+    CU_ASSERT_PTR_NULL(prv_find(&table, 1));
+
+    for (i = 0 ; i < HASH_TEST_ITEMS ; i += 2)
+    {
+        hash_remove(&table, &items[i].link);
+    }
+    CU_ASSERT_EQUAL(table.count, HASH_TEST_ITEMS / 2);
+
+    for (i = 0 ; i < HASH_TEST_ITEMS ; i++)
+    {
+        if (i % 2 == 0)
+        {
+            CU_ASSERT_PTR_NULL(prv_find(&table, (uint16_t)(i * 3)));
+        }
+        else
+        {
+            CU_ASSERT_PTR_EQUAL(prv_find(&table, (uint16_t)(i * 3)), items + i);
+        }
+    }
+
+    hash_free(&table);
+    CU_ASSERT_EQUAL(table.count, 0);
+    MEMORY_TRACE_AFTER_EQ;
+}
+
+static void test_hash_collisions(void)
+{
+    lwm2m_hash_table_t table;
+    hash_test_item_t items[3];
+    lwm2m_hash_link_t * linkP;
+    int found;
+
+    memset(&table, 0, sizeof(table));
+
+    // same hash value for all the items
+    items[0].key = 1;
+    items[1].key = 2;
+    items[2].key = 3;
+    hash_add(&table, &items[0].link, 42, items);
+    hash_add(&table, &items[1].link, 42, items + 1);
+    hash_add(&table, &items[2].link, 42 + LWM2M_HASH_MIN_SIZE, items + 2);
+
+    found = 0;
+    for (linkP = hash_find(&table, 42) ; linkP != NULL ; linkP = hash_findNext(linkP))
+    {
+        CU_ASSERT_EQUAL(linkP->hash, 42);
+        found++;
+    }
+    CU_ASSERT_EQUAL(found, 2);
+
+    linkP = hash_find(&table, 42 + LWM2M_HASH_MIN_SIZE);
+    CU_ASSERT_PTR_NOT_NULL(linkP);
+    if (linkP != NULL) CU_ASSERT_PTR_EQUAL(linkP->itemP, items + 2);
+
+    hash_free(&table);
+}
+
+static void test_hash_bytes(void)
+{
+    uint8_t token1[] = { 0x01, 0x02, 0x03, 0x04 };
+    uint8_t token2[] = { 0x01, 0x02, 0x03, 0x05 };
+
+    CU_ASSERT_EQUAL(hash_bytes(token1, sizeof(token1)), hash_bytes(token1, sizeof(token1)));
+    CU_ASSERT_NOT_EQUAL(hash_bytes(token1, sizeof(token1)), hash_bytes(token2, sizeof(token2)));
+    CU_ASSERT_EQUAL(hash_bytes((const uint8_t *)"urn:imei:1", 10), hash_string("urn:imei:1"));
+}
+
+static struct TestTable table[] = {
+        { "test of hash_add() and hash_remove()", test_hash_add_find_remove },
+        { "test of hash_find() with collisions", test_hash_collisions },
+        { "test of hash_bytes()", test_hash_bytes },
+        { NULL, NULL },
+};
+
+CU_ErrorCode create_hash_suit()
+{
+   CU_pSuite pSuite = NULL;
+
+   pSuite = CU_add_suite("Suite_Hash", NULL, NULL);
+   if (NULL == pSuite) {
+      return CU_get_error();
+   }
+
+   return add_tests(pSuite, table);
+}
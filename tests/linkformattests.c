@@ -0,0 +1,127 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2026 Eclipse Wakaama contributors and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * The Eclipse Distribution License is available at
+ *    http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Please refer to git log
+ *
+ *******************************************************************************/
+
+
+#include "tests.h"
+#include "CUnit/Basic.h"
+#include "internals.h"
+
+#define PAYLOAD(str) (uint8_t *)(str), sizeof(str) - 1
+
+static void test_linkformat_links(void)
+{
+    uint8_t buffer[] = "</>;rt=\"oma.lwm2m\";ct=110, </1/0>,</3/0> ,</5>,";
+    size_t length = sizeof(buffer) - 1;
+    size_t index = 0;
+    link_entry_t link;
+
+    CU_ASSERT_EQUAL(linkformat_nextLink(buffer, length, &index, &link), 1);
+    CU_ASSERT_EQUAL(link.pathLength, 0);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(link.attributes);
+    CU_ASSERT_EQUAL(link.attributesLength, 21);
+    CU_ASSERT_NSTRING_EQUAL(link.attributes, "rt=\"oma.lwm2m\";ct=110", 21);
+
+    CU_ASSERT_EQUAL(linkformat_nextLink(buffer, length, &index, &link), 1);
+    CU_ASSERT_EQUAL(link.pathLength, 3);
+    CU_ASSERT_NSTRING_EQUAL(link.path, "1/0", 3);
+    CU_ASSERT_PTR_NULL(link.attributes);
+
+    CU_ASSERT_EQUAL(linkformat_nextLink(buffer, length, &index, &link), 1);
+    CU_ASSERT_NSTRING_EQUAL(link.path, "3/0", 3);
+
+    CU_ASSERT_EQUAL(linkformat_nextLink(buffer, length, &index, &link), 1);
+    CU_ASSERT_EQUAL(link.pathLength, 1);
+    CU_ASSERT_NSTRING_EQUAL(link.path, "5", 1);
+
+    // the trailing delimiter ends the payload
+    CU_ASSERT_EQUAL(linkformat_nextLink(buffer, length, &index, &link), 0);
+    CU_ASSERT_EQUAL(index, length);
+}
+
+static void test_linkformat_errors(void)
+{
+    link_entry_t link;
+    size_t index;
+
+    index = 0;
+    CU_ASSERT_EQUAL(linkformat_nextLink(PAYLOAD("</1/0"), &index, &link), -1);
+    index = 0;
+    CU_ASSERT_EQUAL(linkformat_nextLink(PAYLOAD("/1/0>"), &index, &link), -1);
+    index = 0;
+    CU_ASSERT_EQUAL(linkformat_nextLink(PAYLOAD("</1/0>x"), &index, &link), -1);
+    // empty links are not allowed
+    index = 0;
+    CU_ASSERT_EQUAL(linkformat_nextLink(PAYLOAD("</1/0>,,</3/0>"), &index, &link), 1);
+    CU_ASSERT_EQUAL(linkformat_nextLink(PAYLOAD("</1/0>,,</3/0>"), &index, &link), -1);
+    index = 0;
+    CU_ASSERT_EQUAL(linkformat_nextLink(PAYLOAD("  "), &index, &link), 0);
+}
+
+static void test_linkformat_attributes(void)
+{
+    uint8_t buffer[] = "rt=\"oma.lwm2m\" ; ct = 1;ver=1.1";
+    size_t length = sizeof(buffer) - 1;
+    size_t index = 0;
+    uint8_t * key;
+    size_t keyLength;
+    uint8_t * value;
+    size_t valueLength;
+
+    CU_ASSERT_EQUAL(linkformat_nextAttribute(buffer, length, &index, &key, &keyLength, &value, &valueLength), 1);
+    CU_ASSERT_EQUAL(keyLength, 2);
+    CU_ASSERT_NSTRING_EQUAL(key, "rt", 2);
+    CU_ASSERT_EQUAL(valueLength, 11);
+    CU_ASSERT_NSTRING_EQUAL(value, "\"oma.lwm2m\"", 11);
+
+    // spaces around the key and the value are ignored
+    CU_ASSERT_EQUAL(linkformat_nextAttribute(buffer, length, &index, &key, &keyLength, &value, &valueLength), 1);
+    CU_ASSERT_EQUAL(keyLength, 2);
+    CU_ASSERT_NSTRING_EQUAL(key, "ct", 2);
+    CU_ASSERT_EQUAL(valueLength, 1);
+    CU_ASSERT_NSTRING_EQUAL(value, "1", 1);
+
+    CU_ASSERT_EQUAL(linkformat_nextAttribute(buffer, length, &index, &key, &keyLength, &value, &valueLength), 1);
+    CU_ASSERT_NSTRING_EQUAL(key, "ver", 3);
+    CU_ASSERT_NSTRING_EQUAL(value, "1.1", 3);
+
+    CU_ASSERT_EQUAL(linkformat_nextAttribute(buffer, length, &index, &key, &keyLength, &value, &valueLength), 0);
+
+    // attributes without value
+    index = 0;
+    CU_ASSERT_EQUAL(linkformat_nextAttribute(PAYLOAD("obs"), &index, &key, &keyLength, &value, &valueLength), -1);
+    index = 0;
+    CU_ASSERT_EQUAL(linkformat_nextAttribute(PAYLOAD("ct= ;rt=1"), &index, &key, &keyLength, &value, &valueLength), -1);
+}
+
+static struct TestTable table[] = {
+        { "test of linkformat_nextLink()", test_linkformat_links },
+        { "test of linkformat_nextLink() errors", test_linkformat_errors },
+        { "test of linkformat_nextAttribute()", test_linkformat_attributes },
+        { NULL, NULL },
+};
+
+CU_ErrorCode create_linkformat_suit()
+{
+   CU_pSuite pSuite = NULL;
+
+   pSuite = CU_add_suite("Suite_LinkFormat", NULL, NULL);
+   if (NULL == pSuite) {
+      return CU_get_error();
+   }
+
+   return add_tests(pSuite, table);
+}
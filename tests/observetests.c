@@ -0,0 +1,737 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2026 Eclipse Wakaama contributors and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * The Eclipse Distribution License is available at
+ *    http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Please refer to git log
+ *
+ *******************************************************************************/
+
+
+#include "tests.h"
+#include "CUnit/Basic.h"
+#include "internals.h"
+#include "connection.h"
+#include "memtest.h"
+
+static lwm2m_watcher_t * prv_observe(lwm2m_context_t * contextP,
+                                     lwm2m_server_t * serverP,
+                                     lwm2m_uri_t * uriP)
+{
+    uint8_t token[] = { 0x01, 0x02 };
+    coap_packet_t message;
+    coap_packet_t response;
+    lwm2m_data_t * dataP;
+    lwm2m_observed_t * observedP;
+
+    coap_init_message(&message, COAP_TYPE_CON, COAP_GET, 0x1000);
+    coap_set_header_token(&message, token, sizeof(token));
+    coap_set_header_observe(&message, 0);
+    coap_init_message(&response, COAP_TYPE_ACK, COAP_205_CONTENT, 0x1000);
+
+    dataP = lwm2m_data_new(1);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(dataP);
+    lwm2m_data_encode_int(42, dataP);
+    CU_ASSERT_EQUAL(observe_handleRequest(contextP, uriP, serverP, 1, dataP, &message, &response), COAP_205_CONTENT);
+    lwm2m_data_free(1, dataP);
+
+    observedP = observe_findByUri(contextP, uriP);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(observedP);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(observedP->watcherList);
+
+    return observedP->watcherList;
+}
+
+static void test_observe_schedule(void)
+{
+    lwm2m_context_t * contextP;
+    lwm2m_server_t server;
+    lwm2m_uri_t uri;
+    lwm2m_watcher_t * watcherP;
+    lwm2m_attributes_t * attrP;
+    time_t timeout;
+    time_t now;
+
+    MEMORY_TRACE_BEFORE;
+    memset(&server, 0, sizeof(server));
+    contextP = lwm2m_init(NULL);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(contextP);
+    CU_ASSERT_EQUAL(lwm2m_stringToUri("/1024/0/1", 9, &uri), 9);
+
+    // without change nor period, nothing is checked
+    watcherP = prv_observe(contextP, &server, &uri);
+    CU_ASSERT_PTR_EQUAL(watcherP->observed, contextP->observedList);
+    CU_ASSERT_EQUAL(contextP->observeTimers.count, 0);
+    now = utils_gettime();
+    timeout = 60;
+    observe_step(contextP, now, &timeout);
+    CU_ASSERT_EQUAL(timeout, 60);
+
+    // a change is checked at once
+    lwm2m_resource_value_changed(contextP, &uri);
+    CU_ASSERT(watcherP->update);
+    CU_ASSERT_PTR_EQUAL(timer_peek(&contextP->observeTimers), &watcherP->timer);
+    CU_ASSERT(watcherP->timer.time <= now);
+
+    // the object does not exist, the read is retried in the next step
+    observe_step(contextP, now, &timeout);
+    CU_ASSERT_EQUAL(watcherP->timer.time, now + 1);
+    CU_ASSERT_EQUAL(timeout, 1);
+    CU_ASSERT(watcherP->update);
+
+    // the change waits for the minimal period
+    attrP = (lwm2m_attributes_t *)lwm2m_malloc(sizeof(lwm2m_attributes_t));
+    CU_ASSERT_PTR_NOT_NULL_FATAL(attrP);
+    memset(attrP, 0, sizeof(lwm2m_attributes_t));
+    attrP->toSet = LWM2M_ATTR_FLAG_MIN_PERIOD | LWM2M_ATTR_FLAG_MAX_PERIOD;
+    attrP->minPeriod = 10;
+    attrP->maxPeriod = 30;
+    watcherP->parameters = attrP;
+    watcherP->lastTime = now;
+    lwm2m_resource_value_changed(contextP, &uri);
+    CU_ASSERT_EQUAL(watcherP->timer.time, now + 10);
+
+    timeout = 60;
+    observe_step(contextP, now, &timeout);
+    CU_ASSERT_EQUAL(timeout, 10);
+
+    // the observation is cleared with its timer
+    observe_clear(contextP, &uri);
+    CU_ASSERT_PTR_NULL(contextP->observedList);
+    CU_ASSERT_EQUAL(contextP->observeTimers.count, 0);
+
+    lwm2m_close(contextP);
+    MEMORY_TRACE_AFTER_EQ;
+}
+
+static void test_observe_index(void)
+{
+    lwm2m_context_t * contextP;
+    lwm2m_server_t server;
+    lwm2m_uri_t uri;
+    lwm2m_watcher_t * resourceP;
+    lwm2m_watcher_t * instanceP;
+    lwm2m_watcher_t * otherP;
+
+    MEMORY_TRACE_BEFORE;
+    memset(&server, 0, sizeof(server));
+    contextP = lwm2m_init(NULL);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(contextP);
+
+    lwm2m_stringToUri("/1024/0/1", 9, &uri);
+    resourceP = prv_observe(contextP, &server, &uri);
+    lwm2m_stringToUri("/1024/0", 7, &uri);
+    instanceP = prv_observe(contextP, &server, &uri);
+    lwm2m_stringToUri("/1024/1/1", 9, &uri);
+    otherP = prv_observe(contextP, &server, &uri);
+    // the levels are shared
+    CU_ASSERT_EQUAL(contextP->observedNodeTable.count, 5);
+    CU_ASSERT_PTR_EQUAL(resourceP->observed->node->parent, instanceP->observed->node);
+
+    // only exact URIs are found
+    lwm2m_stringToUri("/1024", 5, &uri);
+    CU_ASSERT_PTR_NULL(observe_findByUri(contextP, &uri));
+    lwm2m_stringToUri("/1024/0/2", 9, &uri);
+    CU_ASSERT_PTR_NULL(observe_findByUri(contextP, &uri));
+    lwm2m_stringToUri("/1024/0", 7, &uri);
+    CU_ASSERT_PTR_EQUAL(observe_findByUri(contextP, &uri), instanceP->observed);
+
+    // a change marks the URI, its parents and its children
+    lwm2m_resource_value_changed(contextP, &uri);
+    CU_ASSERT(resourceP->update);
+    CU_ASSERT(instanceP->update);
+    CU_ASSERT_FALSE(otherP->update);
+
+    instanceP->update = false;
+    resourceP->update = false;
+    lwm2m_stringToUri("/1024/0/1", 9, &uri);
+    lwm2m_resource_value_changed(contextP, &uri);
+    CU_ASSERT(resourceP->update);
+    CU_ASSERT(instanceP->update);
+    CU_ASSERT_FALSE(otherP->update);
+
+    lwm2m_stringToUri("/1024", 5, &uri);
+    lwm2m_resource_value_changed(contextP, &uri);
+    CU_ASSERT(otherP->update);
+
+    // the unused levels are freed with their observations
+    lwm2m_stringToUri("/1024/1", 7, &uri);
+    observe_clear(contextP, &uri);
+    CU_ASSERT_EQUAL(contextP->observedNodeTable.count, 3);
+
+    lwm2m_close(contextP);
+    MEMORY_TRACE_AFTER_EQ;
+}
+
+static void test_observe_batch(void)
+{
+    lwm2m_context_t * contextP;
+    lwm2m_server_t server;
+    lwm2m_uri_t uri;
+    lwm2m_uri_t changes[3];
+    lwm2m_watcher_t * instanceP;
+    lwm2m_watcher_t * resourceP;
+    time_t timeout;
+    time_t now;
+
+    MEMORY_TRACE_BEFORE;
+    memset(&server, 0, sizeof(server));
+    contextP = lwm2m_init(NULL);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(contextP);
+
+    // nothing observed, nothing to do
+    lwm2m_stringToUri("/1024/0/1", 9, changes);
+    lwm2m_resources_value_changed(contextP, changes, 1);
+
+    lwm2m_stringToUri("/1024/0", 7, &uri);
+    instanceP = prv_observe(contextP, &server, &uri);
+    lwm2m_stringToUri("/1024/1/1", 9, &uri);
+    resourceP = prv_observe(contextP, &server, &uri);
+
+    lwm2m_stringToUri("/1024/0/2", 9, changes + 1);
+    lwm2m_stringToUri("/1024/1/1", 9, changes + 2);
+    lwm2m_resources_value_changed(contextP, changes, 3);
+    CU_ASSERT(instanceP->update);
+    CU_ASSERT(resourceP->update);
+    CU_ASSERT_EQUAL(contextP->observeTimers.count, 2);
+
+    // each watcher is checked once
+    now = utils_gettime();
+    timeout = 60;
+    observe_step(contextP, now, &timeout);
+    CU_ASSERT_EQUAL(instanceP->timer.time, now + 1);
+    CU_ASSERT_EQUAL(resourceP->timer.time, now + 1);
+    CU_ASSERT_EQUAL(timeout, 1);
+
+    // an instance URI marks all its resources
+    instanceP->update = false;
+    resourceP->update = false;
+    lwm2m_stringToUri("/1024/1", 7, changes);
+    lwm2m_resources_value_changed(contextP, changes, 1);
+    CU_ASSERT_FALSE(instanceP->update);
+    CU_ASSERT(resourceP->update);
+
+    lwm2m_close(contextP);
+    MEMORY_TRACE_AFTER_EQ;
+}
+
+static void test_observe_push(void)
+{
+    lwm2m_context_t * contextP;
+    lwm2m_server_t server;
+    lwm2m_uri_t uri;
+    lwm2m_data_t data;
+    lwm2m_watcher_t * watcherP;
+    lwm2m_observed_t * observedP;
+    lwm2m_data_t * valueP;
+    lwm2m_attributes_t * attrP;
+    time_t timeout;
+    time_t now;
+
+    MEMORY_TRACE_BEFORE;
+    memset(&server, 0, sizeof(server));
+    contextP = lwm2m_init(NULL);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(contextP);
+
+    lwm2m_stringToUri("/1024/0/1", 9, &uri);
+    watcherP = prv_observe(contextP, &server, &uri);
+    observedP = watcherP->observed;
+    CU_ASSERT_PTR_NULL(observedP->valueP);
+
+    attrP = (lwm2m_attributes_t *)lwm2m_malloc(sizeof(lwm2m_attributes_t));
+    CU_ASSERT_PTR_NOT_NULL_FATAL(attrP);
+    memset(attrP, 0, sizeof(lwm2m_attributes_t));
+    attrP->toSet = LWM2M_ATTR_FLAG_MIN_PERIOD | LWM2M_ATTR_FLAG_MAX_PERIOD;
+    attrP->maxPeriod = 30;
+    watcherP->parameters = attrP;
+
+    // the given value is notified without reading the object
+    memset(&data, 0, sizeof(data));
+    lwm2m_data_encode_int(43, &data);
+    lwm2m_resource_value_push(contextP, &uri, &data);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(observedP->valueP);
+    CU_ASSERT_EQUAL(observedP->valueP->id, 1);
+    CU_ASSERT_EQUAL(observedP->valueP->value.asInteger, 43);
+    CU_ASSERT(observedP->valueSet);
+    CU_ASSERT(watcherP->update);
+
+    now = utils_gettime();
+    timeout = 60;
+    observe_step(contextP, now, &timeout);
+    CU_ASSERT_FALSE(watcherP->update);
+    CU_ASSERT_EQUAL(watcherP->counter, 2);
+    CU_ASSERT_EQUAL(watcherP->timer.time, now + 30);
+
+    // the given value is checked once, the maximal period reads the object
+    CU_ASSERT_FALSE(observedP->valueSet);
+    CU_ASSERT_PTR_NOT_NULL(observedP->valueP);
+    timeout = 60;
+    observe_step(contextP, now + 30, &timeout);
+    CU_ASSERT_EQUAL(watcherP->counter, 2);
+    CU_ASSERT_EQUAL(watcherP->timer.time, now + 31);
+
+    // numeric values are stored in place, the others are copied
+    valueP = observedP->valueP;
+    lwm2m_data_encode_int(44, &data);
+    lwm2m_resource_value_push(contextP, &uri, &data);
+    CU_ASSERT_PTR_EQUAL(observedP->valueP, valueP);
+    CU_ASSERT_EQUAL(observedP->valueP->value.asInteger, 44);
+
+    lwm2m_data_encode_string("value", &data);
+    lwm2m_resource_value_push(contextP, &uri, &data);
+    CU_ASSERT_EQUAL(observedP->valueP->type, LWM2M_TYPE_STRING);
+    CU_ASSERT_PTR_NOT_EQUAL(observedP->valueP->value.asBuffer.buffer, data.value.asBuffer.buffer);
+    lwm2m_free(data.value.asBuffer.buffer);
+
+    // a change without value is read from the object
+    lwm2m_stringToUri("/1024/0", 7, &uri);
+    lwm2m_resource_value_changed(contextP, &uri);
+    CU_ASSERT_PTR_NULL(observedP->valueP);
+    CU_ASSERT_FALSE(observedP->valueSet);
+
+    lwm2m_stringToUri("/1024/0/1", 9, &uri);
+    lwm2m_data_encode_string("value", &data);
+    lwm2m_resource_value_push(contextP, &uri, &data);
+    lwm2m_free(data.value.asBuffer.buffer);
+    CU_ASSERT_PTR_NOT_NULL(observedP->valueP);
+
+    // the value is freed with the observation
+    lwm2m_close(contextP);
+    MEMORY_TRACE_AFTER_EQ;
+}
+
+#ifdef LWM2M_SUPPORT_SENML_JSON
+#define COMPOSITE_TEST_COUNT 10
+
+// Receives the next notification sent to the connection. Returns false if there is none.
+static bool prv_receive(int sock,
+                        uint8_t * buffer,
+                        size_t size,
+                        coap_packet_t * messageP)
+{
+    ssize_t length;
+
+    length = recv(sock, buffer, size, MSG_DONTWAIT);
+    if (length <= 0) return false;
+    CU_ASSERT_TRUE_FATAL(coap_parse_message(messageP, buffer, (uint16_t)length) == NO_ERROR);
+    coap_free_header(messageP);
+
+    return true;
+}
+
+static void test_observe_composite(void)
+{
+    static const char expected[] = "[{\"bn\":\"/1024/0/1\",\"v\":43},{\"bn\":\"/1024/0/2\",\"v\":43}]";
+    lwm2m_context_t * contextP;
+    lwm2m_server_t server;
+    lwm2m_server_t other;
+    connection_t conn;
+    int sockets[2];
+    uint8_t buffer[LWM2M_SEND_BUFFER_SIZE * 2];
+    coap_packet_t message;
+    lwm2m_uri_t uris[4];
+    lwm2m_watcher_t * watchers[4];
+    lwm2m_uri_t bounded[COMPOSITE_TEST_COUNT];
+    lwm2m_data_t data;
+    uint16_t mid;
+    time_t timeout;
+    size_t records;
+    int count;
+    int i;
+
+    MEMORY_TRACE_BEFORE;
+    CU_ASSERT_TRUE_FATAL(socketpair(AF_UNIX, SOCK_DGRAM, 0, sockets) == 0);
+    memset(&conn, 0, sizeof(conn));
+    conn.sock = sockets[0];
+    memset(&server, 0, sizeof(server));
+    server.sessionH = &conn;
+    memset(&other, 0, sizeof(other));
+    contextP = lwm2m_init(NULL);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(contextP);
+    lwm2m_set_composite_notifications(contextP, true);
+
+    lwm2m_stringToUri("/1024/0/1", 9, uris);
+    lwm2m_stringToUri("/1024/0/2", 9, uris + 1);
+    lwm2m_stringToUri("/1024/1/1", 9, uris + 2);
+    lwm2m_stringToUri("/1024/0/3", 9, uris + 3);
+    watchers[0] = prv_observe(contextP, &server, uris);
+    watchers[1] = prv_observe(contextP, &server, uris + 1);
+    watchers[2] = prv_observe(contextP, &other, uris + 2);
+    watchers[3] = prv_observe(contextP, &server, uris + 3);
+    for (i = 0 ; i < 3 ; i++)
+    {
+        watchers[i]->format = LWM2M_CONTENT_SENML_JSON;
+    }
+    while (prv_receive(sockets[1], buffer, sizeof(buffer), &message));
+
+    memset(&data, 0, sizeof(data));
+    lwm2m_data_encode_int(43, &data);
+    for (i = 0 ; i < 4 ; i++)
+    {
+        lwm2m_resource_value_push(contextP, uris + i, &data);
+    }
+
+    // one message per server, the TLV notification is sent alone
+    mid = contextP->nextMID;
+    timeout = 60;
+    observe_step(contextP, utils_gettime(), &timeout);
+    CU_ASSERT_EQUAL(contextP->nextMID, (uint16_t)(mid + 3));
+    CU_ASSERT_EQUAL(watchers[0]->lastMid, watchers[1]->lastMid);
+    CU_ASSERT_NOT_EQUAL(watchers[0]->lastMid, watchers[2]->lastMid);
+    CU_ASSERT_NOT_EQUAL(watchers[0]->lastMid, watchers[3]->lastMid);
+    for (i = 0 ; i < 4 ; i++)
+    {
+        CU_ASSERT_FALSE(watchers[i]->update);
+        CU_ASSERT_EQUAL(watchers[i]->counter, 2);
+    }
+
+    CU_ASSERT_TRUE_FATAL(prv_receive(sockets[1], buffer, sizeof(buffer), &message));
+    CU_ASSERT_EQUAL(message.mid, watchers[3]->lastMid);
+    CU_ASSERT_EQUAL(message.content_type, LWM2M_CONTENT_TLV);
+
+    // the records of each notification start with the observed URI as base name
+    CU_ASSERT_TRUE_FATAL(prv_receive(sockets[1], buffer, sizeof(buffer), &message));
+    CU_ASSERT_EQUAL(message.mid, watchers[0]->lastMid);
+    CU_ASSERT_EQUAL(message.content_type, LWM2M_CONTENT_SENML_JSON);
+    CU_ASSERT_EQUAL(message.token_len, watchers[0]->tokenLen);
+    CU_ASSERT_EQUAL(message.observe, 1);
+    CU_ASSERT_EQUAL(message.payload_len, sizeof(expected) - 1);
+    CU_ASSERT_NSTRING_EQUAL(message.payload, expected, sizeof(expected) - 1);
+    CU_ASSERT_FALSE(prv_receive(sockets[1], buffer, sizeof(buffer), &message));
+
+    // a single notification is sent alone
+    lwm2m_resource_value_push(contextP, uris, &data);
+    mid = contextP->nextMID;
+    timeout = 60;
+    observe_step(contextP, utils_gettime(), &timeout);
+    CU_ASSERT_EQUAL(contextP->nextMID, (uint16_t)(mid + 1));
+    CU_ASSERT_EQUAL(watchers[0]->counter, 3);
+    CU_ASSERT_EQUAL(watchers[1]->counter, 2);
+    CU_ASSERT_TRUE_FATAL(prv_receive(sockets[1], buffer, sizeof(buffer), &message));
+    CU_ASSERT_NSTRING_EQUAL(message.payload, "[{\"bn\":\"/1024/0/1\",\"v\":43}]", message.payload_len);
+
+    // the messages are flushed before exceeding the send buffer
+    for (i = 0 ; i < COMPOSITE_TEST_COUNT ; i++)
+    {
+        lwm2m_watcher_t * watcherP;
+
+        memset(bounded + i, 0, sizeof(lwm2m_uri_t));
+        bounded[i].objectId = 1024;
+        bounded[i].instanceId = 2;
+        bounded[i].resourceId = (uint16_t)i;
+#ifndef LWM2M_VERSION_1_0
+        bounded[i].resourceInstanceId = LWM2M_MAX_ID;
+#endif
+        watcherP = prv_observe(contextP, &server, bounded + i);
+        watcherP->format = LWM2M_CONTENT_SENML_JSON;
+    }
+    while (prv_receive(sockets[1], buffer, sizeof(buffer), &message));
+    for (i = 0 ; i < COMPOSITE_TEST_COUNT ; i++)
+    {
+        lwm2m_resource_value_push(contextP, bounded + i, &data);
+    }
+    timeout = 60;
+    observe_step(contextP, utils_gettime(), &timeout);
+    count = 0;
+    records = 0;
+    while (prv_receive(sockets[1], buffer, sizeof(buffer), &message))
+    {
+        size_t j;
+
+        CU_ASSERT(message.payload_len <= LWM2M_SEND_BUFFER_SIZE - COAP_MAX_HEADER_SIZE);
+        for (j = 0 ; j < message.payload_len ; j++)
+        {
+            if (message.payload[j] == '{') records++;
+        }
+        count++;
+    }
+    CU_ASSERT(count > 1);
+    CU_ASSERT(count < COMPOSITE_TEST_COUNT);
+    CU_ASSERT_EQUAL(records, COMPOSITE_TEST_COUNT);
+
+    lwm2m_close(contextP);
+    close(sockets[0]);
+    close(sockets[1]);
+    MEMORY_TRACE_AFTER_EQ;
+}
+
+#ifdef LWM2M_SERVER_MODE
+typedef struct
+{
+    int     count;
+    int     status;
+    uint8_t payload[128];
+    size_t  length;
+} notify_record_t;
+
+static void prv_notifyCallback(uint16_t clientID,
+                               lwm2m_uri_t * uriP,
+                               int status,
+                               lwm2m_media_type_t format,
+                               uint8_t * data,
+                               int dataLength,
+                               void * userData)
+{
+    notify_record_t * recordP = (notify_record_t *)userData;
+
+    (void)clientID;
+    (void)uriP;
+    (void)format;
+
+    recordP->count++;
+    recordP->status = status;
+    recordP->length = 0;
+    if (dataLength > 0 && (size_t)dataLength <= sizeof(recordP->payload))
+    {
+        memcpy(recordP->payload, data, dataLength);
+        recordP->length = (size_t)dataLength;
+    }
+}
+
+// Handles the message as sent by the client.
+static void prv_handleMessage(lwm2m_context_t * contextP,
+                              connection_t * connP,
+                              coap_packet_t * messageP)
+{
+    uint8_t buffer[LWM2M_SEND_BUFFER_SIZE];
+    size_t length;
+
+    length = coap_serialize_message(messageP, buffer, sizeof(buffer));
+    CU_ASSERT_TRUE_FATAL(length > 0);
+    lwm2m_handle_packet(contextP, buffer, (int)length, connP);
+}
+
+// Observes the URI and accepts the request as the client.
+static void prv_serverObserve(lwm2m_context_t * contextP,
+                              uint16_t clientID,
+                              connection_t * connP,
+                              int sock,
+                              const char * uriStr,
+                              notify_record_t * recordP,
+                              uint8_t * token)
+{
+    lwm2m_uri_t uri;
+    uint8_t buffer[LWM2M_SEND_BUFFER_SIZE];
+    coap_packet_t request;
+    coap_packet_t response;
+
+    lwm2m_stringToUri(uriStr, strlen(uriStr), &uri);
+    CU_ASSERT_EQUAL(lwm2m_observe(contextP, clientID, &uri, prv_notifyCallback, recordP), 0);
+    CU_ASSERT_TRUE_FATAL(prv_receive(sock, buffer, sizeof(buffer), &request));
+    CU_ASSERT_TRUE_FATAL(request.token_len == 8);
+    memcpy(token, request.token, request.token_len);
+
+    coap_init_message(&response, COAP_TYPE_ACK, COAP_205_CONTENT, request.mid);
+    coap_set_header_token(&response, token, 8);
+    coap_set_header_observe(&response, 1);
+    coap_set_header_content_type(&response, LWM2M_CONTENT_SENML_JSON);
+    prv_handleMessage(contextP, connP, &response);
+    CU_ASSERT_EQUAL(recordP->count, 1);
+    CU_ASSERT_EQUAL(recordP->status, 0);
+}
+
+// Sends a notification of the observation of the token.
+static void prv_serverNotify(lwm2m_context_t * contextP,
+                             connection_t * connP,
+                             uint8_t * token,
+                             const char * payload,
+                             notify_record_t * records,
+                             int count)
+{
+    coap_packet_t message;
+    int i;
+
+    for (i = 0 ; i < count ; i++)
+    {
+        memset(records + i, 0, sizeof(notify_record_t));
+    }
+    coap_init_message(&message, COAP_TYPE_NON, COAP_205_CONTENT, 0x200);
+    coap_set_header_token(&message, token, 8);
+    coap_set_header_observe(&message, 5);
+    coap_set_header_content_type(&message, LWM2M_CONTENT_SENML_JSON);
+    coap_set_payload(&message, payload, strlen(payload));
+    prv_handleMessage(contextP, connP, &message);
+}
+
+static void test_observe_notify_composite(void)
+{
+    static const char instancePack[] = "{\"bn\":\"/3/0/\",\"n\":\"0\",\"vs\":\"a\"},{\"n\":\"1\",\"v\":2}";
+    static const char resourcePack[] = "{\"bn\":\"/3/0/1\",\"v\":3}";
+    static const char otherPack[] = "{\"bn\":\"/4/0/\",\"n\":\"1\",\"v\":4}";
+    lwm2m_context_t * contextP;
+    connection_t conn;
+    int sockets[2];
+    uint8_t buffer[LWM2M_SEND_BUFFER_SIZE];
+    char payload[LWM2M_SEND_BUFFER_SIZE];
+    coap_packet_t message;
+    lwm2m_client_t * clientP;
+    notify_record_t records[2];
+    uint8_t tokens[2][8];
+
+    MEMORY_TRACE_BEFORE;
+    CU_ASSERT_TRUE_FATAL(socketpair(AF_UNIX, SOCK_DGRAM, 0, sockets) == 0);
+    memset(&conn, 0, sizeof(conn));
+    conn.sock = sockets[0];
+    contextP = lwm2m_init(NULL);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(contextP);
+
+    coap_init_message(&message, COAP_TYPE_CON, COAP_POST, 0x100);
+    coap_set_header_uri_path(&message, "/rd");
+    coap_set_header_uri_query(&message, "ep=composite&lwm2m=1.1");
+    coap_set_header_content_type(&message, LWM2M_CONTENT_LINK);
+    coap_set_payload(&message, "</3/0>,</4/0>", 13);
+    prv_handleMessage(contextP, &conn, &message);
+    clientP = contextP->clientList;
+    CU_ASSERT_PTR_NOT_NULL_FATAL(clientP);
+    while (prv_receive(sockets[1], buffer, sizeof(buffer), &message));
+
+    memset(records, 0, sizeof(records));
+    prv_serverObserve(contextP, clientP->internalID, &conn, sockets[1], "/3/0", records, tokens[0]);
+    prv_serverObserve(contextP, clientP->internalID, &conn, sockets[1], "/3/0/1", records + 1, tokens[1]);
+
+    // without the opt-in, the notification goes to the observation of its token
+    snprintf(payload, sizeof(payload), "[%s,%s]", instancePack, resourcePack);
+    prv_serverNotify(contextP, &conn, tokens[0], payload, records, 2);
+    CU_ASSERT_EQUAL(records[0].count, 1);
+    CU_ASSERT_EQUAL(records[0].length, strlen(payload));
+    CU_ASSERT_EQUAL(records[1].count, 0);
+
+    // each observation gets the pack of its URI, the instance does not get the resource records
+    CU_ASSERT_EQUAL(lwm2m_set_client_composite_notifications(contextP, clientP->internalID, true), COAP_NO_ERROR);
+    prv_serverNotify(contextP, &conn, tokens[0], payload, records, 2);
+    CU_ASSERT_EQUAL(records[0].count, 1);
+    CU_ASSERT_EQUAL(records[0].status, 5);
+    CU_ASSERT_EQUAL(records[0].length, strlen(instancePack) + 2);
+    CU_ASSERT_NSTRING_EQUAL(records[0].payload + 1, instancePack, strlen(instancePack));
+    CU_ASSERT_EQUAL(records[1].count, 1);
+    CU_ASSERT_EQUAL(records[1].status, 5);
+    CU_ASSERT_EQUAL(records[1].length, strlen(resourcePack) + 2);
+    CU_ASSERT_NSTRING_EQUAL(records[1].payload + 1, resourcePack, strlen(resourcePack));
+
+    // the pack of an URI without observation is dropped
+    snprintf(payload, sizeof(payload), "[%s,%s]", resourcePack, otherPack);
+    prv_serverNotify(contextP, &conn, tokens[1], payload, records, 2);
+    CU_ASSERT_EQUAL(records[0].count, 0);
+    CU_ASSERT_EQUAL(records[1].count, 1);
+    CU_ASSERT_EQUAL(records[1].length, strlen(resourcePack) + 2);
+
+    // a notification not starting with the pack of its token is not split
+    snprintf(payload, sizeof(payload), "[%s,%s]", resourcePack, instancePack);
+    prv_serverNotify(contextP, &conn, tokens[0], payload, records, 2);
+    CU_ASSERT_EQUAL(records[0].count, 1);
+    CU_ASSERT_EQUAL(records[0].length, strlen(payload));
+    CU_ASSERT_EQUAL(records[1].count, 0);
+
+    CU_ASSERT_EQUAL(lwm2m_set_client_composite_notifications(contextP, clientP->internalID + 1, true), COAP_404_NOT_FOUND);
+
+    lwm2m_close(contextP);
+    close(sockets[0]);
+    close(sockets[1]);
+    MEMORY_TRACE_AFTER_EQ;
+}
+
+static void test_observe_update_cleanup(void)
+{
+    static const char * uris[] = { "/3/0", "/3/1", "/4", "/5/0" };
+    lwm2m_context_t * contextP;
+    connection_t conn;
+    int sockets[2];
+    uint8_t buffer[LWM2M_SEND_BUFFER_SIZE];
+    char path[16];
+    coap_packet_t message;
+    lwm2m_client_t * clientP;
+    lwm2m_observation_t * observationP;
+    notify_record_t records[4];
+    uint8_t token[8];
+    int count;
+    int i;
+
+    MEMORY_TRACE_BEFORE;
+    CU_ASSERT_TRUE_FATAL(socketpair(AF_UNIX, SOCK_DGRAM, 0, sockets) == 0);
+    memset(&conn, 0, sizeof(conn));
+    conn.sock = sockets[0];
+    contextP = lwm2m_init(NULL);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(contextP);
+
+    coap_init_message(&message, COAP_TYPE_CON, COAP_POST, 0x100);
+    coap_set_header_uri_path(&message, "/rd");
+    coap_set_header_uri_query(&message, "ep=update&lwm2m=1.1");
+    coap_set_header_content_type(&message, LWM2M_CONTENT_LINK);
+    coap_set_payload(&message, "</3/0>,</3/1>,</4/0>", 20);
+    prv_handleMessage(contextP, &conn, &message);
+    clientP = contextP->clientList;
+    CU_ASSERT_PTR_NOT_NULL_FATAL(clientP);
+    while (prv_receive(sockets[1], buffer, sizeof(buffer), &message));
+
+    // the object 5 is not registered, its observation is already orphaned
+    memset(records, 0, sizeof(records));
+    for (i = 0 ; i < 4 ; i++)
+    {
+        prv_serverObserve(contextP, clientP->internalID, &conn, sockets[1], uris[i], records + i, token);
+    }
+
+    // the Update removes the instance /3/1
+    snprintf(path, sizeof(path), "/rd/%d", clientP->internalID);
+    coap_init_message(&message, COAP_TYPE_CON, COAP_POST, 0x101);
+    coap_set_header_uri_path(&message, path);
+    coap_set_header_content_type(&message, LWM2M_CONTENT_LINK);
+    coap_set_payload(&message, "</3/0>,</4/0>", 13);
+    prv_handleMessage(contextP, &conn, &message);
+    CU_ASSERT_TRUE_FATAL(prv_receive(sockets[1], buffer, sizeof(buffer), &message));
+    CU_ASSERT_EQUAL(message.code, COAP_204_CHANGED);
+
+    CU_ASSERT_EQUAL(records[0].count, 1);
+    CU_ASSERT_EQUAL(records[1].count, 2);
+    CU_ASSERT_EQUAL(records[1].status, COAP_202_DELETED);
+    CU_ASSERT_EQUAL(records[2].count, 1);
+    CU_ASSERT_EQUAL(records[3].count, 2);
+    CU_ASSERT_EQUAL(records[3].status, COAP_202_DELETED);
+    count = 0;
+    for (observationP = clientP->observationList ; observationP != NULL ; observationP = observationP->next)
+    {
+        count++;
+    }
+    CU_ASSERT_EQUAL(count, 2);
+
+    lwm2m_close(contextP);
+    close(sockets[0]);
+    close(sockets[1]);
+    MEMORY_TRACE_AFTER_EQ;
+}
+#endif
+#endif
+
+static struct TestTable table[] = {
+        { "test of the observation checks scheduling", test_observe_schedule },
+        { "test of the observed URI index", test_observe_index },
+        { "test of lwm2m_resources_value_changed()", test_observe_batch },
+        { "test of lwm2m_resource_value_push()", test_observe_push },
+#ifdef LWM2M_SUPPORT_SENML_JSON
+        { "test of the composite notifications", test_observe_composite },
+#ifdef LWM2M_SERVER_MODE
+        { "test of the split of the composite notifications", test_observe_notify_composite },
+        { "test of the observations removed by an Update", test_observe_update_cleanup },
+#endif
+#endif
+        { NULL, NULL },
+};
+
+CU_ErrorCode create_observe_suit()
+{
+   CU_pSuite pSuite = NULL;
+
+   pSuite = CU_add_suite("Suite_Observe", NULL, NULL);
+   if (NULL == pSuite) {
+      return CU_get_error();
+   }
+
+   return add_tests(pSuite, table);
+}
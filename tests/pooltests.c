@@ -0,0 +1,124 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2026 Eclipse Wakaama contributors and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * The Eclipse Distribution License is available at
+ *    http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Please refer to git log
+ *
+ *******************************************************************************/
+
+#include "tests.h"
+#include "CUnit/Basic.h"
+#include "internals.h"
+#include "memtest.h"
+
+#define POOL_TEST_CAPACITY 4
+
+static void test_pool_reuse(void)
+{
+    lwm2m_pool_t pool;
+    void * items[POOL_TEST_CAPACITY];
+    void * itemP;
+    int i;
+
+    MEMORY_TRACE_BEFORE;
+    pool_init(&pool, 13, POOL_TEST_CAPACITY);
+    CU_ASSERT_PTR_NOT_NULL(pool.storage);
+    CU_ASSERT_EQUAL(pool.itemSize % sizeof(uint64_t), 0);
+
+    for (i = 0 ; i < POOL_TEST_CAPACITY ; i++)
+    {
+        items[i] = pool_alloc(&pool);
+        CU_ASSERT((uint8_t *)items[i] >= pool.storage);
+        CU_ASSERT((uint8_t *)items[i] < pool.storage + POOL_TEST_CAPACITY * pool.itemSize);
+        memset(items[i], 0xFF, 13);
+    }
+    CU_ASSERT_PTR_NULL(pool.freeList);
+
+    // released items are reused first
+    pool_release(&pool, items[2]);
+    itemP = pool_alloc(&pool);
+    CU_ASSERT_PTR_EQUAL(itemP, items[2]);
+
+    for (i = 0 ; i < POOL_TEST_CAPACITY ; i++)
+    {
+        pool_release(&pool, items[i]);
+    }
+
+    pool_free(&pool);
+    MEMORY_TRACE_AFTER_EQ;
+}
+
+static void test_pool_exhausted(void)
+{
+    lwm2m_pool_t pool;
+    void * items[POOL_TEST_CAPACITY];
+    void * itemP;
+    int i;
+
+    MEMORY_TRACE_BEFORE;
+    pool_init(&pool, sizeof(dm_data_t), POOL_TEST_CAPACITY);
+    for (i = 0 ; i < POOL_TEST_CAPACITY ; i++)
+    {
+        items[i] = pool_alloc(&pool);
+    }
+
+    // falls back on the heap
+    itemP = pool_alloc(&pool);
+    CU_ASSERT_PTR_NOT_NULL(itemP);
+    CU_ASSERT((uint8_t *)itemP < pool.storage || (uint8_t *)itemP >= pool.storage + POOL_TEST_CAPACITY * pool.itemSize);
+    pool_release(&pool, itemP);
+    CU_ASSERT_PTR_NULL(pool.freeList);
+
+    for (i = 0 ; i < POOL_TEST_CAPACITY ; i++)
+    {
+        pool_release(&pool, items[i]);
+    }
+    pool_free(&pool);
+    MEMORY_TRACE_AFTER_EQ;
+}
+
+static void test_pool_empty(void)
+{
+    lwm2m_pool_t pool;
+    void * itemP;
+
+    MEMORY_TRACE_BEFORE;
+    pool_init(&pool, sizeof(transaction_item_t), 0);
+    CU_ASSERT_PTR_NULL(pool.storage);
+
+    itemP = pool_alloc(&pool);
+    CU_ASSERT_PTR_NOT_NULL(itemP);
+    pool_release(&pool, itemP);
+    CU_ASSERT_PTR_NULL(pool.freeList);
+
+    pool_free(&pool);
+    MEMORY_TRACE_AFTER_EQ;
+}
+
+static struct TestTable table[] = {
+        { "test of pool_alloc() and pool_release()", test_pool_reuse },
+        { "test of pool_alloc() on exhausted pool", test_pool_exhausted },
+        { "test of pool_alloc() without storage", test_pool_empty },
+        { NULL, NULL },
+};
+
+CU_ErrorCode create_pool_suit()
+{
+   CU_pSuite pSuite = NULL;
+
+   pSuite = CU_add_suite("Suite_Pool", NULL, NULL);
+   if (NULL == pSuite) {
+      return CU_get_error();
+   }
+
+   return add_tests(pSuite, table);
+}
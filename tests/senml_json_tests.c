@@ -30,6 +30,7 @@
 
 #include "tests.h"
 #include "CUnit/Basic.h"
+#include "memtest.h"
 
 #ifdef LWM2M_SUPPORT_SENML_JSON
 
@@ -611,6 +612,63 @@ static void senml_json_test_24(void)
     lwm2m_data_free(1, dataP);
 }
 
+static void senml_json_test_25(void)
+{
+    /* The last record of a resource gives its value */
+    const char * buffer = "[{\"bn\":\"/34/0/2\",\"vs\":\"first\"},{\"bn\":\"/34/0/2\",\"vs\":\"last\"}]";
+    lwm2m_data_t * dataP;
+    lwm2m_uri_t uri;
+    int size;
+
+    MEMORY_TRACE_BEFORE;
+    lwm2m_stringToUri("/34/0/2", 7, &uri);
+    size = lwm2m_data_parse(&uri, (const uint8_t *)buffer, strlen(buffer), LWM2M_CONTENT_SENML_JSON, &dataP);
+    CU_ASSERT_TRUE_FATAL(size == 1);
+    CU_ASSERT_EQUAL(dataP->type, LWM2M_TYPE_STRING);
+    CU_ASSERT_EQUAL(dataP->value.asBuffer.length, 4);
+    CU_ASSERT_NSTRING_EQUAL(dataP->value.asBuffer.buffer, "last", 4);
+    lwm2m_data_free(size, dataP);
+    MEMORY_TRACE_AFTER_EQ;
+}
+
+static void senml_json_test_26(void)
+{
+    /* Packs of records starting with their base name */
+    const char * buffer = "[{\"bn\":\"/3/0/\",\"n\":\"0\",\"vs\":\"a\"}, {\"n\":\"1\",\"v\":2},{\"bn\":\"/3/0/1\",\"v\":3}]";
+    const char * first = "{\"bn\":\"/3/0/\",\"n\":\"0\",\"vs\":\"a\"}, {\"n\":\"1\",\"v\":2}";
+    const char * second = "{\"bn\":\"/3/0/1\",\"v\":3}";
+    const char * noBaseName = "[{\"n\":\"/3/0/1\",\"v\":3}]";
+    const char * badBaseName = "[{\"bn\":\"/3/0/1\",\"v\":3},{\"bn\":\"3\",\"v\":3}]";
+    lwm2m_uri_t uri;
+    size_t index;
+    size_t start;
+    size_t length;
+
+    index = 0;
+    CU_ASSERT_EQUAL(senml_json_nextPack((const uint8_t *)buffer, strlen(buffer), &index, &uri, &start, &length), 1);
+    CU_ASSERT_EQUAL(uri.objectId, 3);
+    CU_ASSERT_EQUAL(uri.instanceId, 0);
+    CU_ASSERT_FALSE(LWM2M_URI_IS_SET_RESOURCE(&uri));
+    CU_ASSERT_EQUAL(length, strlen(first));
+    CU_ASSERT_NSTRING_EQUAL(buffer + start, first, strlen(first));
+
+    CU_ASSERT_EQUAL(senml_json_nextPack((const uint8_t *)buffer, strlen(buffer), &index, &uri, &start, &length), 1);
+    CU_ASSERT_EQUAL(uri.objectId, 3);
+    CU_ASSERT_EQUAL(uri.instanceId, 0);
+    CU_ASSERT_EQUAL(uri.resourceId, 1);
+    CU_ASSERT_EQUAL(length, strlen(second));
+    CU_ASSERT_NSTRING_EQUAL(buffer + start, second, strlen(second));
+
+    CU_ASSERT_EQUAL(senml_json_nextPack((const uint8_t *)buffer, strlen(buffer), &index, &uri, &start, &length), 0);
+
+    index = 0;
+    CU_ASSERT_EQUAL(senml_json_nextPack((const uint8_t *)"[]", 2, &index, &uri, &start, &length), 0);
+    index = 0;
+    CU_ASSERT_EQUAL(senml_json_nextPack((const uint8_t *)noBaseName, strlen(noBaseName), &index, &uri, &start, &length), -1);
+    index = 0;
+    CU_ASSERT_EQUAL(senml_json_nextPack((const uint8_t *)badBaseName, strlen(badBaseName), &index, &uri, &start, &length), -1);
+}
+
 static struct TestTable table[] = {
         { "test of senml_json_test_1()", senml_json_test_1 },
         { "test of senml_json_test_2()", senml_json_test_2 },
@@ -636,6 +694,8 @@ static struct TestTable table[] = {
         { "test of senml_json_test_22()", senml_json_test_22 },
         { "test of senml_json_test_23()", senml_json_test_23 },
         { "test of senml_json_test_24()", senml_json_test_24 },
+        { "test of senml_json_test_25()", senml_json_test_25 },
+        { "test of senml_json_test_26()", senml_json_test_26 },
         { NULL, NULL },
 };
 
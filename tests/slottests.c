@@ -0,0 +1,105 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2026 Eclipse Wakaama contributors and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * The Eclipse Distribution License is available at
+ *    http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Please refer to git log
+ *
+ *******************************************************************************/
+
+
+#include "tests.h"
+#include "CUnit/Basic.h"
+#include "internals.h"
+#include "memtest.h"
+
+#define SLOT_TEST_COUNT 100
+
+static void test_slot_ids(void)
+{
+    lwm2m_slot_table_t table;
+    int items[SLOT_TEST_COUNT];
+    uint16_t id;
+    int i;
+
+    MEMORY_TRACE_BEFORE;
+    memset(&table, 0, sizeof(table));
+
+    for (i = 0 ; i < SLOT_TEST_COUNT ; i++)
+    {
+        CU_ASSERT(slot_add(&table, items + i, &id));
+        CU_ASSERT_EQUAL(id, i);
+    }
+    for (i = 0 ; i < SLOT_TEST_COUNT ; i++)
+    {
+        CU_ASSERT_PTR_EQUAL(slot_find(&table, i), items + i);
+    }
+    CU_ASSERT_PTR_NULL(slot_find(&table, SLOT_TEST_COUNT));
+
+    slot_remove(&table, 10);
+    slot_remove(&table, 20);
+    // removing twice does nothing
+    slot_remove(&table, 20);
+    CU_ASSERT_PTR_NULL(slot_find(&table, 10));
+    CU_ASSERT_PTR_NULL(slot_find(&table, 20));
+
+    // released IDs are given first
+    CU_ASSERT(slot_add(&table, items, &id));
+    CU_ASSERT_EQUAL(id, 20);
+    CU_ASSERT(slot_add(&table, items, &id));
+    CU_ASSERT_EQUAL(id, 10);
+    CU_ASSERT(slot_add(&table, items, &id));
+    CU_ASSERT_EQUAL(id, SLOT_TEST_COUNT);
+
+    slot_free(&table);
+    MEMORY_TRACE_AFTER_EQ;
+}
+
+static void test_slot_full(void)
+{
+    lwm2m_slot_table_t table;
+    uint32_t i;
+    uint16_t id;
+
+    memset(&table, 0, sizeof(table));
+
+    for (i = 0 ; i <= UINT16_MAX ; i++)
+    {
+        if (!slot_add(&table, &table, &id)) break;
+    }
+    CU_ASSERT_EQUAL(i, (uint32_t)UINT16_MAX + 1);
+    CU_ASSERT_EQUAL(id, UINT16_MAX);
+    CU_ASSERT_FALSE(slot_add(&table, &table, &id));
+
+    slot_remove(&table, 1000);
+    CU_ASSERT(slot_add(&table, &table, &id));
+    CU_ASSERT_EQUAL(id, 1000);
+
+    slot_free(&table);
+}
+
+static struct TestTable table[] = {
+        { "test of slot_add() IDs", test_slot_ids },
+        { "test of slot_add() on a full table", test_slot_full },
+        { NULL, NULL },
+};
+
+CU_ErrorCode create_slot_suit()
+{
+   CU_pSuite pSuite = NULL;
+
+   pSuite = CU_add_suite("Suite_Slot", NULL, NULL);
+   if (NULL == pSuite) {
+      return CU_get_error();
+   }
+
+   return add_tests(pSuite, table);
+}
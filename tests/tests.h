@@ -32,6 +32,14 @@ CU_ErrorCode create_object_read_suit();
 CU_ErrorCode create_convert_numbers_suit();
 CU_ErrorCode create_tlv_json_suit();
 CU_ErrorCode create_block1_suit();
+CU_ErrorCode create_coap_suit();
+CU_ErrorCode create_timer_suit();
+CU_ErrorCode create_hash_suit();
+CU_ErrorCode create_pool_suit();
+CU_ErrorCode create_slot_suit();
+CU_ErrorCode create_linkformat_suit();
+CU_ErrorCode create_observe_suit();
+CU_ErrorCode create_transaction_suit();
 #ifdef LWM2M_SUPPORT_SENML_JSON
 CU_ErrorCode create_senml_json_suit();
 #endif
@@ -0,0 +1,108 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2026 Eclipse Wakaama contributors and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * The Eclipse Distribution License is available at
+ *    http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Please refer to git log
+ *
+ *******************************************************************************/
+
+#include "tests.h"
+#include "CUnit/Basic.h"
+#include "internals.h"
+#include "memtest.h"
+
+#define TIMER_TEST_COUNT 50
+
+static void test_timer_order(void)
+{
+    lwm2m_timer_heap_t heap;
+    lwm2m_timer_t timers[TIMER_TEST_COUNT];
+    lwm2m_timer_t * timerP;
+    int64_t last;
+    int i;
+
+    MEMORY_TRACE_BEFORE;
+    memset(&heap, 0, sizeof(heap));
+    memset(timers, 0, sizeof(timers));
+
+    for (i = 0 ; i < TIMER_TEST_COUNT ; i++)
+    {
+        // scattered expiration times
+        CU_ASSERT(timer_schedule(&heap, timers + i, (i * 37) % TIMER_TEST_COUNT, timers + i));
+    }
+    CU_ASSERT_EQUAL(heap.count, TIMER_TEST_COUNT);
+
+    last = -1;
+    while (NULL != (timerP = timer_peek(&heap)))
+    {
+        CU_ASSERT(timerP->time >= last);
+        CU_ASSERT_PTR_EQUAL(timerP->itemP, timerP);
+        last = timerP->time;
+        timer_cancel(&heap, timerP);
+        CU_ASSERT_EQUAL(timerP->index, 0);
+    }
+    CU_ASSERT_EQUAL(last, TIMER_TEST_COUNT - 1);
+
+    timer_free(&heap);
+    MEMORY_TRACE_AFTER_EQ;
+}
+
+static void test_timer_reschedule(void)
+{
+    lwm2m_timer_heap_t heap;
+    lwm2m_timer_t timers[3];
+
+    memset(&heap, 0, sizeof(heap));
+    memset(timers, 0, sizeof(timers));
+
+    CU_ASSERT(timer_schedule(&heap, timers, 10, NULL));
+    CU_ASSERT(timer_schedule(&heap, timers + 1, 20, NULL));
+    CU_ASSERT(timer_schedule(&heap, timers + 2, 30, NULL));
+    CU_ASSERT_PTR_EQUAL(timer_peek(&heap), timers);
+
+    // move the first one at the end
+    CU_ASSERT(timer_schedule(&heap, timers, 40, NULL));
+    CU_ASSERT_EQUAL(heap.count, 3);
+    CU_ASSERT_PTR_EQUAL(timer_peek(&heap), timers + 1);
+
+    // move the last one at the beginning
+    CU_ASSERT(timer_schedule(&heap, timers + 2, 5, NULL));
+    CU_ASSERT_PTR_EQUAL(timer_peek(&heap), timers + 2);
+
+    // cancelling an unscheduled timer does nothing
+    timer_cancel(&heap, timers + 2);
+    timer_cancel(&heap, timers + 2);
+    CU_ASSERT_EQUAL(heap.count, 2);
+    CU_ASSERT_PTR_EQUAL(timer_peek(&heap), timers + 1);
+
+    timer_free(&heap);
+    CU_ASSERT_EQUAL(timers[0].index, 0);
+    CU_ASSERT_EQUAL(timers[1].index, 0);
+}
+
+static struct TestTable table[] = {
+        { "test of timer_peek() order", test_timer_order },
+        { "test of timer_schedule() on scheduled timers", test_timer_reschedule },
+        { NULL, NULL },
+};
+
+CU_ErrorCode create_timer_suit()
+{
+   CU_pSuite pSuite = NULL;
+
+   pSuite = CU_add_suite("Suite_Timer", NULL, NULL);
+   if (NULL == pSuite) {
+      return CU_get_error();
+   }
+
+   return add_tests(pSuite, table);
+}
@@ -0,0 +1,443 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2026 Eclipse Wakaama contributors and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * The Eclipse Distribution License is available at
+ *    http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Please refer to git log
+ *
+ *******************************************************************************/
+
+#include "tests.h"
+#include "CUnit/Basic.h"
+#include "internals.h"
+#include "connection.h"
+#include "memtest.h"
+
+#define TRANSACTION_TEST_COUNT 3
+#define TRANSACTION_QUEUE_COUNT 1000
+
+static int g_callbackCount;
+
+static void prv_transactionCallback(lwm2m_context_t * contextP,
+                                    lwm2m_transaction_t * transacP,
+                                    void * message)
+{
+    (void)contextP;
+    (void)transacP;
+    (void)message;
+
+    g_callbackCount++;
+}
+
+static uintptr_t g_stackLow;
+static uintptr_t g_stackHigh;
+
+// Records the stack depth of the callbacks.
+static void prv_stackCallback(lwm2m_context_t * contextP,
+                              lwm2m_transaction_t * transacP,
+                              void * message)
+{
+    uint8_t marker;
+
+    prv_transactionCallback(contextP, transacP, message);
+    if (g_stackLow == 0 || (uintptr_t)&marker < g_stackLow) g_stackLow = (uintptr_t)&marker;
+    if ((uintptr_t)&marker > g_stackHigh) g_stackHigh = (uintptr_t)&marker;
+}
+
+static lwm2m_transaction_t * prv_startTransaction(lwm2m_context_t * contextP,
+                                                  connection_t * connP,
+                                                  uint16_t mID)
+{
+    lwm2m_transaction_t * transacP;
+
+    transacP = transaction_new(contextP, connP, COAP_GET, NULL, NULL, mID, 4, NULL);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(transacP);
+    transacP->callback = prv_transactionCallback;
+    transaction_add(contextP, transacP);
+    CU_ASSERT_EQUAL(transaction_send(contextP, transacP), 0);
+
+    return transacP;
+}
+
+static void test_transaction_nstart(void)
+{
+    lwm2m_context_t * contextP;
+    connection_t conn;
+    lwm2m_transaction_t * transacP[TRANSACTION_TEST_COUNT];
+    coap_packet_t message;
+    int i;
+
+    MEMORY_TRACE_BEFORE;
+    // the datagrams are dropped by the invalid socket
+    memset(&conn, 0, sizeof(conn));
+    conn.sock = -1;
+    g_callbackCount = 0;
+
+    contextP = lwm2m_init(NULL);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(contextP);
+
+    for (i = 0 ; i < TRANSACTION_TEST_COUNT ; i++)
+    {
+        transacP[i] = prv_startTransaction(contextP, &conn, (uint16_t)(100 + i));
+    }
+    CU_ASSERT_PTR_NOT_NULL_FATAL(contextP->peerList);
+    CU_ASSERT_PTR_NULL(contextP->peerList->next);
+    CU_ASSERT_EQUAL(contextP->peerList->outstanding, 1);
+    CU_ASSERT(transacP[0]->inFlight);
+    CU_ASSERT(transacP[1]->waiting);
+    CU_ASSERT(transacP[2]->waiting);
+    CU_ASSERT_EQUAL(transacP[1]->retrans_counter, 0);
+
+    // an empty ACK frees the slot for the next request
+    coap_init_message(&message, COAP_TYPE_ACK, 0, 100);
+    CU_ASSERT(transaction_handleResponse(contextP, &conn, &message, NULL));
+    CU_ASSERT(transacP[0]->ack_received);
+    CU_ASSERT(transacP[1]->inFlight);
+    CU_ASSERT_NOT_EQUAL(transacP[1]->retrans_counter, 0);
+    CU_ASSERT(transacP[2]->waiting);
+    CU_ASSERT_EQUAL(contextP->peerList->outstanding, 1);
+
+    // the ACK of a waiting request is ignored
+    coap_init_message(&message, COAP_TYPE_ACK, 0, 102);
+    CU_ASSERT_FALSE(transaction_handleResponse(contextP, &conn, &message, NULL));
+
+    // a reset ends the request in flight
+    coap_init_message(&message, COAP_TYPE_RST, 0, 101);
+    CU_ASSERT(transaction_handleResponse(contextP, &conn, &message, NULL));
+    CU_ASSERT_EQUAL(g_callbackCount, 1);
+    CU_ASSERT(transacP[2]->inFlight);
+    CU_ASSERT_FALSE(transacP[2]->waiting);
+
+    lwm2m_close(contextP);
+    MEMORY_TRACE_AFTER_EQ;
+}
+
+static void test_transaction_queue_drain(void)
+{
+    lwm2m_context_t * contextP;
+    connection_t conn;
+    lwm2m_transaction_t * transacP;
+    coap_packet_t message;
+    int i;
+
+    MEMORY_TRACE_BEFORE;
+    memset(&conn, 0, sizeof(conn));
+    conn.sock = -1;
+    g_callbackCount = 0;
+
+    contextP = lwm2m_init(NULL);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(contextP);
+
+    for (i = 0 ; i < TRANSACTION_QUEUE_COUNT ; i++)
+    {
+        (void)prv_startTransaction(contextP, &conn, (uint16_t)(100 + i));
+    }
+    CU_ASSERT_PTR_NOT_NULL_FATAL(contextP->peerList);
+
+    // all the waiting transactions end as soon as they are started
+    for (transacP = contextP->peerList->waitingList ; transacP != NULL ; transacP = transacP->next)
+    {
+        transacP->ack_received = true;
+        transacP->callback = prv_stackCallback;
+    }
+    g_stackLow = 0;
+    g_stackHigh = 0;
+
+    // they are removed one after the other without nesting the calls
+    coap_init_message(&message, COAP_TYPE_RST, 0, 100);
+    CU_ASSERT(transaction_handleResponse(contextP, &conn, &message, NULL));
+    CU_ASSERT_EQUAL(g_callbackCount, TRANSACTION_QUEUE_COUNT);
+    CU_ASSERT(g_stackHigh - g_stackLow < 1024);
+    CU_ASSERT_EQUAL(contextP->transactionMidTable.count, 0);
+    // the unused peer is released
+    CU_ASSERT_PTR_NULL(contextP->peerList);
+
+    lwm2m_close(contextP);
+    MEMORY_TRACE_AFTER_EQ;
+}
+
+static void test_transaction_peers(void)
+{
+    lwm2m_context_t * contextP;
+    connection_t conn[2];
+    lwm2m_transaction_t * transacP[2];
+    coap_packet_t message;
+
+    MEMORY_TRACE_BEFORE;
+    memset(conn, 0, sizeof(conn));
+    conn[0].sock = -1;
+    conn[1].sock = -1;
+    g_callbackCount = 0;
+
+    contextP = lwm2m_init(NULL);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(contextP);
+
+    // the peers do not share their slots
+    transacP[0] = prv_startTransaction(contextP, conn, 200);
+    transacP[1] = prv_startTransaction(contextP, conn + 1, 201);
+    CU_ASSERT(transacP[0]->inFlight);
+    CU_ASSERT(transacP[1]->inFlight);
+    CU_ASSERT_PTR_NOT_EQUAL(transacP[0]->peerP, transacP[1]->peerP);
+    CU_ASSERT_EQUAL(contextP->peerSessionTable.count, 2);
+
+    // the same MID from another peer does not match
+    coap_init_message(&message, COAP_TYPE_RST, 0, 200);
+    CU_ASSERT_FALSE(transaction_handleResponse(contextP, conn + 1, &message, NULL));
+
+    // the peer is released with its last transaction
+    CU_ASSERT(transaction_handleResponse(contextP, conn, &message, NULL));
+    CU_ASSERT_EQUAL(g_callbackCount, 1);
+    CU_ASSERT_PTR_EQUAL(contextP->peerList, transacP[1]->peerP);
+    CU_ASSERT_PTR_NULL(contextP->peerList->next);
+    CU_ASSERT_EQUAL(contextP->peerSessionTable.count, 1);
+
+    // a new transaction to a known session reuses its peer
+    transacP[0] = prv_startTransaction(contextP, conn + 1, 202);
+    CU_ASSERT_PTR_EQUAL(transacP[0]->peerP, transacP[1]->peerP);
+    CU_ASSERT(transacP[0]->waiting);
+
+    lwm2m_close(contextP);
+    MEMORY_TRACE_AFTER_EQ;
+}
+
+static void test_transaction_cocoa(void)
+{
+    lwm2m_context_t * contextP;
+    connection_t conn;
+    lwm2m_transaction_t * transacP;
+    lwm2m_peer_t * peerP;
+    coap_packet_t message;
+    uint32_t timeout;
+
+    MEMORY_TRACE_BEFORE;
+    memset(&conn, 0, sizeof(conn));
+    conn.sock = -1;
+
+    contextP = lwm2m_init(NULL);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(contextP);
+    lwm2m_set_rto_mode(contextP, LWM2M_RTO_COCOA);
+
+    transacP = prv_startTransaction(contextP, &conn, 300);
+    peerP = transacP->peerP;
+    CU_ASSERT_EQUAL(peerP->rto, COAP_RESPONSE_TIMEOUT * 1000);
+    CU_ASSERT(transacP->retrans_timeout >= peerP->rto);
+    CU_ASSERT(transacP->retrans_timeout <= peerP->rto * COAP_ACK_RANDOM_FACTOR);
+
+    // ACK received 5 s after the first transmission:
+    // strong RTO = 5000 + 4 * 2500, overall RTO = (15000 + 2000) / 2
+    transacP->send_time -= 5000;
+    coap_init_message(&message, COAP_TYPE_ACK, COAP_205_CONTENT, 300);
+    coap_set_header_token(&message, ((coap_packet_t *)transacP->message)->token, ((coap_packet_t *)transacP->message)->token_len);
+    CU_ASSERT(transaction_handleResponse(contextP, &conn, &message, NULL));
+    CU_ASSERT(peerP->rto >= 8500);
+    CU_ASSERT(peerP->rto < 8600);
+    CU_ASSERT_EQUAL(peerP->strongRtt.srtt / 100, 50);
+
+    // the idle peer keeps its estimation
+    CU_ASSERT_PTR_EQUAL(contextP->peerList, peerP);
+    transacP = prv_startTransaction(contextP, &conn, 301);
+    CU_ASSERT_PTR_EQUAL(transacP->peerP, peerP);
+    CU_ASSERT(transacP->retrans_timeout >= peerP->rto);
+
+    // an estimation updated during the exchange does not change its back-off factor
+    peerP->rto = 500;
+    timeout = transacP->retrans_timeout;
+    CU_ASSERT_EQUAL(transaction_send(contextP, transacP), 0);
+    CU_ASSERT_EQUAL(transacP->retrans_timeout, timeout + timeout / 2);
+
+    lwm2m_close(contextP);
+    MEMORY_TRACE_AFTER_EQ;
+}
+
+static void test_transaction_response_cache(void)
+{
+    lwm2m_context_t * contextP;
+    connection_t conn[2];
+    uint8_t response[] = { 0x60, 0x45, 0x01, 0x90 };
+    uint8_t * bufferP;
+    size_t length;
+    uint16_t i;
+
+    MEMORY_TRACE_BEFORE;
+    memset(conn, 0, sizeof(conn));
+    conn[0].sock = -1;
+    conn[1].sock = -1;
+
+    contextP = lwm2m_init(NULL);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(contextP);
+
+    // the peer is created for its responses and kept without transaction
+    transaction_cacheResponse(contextP, conn, 400, response, sizeof(response));
+    CU_ASSERT_PTR_NOT_NULL_FATAL(contextP->peerList);
+    CU_ASSERT_PTR_NOT_NULL(timer_peek(&contextP->peerTimers));
+
+    CU_ASSERT(transaction_findResponse(contextP, conn, 400, &bufferP, &length));
+    CU_ASSERT_EQUAL(length, sizeof(response));
+    CU_ASSERT_EQUAL(memcmp(bufferP, response, sizeof(response)), 0);
+    CU_ASSERT_FALSE(transaction_findResponse(contextP, conn, 401, &bufferP, &length));
+    CU_ASSERT_FALSE(transaction_findResponse(contextP, conn + 1, 400, &bufferP, &length));
+
+    // the oldest responses are replaced
+    for (i = 1 ; i <= LWM2M_RESPONSE_CACHE_SIZE ; i++)
+    {
+        transaction_cacheResponse(contextP, conn, (uint16_t)(400 + i), response, sizeof(response));
+    }
+    CU_ASSERT_FALSE(transaction_findResponse(contextP, conn, 400, &bufferP, &length));
+    CU_ASSERT(transaction_findResponse(contextP, conn, 400 + LWM2M_RESPONSE_CACHE_SIZE, &bufferP, &length));
+
+    // a transaction to the peer keeps the responses
+    (void)prv_startTransaction(contextP, conn, 500);
+    CU_ASSERT_PTR_NULL(contextP->peerList->next);
+    CU_ASSERT_PTR_NULL(timer_peek(&contextP->peerTimers));
+    CU_ASSERT(transaction_findResponse(contextP, conn, 401, &bufferP, &length));
+
+    lwm2m_close(contextP);
+    MEMORY_TRACE_AFTER_EQ;
+}
+
+static void test_transaction_duplicate_request(void)
+{
+    lwm2m_context_t * contextP;
+    connection_t conn;
+    // CON GET /x, answered with a 4.00 Bad Request
+    uint8_t request[] = { 0x40, 0x01, 0x02, 0x58, 0xB1, 'x' };
+    uint8_t * bufferP;
+    size_t length;
+
+    MEMORY_TRACE_BEFORE;
+    memset(&conn, 0, sizeof(conn));
+    conn.sock = -1;
+
+    contextP = lwm2m_init(NULL);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(contextP);
+
+    lwm2m_handle_packet(contextP, request, sizeof(request), &conn);
+    CU_ASSERT_TRUE_FATAL(transaction_findResponse(contextP, &conn, 0x0258, &bufferP, &length));
+    CU_ASSERT_EQUAL(length, 4);
+    CU_ASSERT_EQUAL(bufferP[1], COAP_400_BAD_REQUEST);
+    // piggybacked response with the MID of the request
+    CU_ASSERT_EQUAL(bufferP[0] & 0x30, COAP_TYPE_ACK << 4);
+    CU_ASSERT_EQUAL(bufferP[2], 0x02);
+    CU_ASSERT_EQUAL(bufferP[3], 0x58);
+
+    // the duplicate is answered from the cache
+    lwm2m_handle_packet(contextP, request, sizeof(request), &conn);
+    CU_ASSERT_PTR_NULL(contextP->peerList->next);
+    CU_ASSERT_EQUAL(contextP->peerList->responseNext, 1);
+
+    lwm2m_close(contextP);
+    MEMORY_TRACE_AFTER_EQ;
+}
+
+#ifdef LWM2M_SERVER_MODE
+// Handles a registration request sent from the session.
+static void prv_registrationRequest(lwm2m_context_t * contextP,
+                                    connection_t * connP,
+                                    coap_method_t method,
+                                    const char * path,
+                                    const char * query,
+                                    uint16_t mID)
+{
+    coap_packet_t message;
+    uint8_t buffer[LWM2M_SEND_BUFFER_SIZE];
+    size_t length;
+
+    coap_init_message(&message, COAP_TYPE_CON, method, mID);
+    coap_set_header_uri_path(&message, path);
+    if (query != NULL)
+    {
+        coap_set_header_uri_query(&message, query);
+        coap_set_header_content_type(&message, LWM2M_CONTENT_LINK);
+        coap_set_payload(&message, "</3/0>", 6);
+    }
+    length = coap_serialize_message(&message, buffer, sizeof(buffer));
+    CU_ASSERT_TRUE_FATAL(length > 0);
+    lwm2m_handle_packet(contextP, buffer, (int)length, connP);
+}
+
+static void test_transaction_client_sessions(void)
+{
+    lwm2m_context_t * contextP;
+    connection_t conn[TRANSACTION_TEST_COUNT + 1];
+    lwm2m_client_t * clientP;
+    char query[32];
+    char path[16];
+    int i;
+
+    MEMORY_TRACE_BEFORE;
+    memset(conn, 0, sizeof(conn));
+    for (i = 0 ; i <= TRANSACTION_TEST_COUNT ; i++)
+    {
+        conn[i].sock = -1;
+    }
+
+    contextP = lwm2m_init(NULL);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(contextP);
+
+    for (i = 0 ; i < TRANSACTION_TEST_COUNT ; i++)
+    {
+        snprintf(query, sizeof(query), "ep=session%d&lwm2m=1.1", i);
+        prv_registrationRequest(contextP, conn + i, COAP_POST, "/rd", query, (uint16_t)(600 + i));
+    }
+    CU_ASSERT_EQUAL(contextP->clientSessionTable.count, TRANSACTION_TEST_COUNT);
+    for (i = 0 ; i < TRANSACTION_TEST_COUNT ; i++)
+    {
+        clientP = lwm2m_get_client_by_session(contextP, conn + i);
+        CU_ASSERT_PTR_NOT_NULL_FATAL(clientP);
+        CU_ASSERT_PTR_EQUAL(clientP->sessionH, conn + i);
+        snprintf(query, sizeof(query), "session%d", i);
+        CU_ASSERT_NSTRING_EQUAL(clientP->name, query, strlen(query) + 1);
+    }
+    CU_ASSERT_PTR_NULL(lwm2m_get_client_by_session(contextP, conn + TRANSACTION_TEST_COUNT));
+
+    // an Update from a new session moves the client
+    clientP = lwm2m_get_client_by_session(contextP, conn);
+    snprintf(path, sizeof(path), "/rd/%d", clientP->internalID);
+    prv_registrationRequest(contextP, conn + TRANSACTION_TEST_COUNT, COAP_POST, path, NULL, 610);
+    CU_ASSERT_PTR_NULL(lwm2m_get_client_by_session(contextP, conn));
+    CU_ASSERT_PTR_EQUAL(lwm2m_get_client_by_session(contextP, conn + TRANSACTION_TEST_COUNT), clientP);
+
+    // a deregistered client is no longer found
+    clientP = lwm2m_get_client_by_session(contextP, conn + 1);
+    snprintf(path, sizeof(path), "/rd/%d", clientP->internalID);
+    prv_registrationRequest(contextP, conn + 1, COAP_DELETE, path, NULL, 611);
+    CU_ASSERT_PTR_NULL(lwm2m_get_client_by_session(contextP, conn + 1));
+    CU_ASSERT_EQUAL(contextP->clientSessionTable.count, TRANSACTION_TEST_COUNT - 1);
+
+    lwm2m_close(contextP);
+    MEMORY_TRACE_AFTER_EQ;
+}
+#endif
+
+static struct TestTable table[] = {
+        { "test of the NSTART limit", test_transaction_nstart },
+        { "test of the removal of the waiting transactions", test_transaction_queue_drain },
+        { "test of the transactions of several peers", test_transaction_peers },
+        { "test of the CoCoA retransmission timeout", test_transaction_cocoa },
+        { "test of the response cache", test_transaction_response_cache },
+        { "test of the duplicate requests", test_transaction_duplicate_request },
+#ifdef LWM2M_SERVER_MODE
+        { "test of the clients of several sessions", test_transaction_client_sessions },
+#endif
+        { NULL, NULL },
+};
+
+CU_ErrorCode create_transaction_suit()
+{
+   CU_pSuite pSuite = NULL;
+
+   pSuite = CU_add_suite("Suite_Transaction", NULL, NULL);
+   if (NULL == pSuite) {
+      return CU_get_error();
+   }
+
+   return add_tests(pSuite, table);
+}
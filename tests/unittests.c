@@ -60,15 +60,39 @@ int main()
    if (CUE_SUCCESS != create_block1_suit())
       goto exit;
 
+   if (CUE_SUCCESS != create_coap_suit())
+      goto exit;
+
    if (CUE_SUCCESS != create_convert_numbers_suit())
       goto exit;
 
+   if (CUE_SUCCESS != create_hash_suit())
+      goto exit;
+
    if (CUE_SUCCESS != create_tlv_json_suit())
       goto exit;
 
+   if (CUE_SUCCESS != create_pool_suit())
+      goto exit;
+
+   if (CUE_SUCCESS != create_slot_suit())
+      goto exit;
+
+   if (CUE_SUCCESS != create_linkformat_suit())
+      goto exit;
+
+   if (CUE_SUCCESS != create_observe_suit())
+      goto exit;
+
+   if (CUE_SUCCESS != create_timer_suit())
+      goto exit;
+
    if (CUE_SUCCESS != create_tlv_suit())
       goto exit;
 
+   if (CUE_SUCCESS != create_transaction_suit())
+      goto exit;
+
    if (CUE_SUCCESS != create_uri_suit())
       goto exit;
 